@@ -0,0 +1,263 @@
+//
+//  BatchForwardKinematics.h
+//  VideoAndOSCLab
+//
+//  Forward kinematics for many skeletons w/the same bones at once, eg. every dancer on the floor. Same math as
+//  ForwardKinematicsSolver but laid out as structure-of-arrays -- for each joint, one array per value w/one slot per
+//  skeleton -- so a whole row of skeletons is transformed w/each instruction: AVX (8 skeletons), SSE (4) or plain floats,
+//  whichever the build targets. sin & cos are taken w/the standard library first, then everything else is vectorized.
+//
+
+#ifndef BatchForwardKinematics_h
+#define BatchForwardKinematics_h
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace CRCPMotionAnalysis {
+
+//a row of floats, one per skeleton -- the widest the build has, & the plain one for comparison
+class FKLanesScalar
+{
+public:
+    static const int width = 1;
+    float v;
+    static FKLanesScalar load(const float *p) { FKLanesScalar l; l.v = *p; return l; };
+    static FKLanesScalar set(float f) { FKLanesScalar l; l.v = f; return l; };
+    void store(float *p) const { *p = v; };
+    FKLanesScalar operator+(const FKLanesScalar &b) const { return set(v + b.v); };
+    FKLanesScalar operator-(const FKLanesScalar &b) const { return set(v - b.v); };
+    FKLanesScalar operator*(const FKLanesScalar &b) const { return set(v * b.v); };
+};
+
+#if defined(__AVX__)
+class FKLanes
+{
+public:
+    static const int width = 8;
+    __m256 v;
+    static FKLanes load(const float *p) { FKLanes l; l.v = _mm256_loadu_ps(p); return l; };
+    static FKLanes set(float f) { FKLanes l; l.v = _mm256_set1_ps(f); return l; };
+    void store(float *p) const { _mm256_storeu_ps(p, v); };
+    FKLanes operator+(const FKLanes &b) const { FKLanes l; l.v = _mm256_add_ps(v, b.v); return l; };
+    FKLanes operator-(const FKLanes &b) const { FKLanes l; l.v = _mm256_sub_ps(v, b.v); return l; };
+    FKLanes operator*(const FKLanes &b) const { FKLanes l; l.v = _mm256_mul_ps(v, b.v); return l; };
+};
+#define BATCHFK_INSTRUCTIONS "AVX"
+#elif defined(__SSE2__)
+class FKLanes
+{
+public:
+    static const int width = 4;
+    __m128 v;
+    static FKLanes load(const float *p) { FKLanes l; l.v = _mm_loadu_ps(p); return l; };
+    static FKLanes set(float f) { FKLanes l; l.v = _mm_set1_ps(f); return l; };
+    void store(float *p) const { _mm_storeu_ps(p, v); };
+    FKLanes operator+(const FKLanes &b) const { FKLanes l; l.v = _mm_add_ps(v, b.v); return l; };
+    FKLanes operator-(const FKLanes &b) const { FKLanes l; l.v = _mm_sub_ps(v, b.v); return l; };
+    FKLanes operator*(const FKLanes &b) const { FKLanes l; l.v = _mm_mul_ps(v, b.v); return l; };
+};
+#define BATCHFK_INSTRUCTIONS "SSE"
+#else
+typedef FKLanesScalar FKLanes;
+#define BATCHFK_INSTRUCTIONS "scalar"
+#endif
+
+#define BATCHFK_MAX_WIDTH 8 //skeleton slots are padded to this, so any of the lanes fit
+
+class BatchForwardKinematics
+{
+protected:
+    //the bones, shared by all the skeletons -- from a ForwardKinematicsSolver
+    class Joint
+    {
+    public:
+        int parent;
+        bool rotates;
+        float offset[3];
+        float boneEnd[3];
+    };
+    std::vector<Joint> joints; //in solve order, parents first
+    std::vector<int> solveIndex; //the solver's joint index -> ours
+    RigidTransform base;
+
+    int skeletonCount;
+    int stride; //skeletonCount, padded
+
+    //[joint][value][skeleton]
+    std::vector<float> angles; //3 values, degrees
+    std::vector<float> trig; //6: cos x, sin x, cos y, sin y, cos z, sin z
+    std::vector<float> world; //12: r row by row, then t
+    std::vector<float> ends; //3: where each bone ends -- the anchors are the world t
+
+    inline float *row(std::vector<float> &table, int values, int joint, int value)
+    {
+        return &table[ (joint*values + value) * stride ];
+    };
+
+    //sin & cos of every angle -- the vectorized part uses these
+    void takeTrig()
+    {
+        const float toRadians = M_PI / 180.0;
+        for(int j=0; j<joints.size(); j++)
+        {
+            if( !joints[j].rotates ) continue;
+            for(int a=0; a<3; a++)
+            {
+                float *deg = row(angles, 3, j, a);
+                float *c = row(trig, 6, j, a*2);
+                float *s = row(trig, 6, j, a*2+1);
+                for(int k=0; k<skeletonCount; k++)
+                {
+                    c[k] = cos(deg[k] * toRadians);
+                    s[k] = sin(deg[k] * toRadians);
+                }
+            }
+        }
+    };
+
+    //world = parent's world * (translate by the offset, rotate x, y, then z) -- see RigidTransform::rotationXYZ()
+    template<typename L>
+    void solveJoints()
+    {
+        int count = ( (skeletonCount + L::width - 1) / L::width ) * L::width;
+        for(int j=0; j<joints.size(); j++)
+        {
+            const Joint &joint = joints[j];
+            float *w = row(world, 12, j, 0);
+            float *e = row(ends, 3, j, 0);
+            const float *pw = joint.parent < 0 ? NULL : row(world, 12, joint.parent, 0);
+            const float *tr = row(trig, 6, j, 0);
+            L ox = L::set(joint.offset[0]), oy = L::set(joint.offset[1]), oz = L::set(joint.offset[2]);
+            L ex = L::set(joint.boneEnd[0]), ey = L::set(joint.boneEnd[1]), ez = L::set(joint.boneEnd[2]);
+
+            for(int k=0; k<count; k+=L::width)
+            {
+                L p[12]; //the parent's world
+                for(int v=0; v<12; v++)
+                    p[v] = pw == NULL ? L::set(v < 9 ? base.r[v/3][v%3] : base.t[v-9]) : L::load(pw + v*stride + k);
+
+                L r[9];
+                if( joint.rotates )
+                {
+                    L cx = L::load(tr + k), sx = L::load(tr + stride + k);
+                    L cy = L::load(tr + 2*stride + k), sy = L::load(tr + 3*stride + k);
+                    L cz = L::load(tr + 4*stride + k), sz = L::load(tr + 5*stride + k);
+                    L sxsy = sx*sy, cxsy = cx*sy;
+                    r[0] = cy*cz;               r[1] = L::set(0) - cy*sz;     r[2] = sy;
+                    r[3] = sxsy*cz + cx*sz;     r[4] = cx*cz - sxsy*sz;       r[5] = L::set(0) - sx*cy;
+                    r[6] = sx*sz - cxsy*cz;     r[7] = cxsy*sz + sx*cz;       r[8] = cx*cy;
+                }
+                else
+                {
+                    for(int v=0; v<9; v++) r[v] = L::set(v % 4 == 0 ? 1.0f : 0.0f);
+                }
+
+                //rotation: parent r * local r
+                L wr[9];
+                for(int a=0; a<3; a++)
+                {
+                    for(int b=0; b<3; b++)
+                    {
+                        wr[a*3+b] = p[a*3]*r[b] + p[a*3+1]*r[3+b] + p[a*3+2]*r[6+b];
+                        wr[a*3+b].store(w + (a*3+b)*stride + k);
+                    }
+                }
+
+                //translation: parent r * offset + parent t. Then the end of the bone: world r * boneEnd + world t
+                for(int a=0; a<3; a++)
+                {
+                    L t = p[a*3]*ox + p[a*3+1]*oy + p[a*3+2]*oz + p[9+a];
+                    t.store(w + (9+a)*stride + k);
+                    (wr[a*3]*ex + wr[a*3+1]*ey + wr[a*3+2]*ez + t).store(e + a*stride + k);
+                }
+            }
+        }
+    };
+
+public:
+    //count skeletons shaped like skeleton -- its angles aren't used
+    BatchForwardKinematics(ForwardKinematicsSolver &skeleton, int count)
+    {
+        skeletonCount = count;
+        stride = ( (count + BATCHFK_MAX_WIDTH - 1) / BATCHFK_MAX_WIDTH ) * BATCHFK_MAX_WIDTH;
+        base = skeleton.getBase();
+
+        const std::vector<int> &order = skeleton.getSolveOrder();
+        solveIndex.resize(skeleton.getJointCount(), -1);
+        for(int i=0; i<order.size(); i++)
+            solveIndex[order[i]] = i;
+
+        for(int i=0; i<order.size(); i++)
+        {
+            const SkeletonJoint &sj = skeleton.getJoint(order[i]);
+            Joint joint;
+            joint.parent = sj.parent < 0 ? -1 : solveIndex[sj.parent];
+            joint.rotates = sj.rotates;
+            for(int a=0; a<3; a++)
+            {
+                joint.offset[a] = sj.offset[a];
+                joint.boneEnd[a] = sj.boneEnd[a];
+            }
+            joints.push_back(joint);
+        }
+
+        angles.resize(joints.size() * 3 * stride, 0.0f);
+        trig.resize(joints.size() * 6 * stride, 0.0f);
+        world.resize(joints.size() * 12 * stride, 0.0f);
+        ends.resize(joints.size() * 3 * stride, 0.0f);
+        for(int j=0; j<joints.size(); j++)
+        {
+            for(int k=0; k<stride; k++)
+                row(trig, 6, j, 0)[k] = row(trig, 6, j, 2)[k] = row(trig, 6, j, 4)[k] = 1.0f; //cos 0
+        }
+    };
+
+    static const char *getInstructionSet()
+    {
+        return BATCHFK_INSTRUCTIONS;
+    };
+
+    int getSkeletonCount() { return skeletonCount; };
+    int getJointCount() { return joints.size(); };
+
+    //joint is the index in the ForwardKinematicsSolver this was made from
+    void setAngles(int skeleton, int joint, const ci::vec3 &degrees)
+    {
+        int j = solveIndex[joint];
+        row(angles, 3, j, 0)[skeleton] = degrees.x;
+        row(angles, 3, j, 1)[skeleton] = degrees.y;
+        row(angles, 3, j, 2)[skeleton] = degrees.z;
+    };
+
+    //all the skeletons, w/the widest lanes the build has
+    void solve()
+    {
+        takeTrig();
+        solveJoints<FKLanes>();
+    };
+
+    //same, one skeleton at a time -- for comparing
+    void solveScalar()
+    {
+        takeTrig();
+        solveJoints<FKLanesScalar>();
+    };
+
+    ci::vec3 getAnchorPos(int skeleton, int joint)
+    {
+        int j = solveIndex[joint];
+        return ci::vec3(row(world, 12, j, 9)[skeleton], row(world, 12, j, 10)[skeleton], row(world, 12, j, 11)[skeleton]);
+    };
+
+    ci::vec3 getEndPoint(int skeleton, int joint)
+    {
+        int j = solveIndex[joint];
+        return ci::vec3(row(ends, 3, j, 0)[skeleton], row(ends, 3, j, 1)[skeleton], row(ends, 3, j, 2)[skeleton]);
+    };
+};
+
+};
+
+#endif /* BatchForwardKinematics_h */
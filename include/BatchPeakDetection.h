@@ -0,0 +1,322 @@
+//
+//  BatchPeakDetection.h
+//  VideoAndOSCLab
+//
+//  The peak detection FindPeaks does, for every bone of every dancer at once. Each bone (a channel) gets its
+//  derivative's new samples added a row at a time, & the rows are laid out as structure-of-arrays -- for each row &
+//  axis, one float per channel -- so detect() runs the + to - test (see PeakStream), the thresholds from setThreshes()
+//  & the PeakTimer wait between peaks across a row of channels w/each instruction: compares that make masks, & the
+//  masks picking what's kept. AVX (8 channels), SSE (4) or plain floats, whichever the build targets, like
+//  BatchForwardKinematics.
+//
+//  Each channel gets FindPeaks' onsets: every row is looked at, & the wait between peaks goes by the samples' times.
+//  Those are kept as doubles, like PeakEvent::time -- the lanes get them as floats from the frame's first sample, so
+//  they don't lose precision as the session goes on. Adding the samples while the derivative's buffer is still filling
+//  (< MIN_PEAK_WINDOW) is left to the caller, as FindPeaks skips those. FindPeaks' predictive mode isn't batched.
+//
+//  Only PeakDetectionBenchmark (Benchmarks.h) uses it for now -- the pipeline's body parts each have their own FindPeaks,
+//  which is what the onsets, the retractions & the latency traces come from.
+//
+
+#ifndef BatchPeakDetection_h
+#define BatchPeakDetection_h
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace CRCPMotionAnalysis {
+
+//a row of floats, one per channel -- a mask has all the bits of a lane set or none
+class PeakLanesScalar
+{
+protected:
+    static uint32_t bits(float f) { uint32_t b; memcpy(&b, &f, 4); return b; };
+    static PeakLanesScalar fromBits(uint32_t b) { PeakLanesScalar l; memcpy(&l.v, &b, 4); return l; };
+    static PeakLanesScalar mask(bool b) { return fromBits( b ? 0xFFFFFFFF : 0 ); };
+public:
+    static const int width = 1;
+    float v;
+    static PeakLanesScalar load(const float *p) { PeakLanesScalar l; l.v = *p; return l; };
+    static PeakLanesScalar set(float f) { PeakLanesScalar l; l.v = f; return l; };
+    void store(float *p) const { *p = v; };
+    PeakLanesScalar operator+(const PeakLanesScalar &b) const { return set(v + b.v); };
+    PeakLanesScalar operator-(const PeakLanesScalar &b) const { return set(v - b.v); };
+    PeakLanesScalar operator/(const PeakLanesScalar &b) const { return set(v / b.v); };
+    PeakLanesScalar operator<(const PeakLanesScalar &b) const { return mask(v < b.v); };
+    PeakLanesScalar operator>(const PeakLanesScalar &b) const { return mask(v > b.v); };
+    PeakLanesScalar operator!=(const PeakLanesScalar &b) const { return mask(v != b.v); };
+    PeakLanesScalar operator&(const PeakLanesScalar &b) const { return fromBits( bits(v) & bits(b.v) ); };
+    PeakLanesScalar operator|(const PeakLanesScalar &b) const { return fromBits( bits(v) | bits(b.v) ); };
+    static PeakLanesScalar max(const PeakLanesScalar &a, const PeakLanesScalar &b) { return set( a.v > b.v ? a.v : b.v ); };
+    static PeakLanesScalar select(const PeakLanesScalar &m, const PeakLanesScalar &a, const PeakLanesScalar &b) { return bits(m.v) ? a : b; };
+};
+
+#if defined(__AVX__)
+class PeakLanes
+{
+public:
+    static const int width = 8;
+    __m256 v;
+    static PeakLanes make(__m256 m) { PeakLanes l; l.v = m; return l; };
+    static PeakLanes load(const float *p) { return make( _mm256_loadu_ps(p) ); };
+    static PeakLanes set(float f) { return make( _mm256_set1_ps(f) ); };
+    void store(float *p) const { _mm256_storeu_ps(p, v); };
+    PeakLanes operator+(const PeakLanes &b) const { return make( _mm256_add_ps(v, b.v) ); };
+    PeakLanes operator-(const PeakLanes &b) const { return make( _mm256_sub_ps(v, b.v) ); };
+    PeakLanes operator/(const PeakLanes &b) const { return make( _mm256_div_ps(v, b.v) ); };
+    PeakLanes operator<(const PeakLanes &b) const { return make( _mm256_cmp_ps(v, b.v, _CMP_LT_OQ) ); };
+    PeakLanes operator>(const PeakLanes &b) const { return make( _mm256_cmp_ps(v, b.v, _CMP_GT_OQ) ); };
+    PeakLanes operator!=(const PeakLanes &b) const { return make( _mm256_cmp_ps(v, b.v, _CMP_NEQ_UQ) ); };
+    PeakLanes operator&(const PeakLanes &b) const { return make( _mm256_and_ps(v, b.v) ); };
+    PeakLanes operator|(const PeakLanes &b) const { return make( _mm256_or_ps(v, b.v) ); };
+    static PeakLanes max(const PeakLanes &a, const PeakLanes &b) { return make( _mm256_max_ps(a.v, b.v) ); };
+    static PeakLanes select(const PeakLanes &m, const PeakLanes &a, const PeakLanes &b) { return make( _mm256_blendv_ps(b.v, a.v, m.v) ); };
+};
+#define BATCHPEAKS_INSTRUCTIONS "AVX"
+#elif defined(__SSE2__)
+class PeakLanes
+{
+public:
+    static const int width = 4;
+    __m128 v;
+    static PeakLanes make(__m128 m) { PeakLanes l; l.v = m; return l; };
+    static PeakLanes load(const float *p) { return make( _mm_loadu_ps(p) ); };
+    static PeakLanes set(float f) { return make( _mm_set1_ps(f) ); };
+    void store(float *p) const { _mm_storeu_ps(p, v); };
+    PeakLanes operator+(const PeakLanes &b) const { return make( _mm_add_ps(v, b.v) ); };
+    PeakLanes operator-(const PeakLanes &b) const { return make( _mm_sub_ps(v, b.v) ); };
+    PeakLanes operator/(const PeakLanes &b) const { return make( _mm_div_ps(v, b.v) ); };
+    PeakLanes operator<(const PeakLanes &b) const { return make( _mm_cmplt_ps(v, b.v) ); };
+    PeakLanes operator>(const PeakLanes &b) const { return make( _mm_cmpgt_ps(v, b.v) ); };
+    PeakLanes operator!=(const PeakLanes &b) const { return make( _mm_cmpneq_ps(v, b.v) ); };
+    PeakLanes operator&(const PeakLanes &b) const { return make( _mm_and_ps(v, b.v) ); };
+    PeakLanes operator|(const PeakLanes &b) const { return make( _mm_or_ps(v, b.v) ); };
+    static PeakLanes max(const PeakLanes &a, const PeakLanes &b) { return make( _mm_max_ps(a.v, b.v) ); };
+    static PeakLanes select(const PeakLanes &m, const PeakLanes &a, const PeakLanes &b) { return make( _mm_or_ps( _mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v) ) ); };
+};
+#define BATCHPEAKS_INSTRUCTIONS "SSE"
+#else
+typedef PeakLanesScalar PeakLanes;
+#define BATCHPEAKS_INSTRUCTIONS "scalar"
+#endif
+
+#define BATCHPEAKS_MAX_WIDTH 8 //channel slots are padded to this, so any of the lanes fit
+
+class BatchPeakDetection
+{
+protected:
+    int channelCount;
+    int stride; //channelCount, padded
+    int maxRows; //new samples per channel per frame
+    int usedRows; //the most any channel has this frame
+
+    //[row][axis][channel] & [row][channel] -- a mask of the channels that have the row & the samples' times
+    std::vector<float> samples;
+    std::vector<float> has;
+    std::vector<double> times;
+    std::vector<float> rows; //[channel], this frame's
+
+    //kept from frame to frame, [axis][channel] & [channel]
+    std::vector<float> last; //last non-zero value
+    std::vector<double> lastTime; //& when
+    std::vector<float> thresh;
+    std::vector<float> waitTime;
+    std::vector<double> peakTime; //as PeakTimer
+
+    //the times as seconds from frameBase, for the lanes -- see toOffsets() & fromOffsets()
+    std::vector<float> timeOffsets, lastOffsets, peakOffsets;
+    double frameBase; //the frame's first sample's time
+    bool hasFrameBase;
+
+    //out, [channel]
+    std::vector<float> peak; //how many onsets this frame
+    std::vector<float> height; //normalized, as FindPeaks::getCurrentPeak()
+
+    float allBits;
+
+    template<typename L>
+    void detectRows()
+    {
+        int count = ( (channelCount + L::width - 1) / L::width ) * L::width;
+        L zero = L::set(0), one = L::set(1);
+        for(int k=0; k<count; k+=L::width)
+        {
+            L l[3], lt[3], t[3];
+            for(int a=0; a<3; a++)
+            {
+                l[a] = L::load(&last[a*stride + k]);
+                lt[a] = L::load(&lastOffsets[a*stride + k]);
+                t[a] = L::load(&thresh[a*stride + k]);
+            }
+            L wait = L::load(&waitTime[k]), lastPeak = L::load(&peakOffsets[k]);
+            L onsets = zero, high = zero;
+
+            for(int r=0; r<usedRows; r++)
+            {
+                L in = L::load(&has[r*stride + k]);
+                L now = L::load(&timeOffsets[r*stride + k]);
+
+                //the + to - crossings over their thresholds -- the highest, 0 to 1 from the threshold to the max, as FindPeaks
+                L best = zero, bestTime = zero;
+                for(int a=0; a<3; a++)
+                {
+                    L v = L::load(&samples[ (r*3 + a)*stride + k ]);
+                    L crossed = in & (v < zero) & (l[a] > zero) & (l[a] > t[a]);
+                    L h = (l[a] - t[a]) / (one - t[a]);
+                    L take = crossed & (h > best);
+                    best = L::select(take, h, best);
+                    bestTime = L::select(take, lt[a], bestTime);
+                    L changed = in & (v != zero);
+                    l[a] = L::select(changed, v, l[a]);
+                    lt[a] = L::select(changed, now, lt[a]);
+                }
+
+                //an onset if it's been long enough since the last, by the samples' times
+                L fired = (best > zero) & ( (lastPeak + wait) < bestTime );
+                lastPeak = L::select(fired, bestTime, lastPeak);
+                onsets = onsets + (fired & one);
+                high = L::select(fired & (best > high), best, high);
+            }
+
+            for(int a=0; a<3; a++)
+            {
+                l[a].store(&last[a*stride + k]);
+                lt[a].store(&lastOffsets[a*stride + k]);
+            }
+            lastPeak.store(&peakOffsets[k]);
+            onsets.store(&peak[k]);
+            L::select(onsets > zero, high, L::load(&height[k])).store(&height[k]);
+        }
+    };
+
+    static void toOffsets(const std::vector<double> &times_, std::vector<float> &offsets, int count, double base)
+    {
+        for(int i=0; i<count; i++)
+            offsets[i] = float(times_[i] - base);
+    };
+
+    //only the ones detectRows() changed, so the rest keep their precision
+    static void fromOffsets(std::vector<double> &times_, const std::vector<float> &offsets, int count, double base)
+    {
+        for(int i=0; i<count; i++)
+        {
+            if( offsets[i] != float(times_[i] - base) ) times_[i] = base + offsets[i];
+        }
+    };
+
+    template<typename L>
+    void detectFrame()
+    {
+        double base = hasFrameBase ? frameBase : 0;
+        toOffsets(times, timeOffsets, usedRows * stride, base);
+        toOffsets(lastTime, lastOffsets, 3 * stride, base);
+        toOffsets(peakTime, peakOffsets, stride, base);
+        detectRows<L>();
+        fromOffsets(lastTime, lastOffsets, 3 * stride, base);
+        fromOffsets(peakTime, peakOffsets, stride, base);
+    };
+
+public:
+    //channels: bones x dancers. maxRowsPerFrame: the most new samples a channel gets in a frame
+    BatchPeakDetection(int channels, int maxRowsPerFrame = 8)
+    {
+        channelCount = channels;
+        stride = ( (channels + BATCHPEAKS_MAX_WIDTH - 1) / BATCHPEAKS_MAX_WIDTH ) * BATCHPEAKS_MAX_WIDTH;
+        maxRows = maxRowsPerFrame;
+        usedRows = 0;
+        uint32_t b = 0xFFFFFFFF;
+        memcpy(&allBits, &b, 4);
+
+        frameBase = 0;
+        hasFrameBase = false;
+
+        samples.resize(maxRows * 3 * stride, 0.0f);
+        has.resize(maxRows * stride, 0.0f);
+        times.resize(maxRows * stride, 0.0);
+        rows.resize(stride, 0.0f);
+        last.resize(3 * stride, 0.0f);
+        lastTime.resize(3 * stride, 0.0);
+        thresh.resize(3 * stride, 0.0f);
+        waitTime.resize(stride, 0.0f);
+        peakTime.resize(stride, 0.0); //the last peaks were at 0, as PeakTimer
+        timeOffsets.resize(maxRows * stride, 0.0f);
+        lastOffsets.resize(3 * stride, 0.0f);
+        peakOffsets.resize(stride, 0.0f);
+        peak.resize(stride, 0.0f);
+        height.resize(stride, 0.0f);
+    };
+
+    static const char *getInstructionSet()
+    {
+        return BATCHPEAKS_INSTRUCTIONS;
+    };
+
+    int getChannelCount() { return channelCount; };
+
+    //as FindPeaks::setThreshes()
+    void setThreshes(int channel, double x, double y, double z)
+    {
+        thresh[channel] = x;
+        thresh[stride + channel] = y;
+        thresh[2*stride + channel] = z;
+    };
+
+    //as FindPeaks' waitBetween, in seconds
+    void setWaitTime(int channel, double seconds)
+    {
+        waitTime[channel] = seconds;
+    };
+
+    //call before adding the frame's samples
+    void beginFrame()
+    {
+        for(int r=0; r<usedRows; r++)
+            std::fill(has.begin() + r*stride, has.begin() + (r+1)*stride, 0.0f);
+        std::fill(rows.begin(), rows.end(), 0.0f);
+        usedRows = 0;
+        hasFrameBase = false;
+    };
+
+    //the derivative's next new sample for the channel & its time (see PeakStream::sampleTime()) -- false if it already
+    //has maxRowsPerFrame this frame
+    bool add(int channel, double x, double y, double z, double time)
+    {
+        int r = int(rows[channel]);
+        if( r >= maxRows ) return false;
+        if( !hasFrameBase )
+        {
+            frameBase = time;
+            hasFrameBase = true;
+        }
+        times[r*stride + channel] = time;
+        samples[ (r*3)*stride + channel ] = x;
+        samples[ (r*3 + 1)*stride + channel ] = y;
+        samples[ (r*3 + 2)*stride + channel ] = z;
+        has[r*stride + channel] = allBits;
+        rows[channel] = r + 1;
+        usedRows = std::max(usedRows, r + 1);
+        return true;
+    };
+
+    //every channel, w/the widest lanes the build has
+    void detect()
+    {
+        detectFrame<PeakLanes>();
+    };
+
+    //same, one channel at a time -- for comparing
+    void detectScalar()
+    {
+        detectFrame<PeakLanesScalar>();
+    };
+
+    //as FindPeaks::getCombinedPeak(), getOnsets().size() & getCurrentPeak(), after detect()
+    bool getPeak(int channel) { return peak[channel] != 0; };
+    int getOnsetCount(int channel) { return int(peak[channel]); };
+    double getHeight(int channel) { return height[channel]; };
+};
+
+};
+
+#endif /* BatchPeakDetection_h */
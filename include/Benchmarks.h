@@ -0,0 +1,714 @@
+//
+//  Benchmarks.h
+//  VideoAndOSCLab
+//
+//  Benchmarks for the signal analysis pipeline. These run on synthetic data, not on the sensors coming into the app,
+//  so that runs are comparable. Results are printed to the console.
+//
+
+#ifndef Benchmarks_h
+#define Benchmarks_h
+
+#include <chrono>
+#include <random>
+
+namespace CRCPMotionAnalysis {
+
+#define BENCHMARK_BONE_COUNT 20 //a full notch skeleton-ish
+#define BENCHMARK_SAMPLES_PER_FRAME 2 //~40Hz sensors at ~30 fps, rounded up
+
+//a stopwatch for the benchmarks, in milliseconds
+class BenchmarkTimer
+{
+protected:
+    std::chrono::high_resolution_clock::time_point startTime;
+public:
+    BenchmarkTimer()
+    {
+        start();
+    };
+
+    void start()
+    {
+        startTime = std::chrono::high_resolution_clock::now();
+    };
+
+    double elapsedMS()
+    {
+        std::chrono::duration<double, std::milli> d = std::chrono::high_resolution_clock::now() - startTime;
+        return d.count();
+    };
+};
+
+//makes fake notch bone samples, a different sine wave on each axis and bone
+class SyntheticBoneSource
+{
+protected:
+    SensorData *sensor;
+    int bone;
+    int sampleIndex;
+public:
+    SyntheticBoneSource(SensorData *s, int whichBone)
+    {
+        sensor = s;
+        bone = whichBone;
+        sampleIndex = 0;
+    };
+
+    void addSamples(int count, double seconds)
+    {
+        for(int i=0; i<count; i++)
+        {
+            MocapDeviceData *sample = sensor->createSample();
+            double t = sampleIndex / SR;
+            sample->setData(MocapDeviceData::DataIndices::INDEX, sampleIndex);
+            sample->setData(MocapDeviceData::DataIndices::TIME_STAMP, seconds);
+            sample->setReceiveTime(t); //as if each came in when it was sampled
+            for(int j=0; j<3; j++)
+            {
+                double phase = t * (1.0 + 0.1*bone + 0.3*j);
+                sample->setData(MocapDeviceData::DataIndices::ACCELX+j, 0.5*sin(2*M_PI*phase));
+                sample->setData(MocapDeviceData::DataIndices::BONEANGLE_TILT+j, 90*sin(M_PI*phase));
+                sample->setData(MocapDeviceData::DataIndices::RELATIVE_TILT+j, 45*cos(M_PI*phase));
+                sample->setData(MocapDeviceData::DataIndices::ANGVEL_TILT+j, 10*cos(2*M_PI*phase));
+            }
+            sensor->addSensorData(sample);
+            sampleIndex++;
+        }
+    };
+};
+
+//runs the per-bone chain from BodyPartSensor::addSensor() -- InputSignal -> AveragingFilter -> Derivative & FindPeaks --
+//for a 20-bone skeleton and reports time & allocations per frame. For comparison, it also simulates the vector copies
+//that the chain made before the ugens handed each other buffer views -- every getBuffer() returned a copy, every
+//SignalAnalysis::update() copied that again into data1 and the averaging filter copied its input for every average it
+//took. That side is only the copies, replayed on their own, not the old ugens: it's an estimate of what they cost, not
+//a before & after of the whole chain.
+class BufferViewBenchmark
+{
+protected:
+    struct Bone
+    {
+        SensorData *sensor;
+        SyntheticBoneSource *source;
+        InputSignal *input;
+        AveragingFilter *avg;
+        Derivative *derivative;
+        FindPeaks *peaks;
+    };
+    std::vector<Bone> bones;
+
+    long legacyAllocations;
+    long legacyPointersCopied;
+
+    //one std::vector copy, as the old getBuffer() made
+    void legacyCopy(const MocapBufferView &view)
+    {
+        std::vector<MocapDeviceData *> copy = view.toVector();
+        if(!copy.empty()) legacyAllocations++;
+        legacyPointersCopied += copy.size();
+    };
+
+    //the copies the old code made for one bone in one frame
+    void legacyCopies(Bone &b)
+    {
+        //InputSignal: sensor->getBuffer() + the filtered data1 + getBuffer() out to the filter
+        legacyCopy(b.input->getBuffer());
+        legacyCopy(b.input->getBuffer());
+        legacyCopy(b.input->getBuffer());
+
+        //AveragingFilter: data1 = ugen->getBuffer() (a copy, then a copy-assign) + 9 data1 copies per output sample in mocapDeviceAvg()
+        MocapBufferView avgIn = b.input->getBuffer();
+        legacyCopy(avgIn);
+        legacyCopy(avgIn);
+        for(int i=0; i<b.avg->getBuffer().size()*9; i++)
+            legacyCopy(avgIn);
+
+        //Derivative, FindPeaks and FindPeaks' own Derivative all take the averaging filter output twice each + FindPeaks takes the derivative
+        for(int i=0; i<6; i++)
+            legacyCopy(b.avg->getBuffer());
+        legacyCopy(b.derivative->getBuffer());
+        legacyCopy(b.derivative->getBuffer());
+    };
+
+public:
+    BufferViewBenchmark()
+    {
+        for(int i=0; i<BENCHMARK_BONE_COUNT; i++)
+        {
+            Bone b;
+            std::stringstream name;
+            name << "BenchmarkBone" << i;
+            b.sensor = new SensorData(name.str(), i, MocapDeviceData::MocapDevice::NOTCH, MocapDeviceData::SendingDevice::UNSPECIFIED);
+            b.source = new SyntheticBoneSource(b.sensor, i);
+            b.input = new InputSignal(i);
+            b.input->setInput(b.sensor);
+            b.avg = new AveragingFilter(b.input, 3, 16, i, name.str());
+            b.derivative = new Derivative(b.avg, 16, i, name.str());
+            b.peaks = new FindPeaks(0.3, b.avg, i, name.str());
+            bones.push_back(b);
+        }
+    };
+
+    ~BufferViewBenchmark()
+    {
+        for(int i=0; i<bones.size(); i++)
+        {
+            delete bones[i].peaks;
+            delete bones[i].derivative;
+            delete bones[i].avg;
+            delete bones[i].input;
+            delete bones[i].source;
+            delete bones[i].sensor;
+        }
+    };
+
+    void run(int frames=2000)
+    {
+        double seconds = 0;
+        double frameTime = 1.0/30.0;
+
+        //warm up, so that the buffers and pools are full
+        for(int f=0; f<SENSORDATA_BUFFER_SIZE; f++)
+        {
+            seconds += frameTime;
+            updateFrame(seconds);
+        }
+
+        long slabsBefore = MocapDataPoolStats::slabAllocations();
+        BenchmarkTimer timer;
+        for(int f=0; f<frames; f++)
+        {
+            seconds += frameTime;
+            updateFrame(seconds);
+        }
+        double viewMS = timer.elapsedMS();
+        long slabs = MocapDataPoolStats::slabAllocations() - slabsBefore;
+
+        legacyAllocations = 0;
+        legacyPointersCopied = 0;
+        timer.start();
+        for(int f=0; f<frames; f++)
+        {
+            for(int i=0; i<bones.size(); i++)
+                legacyCopies(bones[i]);
+        }
+        double legacyMS = timer.elapsedMS();
+
+        std::cout << "---------------------------------------------------------------------\n";
+        std::cout << "Buffer view benchmark: " << bones.size() << " bones, " << frames << " frames, " << BENCHMARK_SAMPLES_PER_FRAME << " samples/bone/frame\n";
+        std::cout << " views:  " << viewMS / frames << " ms/frame, " << double(slabs) / frames << " slab allocations/frame, 0 buffer copies\n";
+        std::cout << " the copies the old vector API made (simulated, on their own): " << double(legacyAllocations) / frames << " allocations/frame, "
+                  << (double(legacyPointersCopied) * sizeof(MocapDeviceData *) / 1024.0) / frames << " KB copied/frame, "
+                  << legacyMS / frames << " ms/frame\n";
+        std::cout << "---------------------------------------------------------------------\n";
+    };
+
+protected:
+    void updateFrame(double seconds)
+    {
+        for(int i=0; i<bones.size(); i++)
+        {
+            Bone &b = bones[i];
+            b.source->addSamples(BENCHMARK_SAMPLES_PER_FRAME, seconds);
+            b.sensor->update(seconds);
+            b.input->update(seconds);
+            b.avg->update(seconds);
+            b.derivative->update(seconds);
+            b.peaks->update(seconds);
+        }
+    };
+};
+
+//forward kinematics for a floor of dancers (1, 8 & 32 Notch figures): each figure solving its own skeleton, as
+//NotchBoneFigure::update() does, vs. all of them at once w/BatchForwardKinematics, one skeleton at a time & w/SIMD
+class ForwardKinematicsBenchmark
+{
+protected:
+    std::vector<ci::vec3> angles; //[frame][skeleton][joint], so making them up isn't timed
+
+    ci::vec3 &angle(int frame, int skeleton, int joint, int skeletons, int joints)
+    {
+        return angles[ (frame*skeletons + skeleton)*joints + joint ];
+    };
+
+    void makeAngles(int frames, int skeletons, int joints)
+    {
+        angles.resize(frames * skeletons * joints);
+        for(int f=0; f<frames; f++)
+            for(int s=0; s<skeletons; s++)
+                for(int j=0; j<joints; j++)
+                {
+                    double phase = 0.05*f + 0.7*s + 0.3*j;
+                    angle(f, s, j, skeletons, joints) = ci::vec3(60*sin(phase), 45*sin(1.3*phase), 30*cos(0.7*phase));
+                }
+    };
+
+public:
+    void run(int frames=2000)
+    {
+        const int ANGLE_FRAMES = 64; //cycled through
+        int counts[] = {1, 8, 32};
+        NotchBoneFigure figure;
+        int joints = figure.getSkeleton().getJointCount();
+
+        std::cout << "---------------------------------------------------------------------\n";
+        std::cout << "Forward kinematics benchmark: " << joints << " joints/skeleton, " << frames << " frames, batch uses " << BatchForwardKinematics::getInstructionSet() << "\n";
+        for(int c=0; c<3; c++)
+        {
+            int count = counts[c];
+            makeAngles(ANGLE_FRAMES, count, joints);
+            std::vector<ForwardKinematicsSolver> solvers(count, figure.getSkeleton());
+            BatchForwardKinematics batch(figure.getSkeleton(), count);
+
+            BenchmarkTimer timer;
+            for(int f=0; f<frames; f++)
+            {
+                for(int s=0; s<count; s++)
+                {
+                    for(int j=0; j<joints; j++)
+                        solvers[s].setAngles(j, angle(f % ANGLE_FRAMES, s, j, count, joints));
+                    solvers[s].solve();
+                }
+            }
+            double eachMS = timer.elapsedMS();
+
+            double batchMS[2];
+            for(int simd=0; simd<2; simd++)
+            {
+                timer.start();
+                for(int f=0; f<frames; f++)
+                {
+                    for(int s=0; s<count; s++)
+                        for(int j=0; j<joints; j++)
+                            batch.setAngles(s, j, angle(f % ANGLE_FRAMES, s, j, count, joints));
+                    if(simd) batch.solve();
+                    else batch.solveScalar();
+                }
+                batchMS[simd] = timer.elapsedMS();
+            }
+
+            //both had the last frame's angles
+            double maxDiff = 0;
+            for(int s=0; s<count; s++)
+                for(int j=0; j<joints; j++)
+                    maxDiff = std::max(maxDiff, double(ci::distance(solvers[s].getEndPoint(j), batch.getEndPoint(s, j))));
+
+            double solved = double(count) * joints * frames;
+            std::cout << " " << count << " skeleton(s): each solved alone " << solved / eachMS / 1000.0 << "M joints/s, batch "
+                      << solved / batchMS[0] / 1000.0 << "M joints/s, batch " << BatchForwardKinematics::getInstructionSet() << " "
+                      << solved / batchMS[1] / 1000.0 << "M joints/s (max difference " << maxDiff << ")\n";
+        }
+        std::cout << "---------------------------------------------------------------------\n";
+    };
+};
+
+//peak detection for a floor of dancers (1, 8 & 32 x 20 bones): each bone's FindPeaks on its own, as BodyPartSensor
+//does, vs. all of them at once w/BatchPeakDetection, one bone at a time & w/SIMD. Both get the same averaged signal &
+//the batch is fed from a Derivative per bone, so both times include taking the derivative. Each frame's onsets are
+//compared bone by bone
+class PeakDetectionBenchmark
+{
+protected:
+    struct Bone
+    {
+        SensorData *sensor;
+        SyntheticBoneSource *source;
+        InputSignal *input;
+        AveragingFilter *avg;
+        FindPeaks *peaks;
+        Derivative *derivative; //for the batch
+    };
+    std::vector<Bone> bones;
+
+    void makeBones(int count)
+    {
+        for(int i=0; i<count; i++)
+        {
+            int b = i % BENCHMARK_BONE_COUNT, dancer = i / BENCHMARK_BONE_COUNT;
+            Bone bone;
+            std::stringstream name;
+            name << "BenchmarkBone" << i;
+            bone.sensor = new SensorData(name.str(), i, MocapDeviceData::MocapDevice::NOTCH, MocapDeviceData::SendingDevice::UNSPECIFIED);
+            bone.source = new SyntheticBoneSource(bone.sensor, b + dancer % 7);
+            bone.input = new InputSignal(i);
+            bone.input->setInput(bone.sensor);
+            bone.avg = new AveragingFilter(bone.input, 3, 16, i, name.str());
+            bone.peaks = new FindPeaks(waitTime(b), bone.avg, i, name.str());
+            bone.peaks->setThreshes(thresh(b, 0), thresh(b, 1), thresh(b, 2));
+            bone.derivative = new Derivative(bone.avg, 16, i, name.str());
+            bones.push_back(bone);
+        }
+    };
+
+    void deleteBones()
+    {
+        for(int i=0; i<bones.size(); i++)
+        {
+            delete bones[i].derivative;
+            delete bones[i].peaks;
+            delete bones[i].avg;
+            delete bones[i].input;
+            delete bones[i].source;
+            delete bones[i].sensor;
+        }
+        bones.clear();
+    };
+
+    //different for each bone, so that the lanes don't all agree
+    static double thresh(int bone, int axis) { return 0.002 + 0.001*bone + 0.002*axis; };
+    //off the samples' times by half a sample -- a peak exactly the wait after the last could go either way in floats
+    static double waitTime(int bone) { return 0.1 + 0.02*(bone % 10) + 0.5/SR; };
+
+public:
+    ~PeakDetectionBenchmark()
+    {
+        deleteBones();
+    };
+
+    void run(int frames=2000)
+    {
+        int counts[] = {1, 8, 32};
+
+        std::cout << "---------------------------------------------------------------------\n";
+        std::cout << "Peak detection benchmark: " << BENCHMARK_BONE_COUNT << " bones/dancer, " << frames << " frames, " << BENCHMARK_SAMPLES_PER_FRAME
+                  << " samples/bone/frame, batch uses " << BatchPeakDetection::getInstructionSet() << "\n";
+        for(int c=0; c<3; c++)
+        {
+            makeBones(counts[c] * BENCHMARK_BONE_COUNT);
+            BatchPeakDetection batch(bones.size()), scalar(bones.size());
+            for(int i=0; i<bones.size(); i++)
+            {
+                int b = i % BENCHMARK_BONE_COUNT;
+                for(int k=0; k<2; k++)
+                {
+                    BatchPeakDetection &d = k ? batch : scalar;
+                    d.setThreshes(i, thresh(b, 0), thresh(b, 1), thresh(b, 2));
+                    d.setWaitTime(i, waitTime(b));
+                }
+            }
+
+            double eachMS = 0, derivativeMS = 0, scalarMS = 0, batchMS = 0;
+            long peaks = 0, batchPeaks = 0, mismatches = 0;
+            BenchmarkTimer timer;
+            for(int f=0; f<frames; f++)
+            {
+                double seconds = f * BENCHMARK_SAMPLES_PER_FRAME / SR;
+                for(int i=0; i<bones.size(); i++)
+                {
+                    Bone &b = bones[i];
+                    b.source->addSamples(BENCHMARK_SAMPLES_PER_FRAME, seconds);
+                    b.sensor->update(seconds);
+                    b.input->update(seconds);
+                    b.avg->update(seconds);
+                }
+
+                timer.start();
+                for(int i=0; i<bones.size(); i++)
+                    bones[i].peaks->update(seconds);
+                eachMS += timer.elapsedMS();
+
+                //the derivatives' new samples into the batch -- once their buffers are as full as FindPeaks waits for
+                timer.start();
+                batch.beginFrame();
+                scalar.beginFrame();
+                for(int i=0; i<bones.size(); i++)
+                {
+                    Derivative *d = bones[i].derivative;
+                    d->update(seconds);
+                    MocapBufferView buffer = d->getBuffer();
+                    if( buffer.size() < MIN_PEAK_WINDOW ) continue;
+                    for(int j=buffer.size()-d->getNewSampleCount(); j<buffer.size(); j++)
+                    {
+                        MocapDeviceData *sample = buffer[j];
+                        double x = sample->getData(MocapDeviceData::DataIndices::ACCELX);
+                        double y = sample->getData(MocapDeviceData::DataIndices::ACCELY);
+                        double z = sample->getData(MocapDeviceData::DataIndices::ACCELZ);
+                        double t = PeakStream::sampleTime(sample);
+                        batch.add(i, x, y, z, t);
+                        scalar.add(i, x, y, z, t);
+                    }
+                }
+                derivativeMS += timer.elapsedMS();
+
+                timer.start();
+                scalar.detectScalar();
+                scalarMS += timer.elapsedMS();
+
+                timer.start();
+                batch.detect();
+                batchMS += timer.elapsedMS();
+
+                for(int i=0; i<bones.size(); i++)
+                {
+                    int p = bones[i].peaks->getOnsets().size();
+                    peaks += p;
+                    batchPeaks += batch.getOnsetCount(i);
+                    if( p != batch.getOnsetCount(i) || p != scalar.getOnsetCount(i) ) mismatches++;
+                }
+            }
+
+            //per bone per frame, the batch incl. making its input
+            double n = double(bones.size()) * frames;
+            std::cout << " " << counts[c] << " dancer(s), " << bones.size() << " bones: each alone " << eachMS * 1000000.0 / n << " ns/bone, batch "
+                      << (derivativeMS + scalarMS) * 1000000.0 / n << " ns/bone, batch " << BatchPeakDetection::getInstructionSet() << " "
+                      << (derivativeMS + batchMS) * 1000000.0 / n << " ns/bone -- the peak finding alone " << scalarMS * 1000000.0 / n << " vs "
+                      << batchMS * 1000000.0 / n << " ns/bone. " << peaks << " onsets, " << batchPeaks << " batched, " << mismatches << " bone-frames differ\n";
+            deleteBones();
+        }
+        std::cout << "---------------------------------------------------------------------\n";
+    };
+};
+
+//makes the OSC a floor of dancers sends: each dancer's notch suit (/Notch/BonePosAndAccel w/the full bone list -- the
+//measured bones w/accel, angles, relative angles & angular velocity & the static ones w/just a position), plus wiimotes
+//(/wii/N/accel/pry) & a phone running Syntien, which go to the first dancer as in the app. Each stream sends at its
+//own rate & each packet arrives up to jitter seconds late, so they come in bunched up & out of step as on a real
+//network. Seeded, so runs are comparable
+class SyntheticMocapLoad
+{
+public:
+    class Packet
+    {
+    public:
+        double arrival;
+        std::vector<char> data;
+    };
+
+protected:
+    enum StreamKind { NOTCH=0, WIIMOTE=1, PHONE=2 };
+    class Stream
+    {
+    public:
+        StreamKind kind;
+        int index; //dancer or wiimote
+        double period;
+        double next; //when the next packet is sent
+        long sent;
+    };
+
+    std::vector<Stream> streams;
+    std::vector<std::string> dancers;
+    std::vector<std::string> measuredBones, staticBones;
+    std::string notchTags;
+    double jitter;
+    std::minstd_rand random;
+    std::uniform_real_distribution<double> lateness;
+    OSCPacketWriter writer;
+    std::vector<Packet> pending; //sent but not arrived yet
+
+    void addStream(StreamKind kind, int index, double rate)
+    {
+        Stream stream;
+        stream.kind = kind;
+        stream.index = index;
+        stream.period = 1.0 / std::max(1.0, rate);
+        stream.next = lateness(random) * stream.period; //not all in step
+        stream.sent = 0;
+        streams.push_back(stream);
+    };
+
+    void write(Stream &stream)
+    {
+        double t = stream.next;
+        if( stream.kind == NOTCH )
+        {
+            writer.begin(NOTCH_MESSAGE, notchTags.c_str());
+            writer.addString(dancers[stream.index]);
+            writer.addString("iOS");
+            writer.addInt32( int(stream.sent) );
+            for(int b=0; b<measuredBones.size(); b++)
+            {
+                writer.addString(measuredBones[b]);
+                double phase = t * (1.0 + 0.1*b + 0.05*stream.index);
+                for(int j=0; j<3; j++) writer.addFloat( 0.8*sin(2*M_PI*(phase + 0.3*j)) ); //accel
+                for(int j=0; j<3; j++) writer.addFloat( 90*sin(M_PI*(phase + 0.2*j)) ); //angles
+                for(int j=0; j<3; j++) writer.addFloat( 45*cos(M_PI*(phase + 0.2*j)) ); //relative angles
+                for(int j=0; j<3; j++) writer.addFloat( 10*cos(2*M_PI*(phase + 0.2*j)) ); //angular velocity
+            }
+            for(int b=0; b<staticBones.size(); b++)
+            {
+                writer.addString(staticBones[b]);
+                for(int j=0; j<3; j++) writer.addFloat( 0.1*b + j );
+            }
+        }
+        else
+        {
+            std::string address = SYNTIEN_MESSAGE;
+            if( stream.kind == WIIMOTE )
+                address = std::string(WIIMOTE_ACCEL_MESSAGE_PART1) + char('0' + stream.index) + WIIMOTE_ACCEL_MESSAGE_PART2;
+            writer.begin(address.c_str(), "fff");
+            double phase = t * (1.5 + 0.2*stream.index);
+            for(int j=0; j<3; j++)
+            {
+                double a = sin(2*M_PI*(phase + 0.3*j));
+                writer.addFloat( stream.kind == WIIMOTE ? 0.5 + 0.5*a : 20*a ); //wiimotes send 0..1, syntien about +-50
+            }
+        }
+
+        Packet packet;
+        packet.arrival = t + lateness(random) * jitter;
+        packet.data.assign(writer.getData(), writer.getData() + writer.getSize());
+        pending.push_back(packet);
+
+        stream.sent++;
+        stream.next += stream.period;
+    };
+
+public:
+    //rates in packets per second, jitter in seconds. wiimotes: up to MAX_NUM_OF_WIIMOTES
+    SyntheticMocapLoad(int dancerCount, double notchRate = 40, int wiimotes = 0, double wiiRate = 100, bool phone = false, double phoneRate = 50,
+                       double jitterSeconds = 0.005, unsigned seed = 1) : random(seed), lateness(0.0, 1.0)
+    {
+        jitter = jitterSeconds;
+        measuredBones = {"Root", "Hip", "ChestBottom", "LeftUpperArm", "LeftForeArm", "LeftHand", "RightUpperArm", "RightForeArm", "RightHand"};
+        staticBones = {"ChestTop", "Neck", "Head", "LeftCollar", "RightCollar", "LeftThigh", "LeftLowerLeg", "LeftFootTop", "RightThigh", "RightLowerLeg", "RightFootTop"};
+        notchTags = "ssi";
+        for(int b=0; b<measuredBones.size(); b++) notchTags += "s" + std::string(12, 'f');
+        for(int b=0; b<staticBones.size(); b++) notchTags += "s" + std::string(3, 'f');
+
+        for(int d=0; d<dancerCount; d++)
+        {
+            std::stringstream name;
+            name << "dancer" << d;
+            dancers.push_back(name.str());
+            addStream(NOTCH, d, notchRate);
+        }
+        for(int w=0; w<std::min(wiimotes, MAX_NUM_OF_WIIMOTES); w++)
+            addStream(WIIMOTE, w, wiiRate);
+        if( phone ) addStream(PHONE, 0, phoneRate);
+    };
+
+    //the packets that have arrived by until (seconds), in the order they arrived
+    void arrived(double until, std::vector<Packet> &packets)
+    {
+        for(int i=0; i<streams.size(); i++)
+        {
+            while( streams[i].next <= until )
+                write(streams[i]);
+        }
+
+        std::sort(pending.begin(), pending.end(), [](const Packet &a, const Packet &b){ return a.arrival < b.arrival; });
+        int n = 0;
+        while( n < pending.size() && pending[n].arrival <= until ) n++;
+        packets.insert(packets.end(), pending.begin(), pending.begin() + n);
+        pending.erase(pending.begin(), pending.begin() + n);
+    };
+};
+
+//the whole path from the packets to the OSC out -- decode, the sensors, the entities' ugens & getOSC() -- in one thread,
+//w/the packets from a SyntheticMocapLoad. Frames go by on the load's clock as fast as they can, & each one is timed
+//from injecting its packets to having its OSC: a frame that takes longer than the budget would make the app (& the
+//music) late. sweep() adds dancers until the frames miss the budget
+class PipelineThroughputBenchmark
+{
+public:
+    class Result
+    {
+    public:
+        int dancers;
+        long frames, packets;
+        double busyMS; //in the timed frames
+        double p50, p99, maxMS; //frame times
+    };
+
+    //the load -- see SyntheticMocapLoad
+    double notchRate, wiiRate, phoneRate, jitter;
+    int wiimotes;
+    bool phone;
+
+    double frameRate; //analysis updates per second, as the app
+    double seconds; //timed, after a second of warming up
+    int threads; //see MotionAnalysisPipeline
+
+    PipelineThroughputBenchmark()
+    {
+        notchRate = 40;
+        wiiRate = 100;
+        phoneRate = 50;
+        jitter = 0.005;
+        wiimotes = 2;
+        phone = true;
+        frameRate = 60;
+        seconds = 10;
+        threads = -1;
+    };
+
+    Result run(int dancers)
+    {
+        MotionAnalysisPipeline pipeline(0, threads);
+        MocapReceiver &receiver = pipeline.getReceiver();
+        SyntheticMocapLoad load(dancers, notchRate, wiimotes, wiiRate, phone, phoneRate, jitter);
+
+        std::vector<SyntheticMocapLoad::Packet> packets;
+        std::vector<ci::osc::Message> msgs;
+        std::vector<double> frameMS;
+        Result result;
+        result.dancers = dancers;
+        result.frames = result.packets = 0;
+        result.busyMS = 0;
+
+        int warmUp = int(frameRate);
+        int frames = warmUp + int(seconds * frameRate);
+        for(int f=1; f<=frames; f++)
+        {
+            double t = f / frameRate;
+            packets.clear();
+            load.arrived(t, packets); //making them isn't timed
+
+            BenchmarkTimer timer;
+            for(int i=0; i<packets.size(); i++)
+                receiver.injectPacket(&packets[i].data[0], int(packets[i].data.size()), packets[i].arrival);
+            pipeline.receive(t);
+            while( receiver.getWekinatorFrames().front() != NULL ) receiver.getWekinatorFrames().popFront();
+            while( receiver.getRawPackets().front() != NULL ) receiver.getRawPackets().popFront();
+            msgs.clear();
+            pipeline.update(t, msgs);
+            double ms = timer.elapsedMS();
+
+            if( f <= warmUp ) continue;
+            frameMS.push_back(ms);
+            result.busyMS += ms;
+            result.packets += packets.size();
+            result.frames++;
+        }
+
+        std::sort(frameMS.begin(), frameMS.end());
+        result.p50 = frameMS[ frameMS.size() / 2 ];
+        result.p99 = frameMS[ std::min( frameMS.size() - 1, size_t(frameMS.size() * 0.99) ) ];
+        result.maxMS = frameMS.back();
+        return result;
+    };
+
+    void print(const Result &r, double budgetMS)
+    {
+        std::cout << " " << r.dancers << " dancer(s): " << r.packets * 1000.0 / r.busyMS << " packets/s sustained, " << r.packets / (r.frames / frameRate)
+                  << " packets/s sent -- frame " << r.p50 << "/" << r.p99 << "/" << r.maxMS << " ms p50/p99/max"
+                  << (r.p99 > budgetMS ? " -- MISSES the budget" : "") << "\n";
+    };
+
+    //1, 2, 4 ... dancers, up to maxDancers or the first count whose p99 frame misses the budget
+    void sweep(int maxDancers = 64, double budgetMS = 25)
+    {
+        std::cout << "---------------------------------------------------------------------\n";
+        std::cout << "Pipeline throughput benchmark: notch " << notchRate << "/s, " << wiimotes << " wiimote(s) " << wiiRate << "/s, "
+                  << (phone ? 1 : 0) << " phone " << phoneRate << "/s, jitter " << jitter * 1000 << " ms, " << frameRate << " frames/s, "
+                  << seconds << " seconds each, budget " << budgetMS << " ms\n";
+
+        int missed = -1;
+        for(int dancers=1; dancers<=maxDancers && missed < 0; dancers*=2)
+        {
+            Result r = run(dancers);
+            print(r, budgetMS);
+            if( r.p99 > budgetMS ) missed = dancers;
+        }
+
+        if( missed > 0 ) std::cout << " the " << budgetMS << " ms budget is missed (p99) at " << missed << " dancers\n";
+        else std::cout << " the " << budgetMS << " ms budget was met up to " << maxDancers << " dancers\n";
+        std::cout << "---------------------------------------------------------------------\n";
+    };
+};
+
+};
+
+#endif /* Benchmarks_h */
@@ -0,0 +1,210 @@
+//
+//  ForwardKinematics.h
+//  VideoAndOSCLab
+//
+//  Where the joints of a skeleton are, given each bone's angles -- plain math, no GL. The skeleton is a flat list of joints,
+//  each w/the index of its parent. solve() goes through them once in parent-first order, so each joint's transform is its
+//  parent's times its own & the positions end up in a table that the drawing & the figure measures both read.
+//  Used by NotchBoneFigure (see UGENs.h), which has the figure's proportions.
+//
+
+#ifndef ForwardKinematics_h
+#define ForwardKinematics_h
+
+namespace CRCPMotionAnalysis {
+
+//a rotation then a translation -- p' = r*p + t
+class RigidTransform
+{
+public:
+    float r[3][3];
+    float t[3];
+
+    RigidTransform()
+    {
+        for(int i=0; i<3; i++)
+        {
+            for(int j=0; j<3; j++)
+                r[i][j] = i==j ? 1.0f : 0.0f;
+            t[i] = 0;
+        }
+    };
+
+    //about the x, y or z axis (0, 1, 2), right-handed like ci::gl::rotate()
+    static RigidTransform rotation(float radians, int axis)
+    {
+        RigidTransform xf;
+        float c = cos(radians), s = sin(radians);
+        int a = (axis + 1) % 3, b = (axis + 2) % 3;
+        xf.r[a][a] = c;
+        xf.r[a][b] = -s;
+        xf.r[b][a] = s;
+        xf.r[b][b] = c;
+        return xf;
+    };
+
+    //x, then y, then z -- as if rotated about x first on the matrix stack, ie. r = rx * ry * rz
+    static RigidTransform rotationXYZ(float x, float y, float z)
+    {
+        float cx = cos(x), sx = sin(x), cy = cos(y), sy = sin(y), cz = cos(z), sz = sin(z);
+        RigidTransform xf;
+        xf.r[0][0] = cy*cz;              xf.r[0][1] = -cy*sz;             xf.r[0][2] = sy;
+        xf.r[1][0] = sx*sy*cz + cx*sz;   xf.r[1][1] = -sx*sy*sz + cx*cz;  xf.r[1][2] = -sx*cy;
+        xf.r[2][0] = -cx*sy*cz + sx*sz;  xf.r[2][1] = cx*sy*sz + sx*cz;   xf.r[2][2] = cx*cy;
+        return xf;
+    };
+
+    //this, then b in this one's space -- like multiplying on the matrix stack
+    RigidTransform operator*(const RigidTransform &b) const
+    {
+        RigidTransform xf;
+        for(int i=0; i<3; i++)
+        {
+            for(int j=0; j<3; j++)
+                xf.r[i][j] = r[i][0]*b.r[0][j] + r[i][1]*b.r[1][j] + r[i][2]*b.r[2][j];
+            xf.t[i] = r[i][0]*b.t[0] + r[i][1]*b.t[1] + r[i][2]*b.t[2] + t[i];
+        }
+        return xf;
+    };
+
+    ci::vec3 apply(const ci::vec3 &p) const
+    {
+        return ci::vec3(r[0][0]*p.x + r[0][1]*p.y + r[0][2]*p.z + t[0],
+                        r[1][0]*p.x + r[1][1]*p.y + r[1][2]*p.z + t[1],
+                        r[2][0]*p.x + r[2][1]*p.y + r[2][2]*p.z + t[2]);
+    };
+};
+
+class SkeletonJoint
+{
+public:
+    std::string name;
+    int parent; //index, -1 for a root
+    ci::vec3 offset; //from the parent's anchor, in the parent's space
+    ci::vec3 boneEnd; //where the bone ends, in its own space
+    ci::vec3 angles; //degrees, about x, y & z
+    bool rotates; //false: only placed by the offset, eg. the figure's root
+
+    //solve() fills these in
+    RigidTransform world;
+    ci::vec3 anchor;
+    ci::vec3 end;
+};
+
+class ForwardKinematicsSolver
+{
+protected:
+    std::vector<SkeletonJoint> joints;
+    std::vector<int> order; //parents before children
+    RigidTransform base; //the whole skeleton, eg. to flip it
+    bool ordered;
+
+    void sortJoints()
+    {
+        order.clear();
+        std::vector<bool> placed(joints.size(), false);
+        while( order.size() < joints.size() )
+        {
+            int before = order.size();
+            for(int i=0; i<joints.size(); i++)
+            {
+                if( placed[i] ) continue;
+                if( joints[i].parent < 0 || placed[joints[i].parent] )
+                {
+                    order.push_back(i);
+                    placed[i] = true;
+                }
+            }
+            if( order.size() == before )
+            {
+                std::cout << "ForwardKinematicsSolver: the skeleton has a loop, some joints won't be solved\n";
+                break;
+            }
+        }
+        ordered = true;
+    };
+
+public:
+    ForwardKinematicsSolver()
+    {
+        ordered = true;
+    };
+
+    //returns the new joint's index. The parent can be added later
+    int addJoint(std::string name, int parent, ci::vec3 offset, ci::vec3 boneEnd, bool rotates=true)
+    {
+        SkeletonJoint joint;
+        joint.name = name;
+        joint.parent = parent;
+        joint.offset = offset;
+        joint.boneEnd = boneEnd;
+        joint.angles = ci::vec3(0, 0, 0);
+        joint.rotates = rotates;
+        joint.anchor = offset;
+        joint.end = offset;
+        joints.push_back(joint);
+        ordered = false;
+        return joints.size()-1;
+    };
+
+    void setBase(const RigidTransform &xf)
+    {
+        base = xf;
+    };
+
+    void setAngles(int index, const ci::vec3 &degrees)
+    {
+        joints[index].angles = degrees;
+    };
+
+    //once per frame, after the angles are set
+    void solve()
+    {
+        if( !ordered ) sortJoints();
+
+        const float toRadians = M_PI / 180.0;
+        for(int i=0; i<order.size(); i++)
+        {
+            SkeletonJoint &joint = joints[order[i]];
+
+            RigidTransform local;
+            if( joint.rotates )
+                local = RigidTransform::rotationXYZ(joint.angles.x * toRadians, joint.angles.y * toRadians, joint.angles.z * toRadians);
+            local.t[0] = joint.offset.x;
+            local.t[1] = joint.offset.y;
+            local.t[2] = joint.offset.z;
+
+            joint.world = ( joint.parent < 0 ? base : joints[joint.parent].world ) * local;
+            joint.anchor = joint.world.apply( ci::vec3(0, 0, 0) );
+            joint.end = joint.world.apply( joint.boneEnd );
+        }
+    };
+
+    int getJointCount() { return joints.size(); };
+    const SkeletonJoint &getJoint(int index) { return joints[index]; };
+    const RigidTransform &getBase() { return base; };
+
+    //the joint indices, parents first
+    const std::vector<int> &getSolveOrder()
+    {
+        if( !ordered ) sortJoints();
+        return order;
+    };
+
+    //the joint table -- where each bone starts & ends, as of the last solve()
+    const ci::vec3 &getAnchorPos(int index) { return joints[index].anchor; };
+    const ci::vec3 &getEndPoint(int index) { return joints[index].end; };
+
+    int getJointIndex(const std::string &name)
+    {
+        for(int i=0; i<joints.size(); i++)
+        {
+            if( joints[i].name == name ) return i;
+        }
+        return -1;
+    };
+};
+
+};
+
+#endif /* ForwardKinematics_h */
@@ -0,0 +1,90 @@
+//
+//  LatencyTrace.h
+//  VideoAndOSCLab
+//
+//  How long it takes from a mocap packet arriving to the peak & note it makes leaving for the patch. The receiving thread
+//  stamps each sample w/when its packet arrived (MocapDeviceData::getReceiveTime()) -- separate from the TIME_STAMP, which
+//  is still the frame's time so that the analysis doesn't change. The ugens pass the receive time on w/the time stamp,
+//  FindPeaks keeps the receive time of the sample that showed the frame's last onset & when it found it, & the pipeline collects
+//  the frame's peaks. Once the app has sent the frame's OSC it calls MotionAnalysisPipeline::traceSent().
+//
+//  The latencies are recorded on probes of their own in the Profiler, so their p50/p99/max go out w/the other stats
+//  every few seconds (see ProfileReporter). Off unless the app turns it on -- the offline tool's receive times are the
+//  session's clock, not this one.
+//
+
+#ifndef LatencyTrace_h
+#define LatencyTrace_h
+
+namespace CRCPMotionAnalysis {
+
+//one peak -- both on LatencyTracer::now()'s clock, 0 if not known
+class LatencyTrace
+{
+public:
+    double received; //the packet w/the sample the peak was found in
+    double detected; //when FindPeaks found it
+
+    LatencyTrace()
+    {
+        received = 0;
+        detected = 0;
+    };
+};
+
+class LatencyTracer
+{
+protected:
+    std::atomic<bool> enabled;
+    std::atomic<bool> appendOrigin;
+    int receiveToDetect, detectToSend, receiveToSend; //probes
+
+    LatencyTracer() : enabled(false), appendOrigin(false)
+    {
+        receiveToDetect = Profiler::get().probe("latency/receive->detect");
+        detectToSend = Profiler::get().probe("latency/detect->send");
+        receiveToSend = Profiler::get().probe("latency/receive->send");
+    };
+
+    void record(int probe, double from, double to)
+    {
+        if( probe < 0 || from <= 0 || to < from ) return;
+        Profiler::get().thisThread()->counters(probe)->record( long((to - from) * 1000000000.0), 0, 0 );
+    };
+
+public:
+    static LatencyTracer &get()
+    {
+        static LatencyTracer tracer;
+        return tracer;
+    };
+
+    //seconds on a steady clock -- the same as MocapReceiver::now()
+    static double now()
+    {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now().time_since_epoch();
+        return d.count();
+    };
+
+    bool isEnabled() { return enabled.load(std::memory_order_relaxed); };
+    void setEnabled(bool on) { enabled.store(on); };
+
+    //also add the receive time (a double, 0 if no peak) to the end of the peak & note messages, for timing at the patch
+    bool isAppendingOrigin() { return appendOrigin.load(std::memory_order_relaxed); };
+    void setAppendingOrigin(bool on) { appendOrigin.store(on); };
+
+    void detected(const LatencyTrace &trace)
+    {
+        record(receiveToDetect, trace.received, trace.detected);
+    };
+
+    void sent(const LatencyTrace &trace, double sendTime)
+    {
+        record(detectToSend, trace.detected, sendTime);
+        record(receiveToSend, trace.received, sendTime);
+    };
+};
+
+};
+
+#endif /* LatencyTrace_h */
@@ -36,8 +36,8 @@ protected:
     //for the melodic/music output -- perhaps this is a temporary place...
     CabaretMelodyGenerator *melodyGenerator;
     std::vector<FactorOracle *> fo;
-    MidiNote note;
-    bool hasNotes;
+    std::vector<MidiNote> notes; //one per onset, until they're sent
+    std::vector<double> noteReceived; //the onsets the notes came from, see PeakOnset::received
     
 public:
     enum BodyPart{ HIP=0, CHESTBOTTOM=1, LEFTUPPERARM=2, LEFTHAND=3, LEFTFOREARM=4,
@@ -46,7 +46,22 @@ public:
 
     BodyPartSensor(){
         bodyPartInit = false;
-        hasNotes = true;
+        melodyGenerator = NULL;
+    };
+    
+    //the ugens & melody algorithms it made -- the sensor is the pipeline's
+    virtual ~BodyPartSensor()
+    {
+        for(int i=0; i<bodyPart.size(); i++)
+            delete bodyPart[i];
+        for(int i=0; i<fo.size(); i++)
+            delete fo[i];
+    };
+    
+    //so each dancer's melodies aren't the same -- see MotionAnalysisPipeline::melodySeed()
+    void seedMelodies(unsigned int seed)
+    {
+        if( melodyGenerator != NULL ) melodyGenerator->seed(seed);
     };
     
     bool isInit()
@@ -79,6 +94,7 @@ public:
         bodyPart.push_back( avgfilter );
         avgSignal = avgfilter;
         
+        //the peak detection's derivative is the same as this one, so the graph gives it this one instead of it taking its own
         Derivative *derivative = new Derivative(avgfilter, 16, idz, whichBodyPart, true);
         bodyPart.push_back( derivative );
   
@@ -208,31 +224,69 @@ public:
             }
         }
         
-        if(hasNotes)
+        for(int i=0; i<notes.size(); i++)
         {
-            //TODO: create the OSC message to send the notes.
-            hasNotes = false;
             ci::osc::Message msg;
             msg.setAddress(MIDINOTE_OSCMESSAGE);
             msg.append(bodyPartID);
-            msg.append(note.pitch);
+            msg.append(notes[i].pitch);
+            if(LatencyTracer::get().isAppendingOrigin())
+                msg.append(noteReceived[i]);
             msgs.push_back(msg);
         }
+        notes.clear();
+        noteReceived.clear();
         return msgs;
     };
     
+    //false if no peak this frame -- see LatencyTrace.h
+    bool getPeakTrace(LatencyTrace &trace)
+    {
+        if( !bodyPartInit || !peaks->getCombinedPeak() ) return false;
+        trace = peaks->getPeakTrace();
+        return true;
+    };
+    
+    //adds this frame's onsets, see FindPeaks::getOnsets()
+    void getPeakOnsets(std::vector<PeakOnset> &onsets)
+    {
+        if( !bodyPartInit ) return;
+        const std::vector<PeakOnset> &mine = peaks->getOnsets();
+        onsets.insert(onsets.end(), mine.begin(), mine.end());
+    };
+    
+    //adds the onsets taken back this frame, see FindPeaks::getRetractions()
+    void getPeakRetractions(std::vector<PeakOnset> &retractions)
+    {
+        if( !bodyPartInit ) return;
+        const std::vector<PeakOnset> &mine = peaks->getRetractions();
+        retractions.insert(retractions.end(), mine.begin(), mine.end());
+    };
+    
+    //see FindPeaks::setPrediction()
+    void setPeakPrediction(const PeakPrediction &p)
+    {
+        if( bodyPartInit ) peaks->setPrediction(p);
+    };
+    
+    //see FindPeaks::setOSCTimeOffset()
+    void setOnsetTimeOffset(double offset)
+    {
+        if( bodyPartInit ) peaks->setOSCTimeOffset(offset);
+    };
+    
     //this is mostly just for calibration since during normal use we would just send OSC somewhere -- well it depends.
     bool peak()
     {
         //is there a peak at this body part?
 //        this tests the peak -- the count is to differentiate it from the last peak
-        bool aPeak = peaks->getCombinedPeak();
-        if( aPeak )
+        const std::vector<PeakOnset> &onsets = peaks->getOnsets();
+        for(int i=0; i<onsets.size(); i++)
         {
-            std::cout << whichBodyPart << " peak:" << count << std::endl ;
+            std::cout << whichBodyPart << " peak:" << count << " at " << onsets[i].time << std::endl ;
             count++;
         }
-        return aPeak;
+        return onsets.size() > 0;
     }
     
     void setPeakThresh(float x, float y, float z)
@@ -257,16 +311,38 @@ public:
             bodyPart[i]->update(seconds);
         }
         
-        //send the midi notes
-        if(peaks->getCombinedPeak() && melodyGenerator)
+        takeNotes();
+    };
+    
+    //same as update() but as part of a graph -- returns the node that takes the notes, which is the last thing we do
+    //label: to tell the entities apart in the profile
+    int addToGraph(UGENGraph &graph, const std::string &label = "")
+    {
+        std::string part = label + whichBodyPart + "/";
+        for(int i=0; i<bodyPart.size(); i++){
+            graph.add(bodyPart[i], part);
+        }
+        
+        int notes = graph.addTask([this](float seconds){ takeNotes(); }, part + "takeNotes");
+        graph.addDependency(notes, peaks);
+        graph.addDependency(notes, melodyGenerator);
+        return notes;
+    };
+    
+    //once the ugens are updated
+    void takeNotes()
+    {
+        //send the midi notes -- a note for each onset, the ones generated since the last in order (the last again if it runs out)
+        const std::vector<PeakOnset> &onsets = peaks->getOnsets();
+        if(onsets.size() > 0 && melodyGenerator)
         {
             if(((CabaretMelodyGenerator *)melodyGenerator)->hasArmHeight())
             {
-                std::vector<MidiNote> notes = melodyGenerator->getCurNotes();
-                if(notes.size()>0)
+                std::vector<MidiNote> generated = melodyGenerator->getCurNotes();
+                for(int i=0; i<onsets.size() && generated.size()>0; i++)
                 {
-                    hasNotes = true;
-                    note = notes[0];
+                    notes.push_back( generated[ std::min(i, int(generated.size())-1) ] );
+                    noteReceived.push_back( onsets[i].received );
                 }
             }
         }
@@ -279,6 +355,7 @@ public:
     {
     protected:
         std::vector<BodyPartSensor * > bodyParts; //assuming sensor is measuring some body part
+        std::vector<int> bodyPartIndices; //index in bodyParts by body part name id (see NameInterner::bodyPartNames()), -1 if none
         NotchBoneFigure *figure;
         std::vector<FigureMeasure * > figureMeasures;
         ArmHeight *armHeight;
@@ -303,23 +380,24 @@ public:
             figureMeasures.push_back(armHeight);
 
         }
+        
+        //the body parts are the pipeline's, it deletes them
+        virtual ~Entity()
+        {
+            for(int i=0; i<figureMeasures.size(); i++)
+                delete figureMeasures[i];
+            delete figure;
+        }
         bool bodyPartExists(std::string whichPart)
         {
             return bodyPartIndex(whichPart)!=-1;
         }
         
-        int bodyPartIndex(std::string whichPart)
+        int bodyPartIndex(const std::string &whichPart)
         {
-            int i=0;
-            bool found = false;
-            while (i < bodyParts.size() && !found)
-            {
-                found = !whichPart.compare(bodyParts[i]->getWhichBodyPart());
-                i++;
-            }
-            if(found)
-                return i-1;
-            else return -1;
+            int nameID = NameInterner::bodyPartNames().find(whichPart);
+            if( nameID < 0 || nameID >= bodyPartIndices.size() ) return -1;
+            return bodyPartIndices[nameID];
         }
         
         void addBodyPart(BodyPartSensor *part)
@@ -336,6 +414,10 @@ public:
                 part->setArmHeightUGENandIsLeftArmForMelodyGenerator(armHeight, !part->getWhichBodyPart().compare("LeftHand"));
             }
             
+            int nameID = NameInterner::bodyPartNames().intern(part->getWhichBodyPart());
+            if( nameID >= bodyPartIndices.size() )
+                bodyPartIndices.resize(nameID+1, -1);
+            bodyPartIndices[nameID] = bodyParts.size();
             bodyParts.push_back(part);
             
         }
@@ -374,6 +456,27 @@ public:
                 figureMeasures[i]->update(seconds);
         };
         
+        //adds everything update() does to the graph, to be updated in the same order where it matters. name: the dancer,
+        //for the profile
+        void addToGraph(UGENGraph &graph, const std::string &name = "")
+        {
+            std::string label = name.empty() ? "" : name + "/";
+            std::vector<int> notes;
+            for(int i=0; i<bodyParts.size(); i++)
+                notes.push_back(bodyParts[i]->addToGraph(graph, label));
+            
+            graph.add(figure, label);
+            
+            for(int i=0; i<figureMeasures.size(); i++)
+            {
+                int measure = graph.add(figureMeasures[i], label);
+                
+                //the melody generators read the arm height from the last frame, so it waits until they have
+                for(int j=0; j<notes.size(); j++)
+                    graph.addDependency(measure, notes[j]);
+            }
+        };
+        
         void adjustPeakThreshes(std::string boneName, float xAmt, float yAmt, float zAmt )
         {
             int index = bodyPartIndex(boneName);
@@ -438,6 +541,29 @@ public:
             return msgs;
         };
         
+        //adds the body parts' onsets this frame, body part by body part
+        void getPeakOnsets(std::vector<PeakOnset> &onsets)
+        {
+            for (int i=0; i<bodyParts.size(); i++)
+                bodyParts[i]->getPeakOnsets(onsets);
+        };
+        
+        void getPeakRetractions(std::vector<PeakOnset> &retractions)
+        {
+            for (int i=0; i<bodyParts.size(); i++)
+                bodyParts[i]->getPeakRetractions(retractions);
+        };
+        
+        //adds the body parts' peaks this frame, for timing them -- see LatencyTrace.h
+        void getPeakTraces(std::vector<LatencyTrace> &traces)
+        {
+            LatencyTrace trace;
+            for (int i=0; i<bodyParts.size(); i++)
+            {
+                if( bodyParts[i]->getPeakTrace(trace) ) traces.push_back(trace);
+            }
+        };
+        
         //do all the drawing here.
         virtual void draw()
         {
@@ -0,0 +1,239 @@
+//
+//  MocapDataPool.h
+//  VideoAndOSCLab
+//
+//  A slab/pool allocator for MocapDeviceData samples. Every sensor and every output ugen owns one of these so that
+//  incoming samples & filter outputs are recycled instead of new'd and deleted every frame.
+//  Samples are allocated in slabs (arrays) of one sample type and handed out from a free list. Releasing a sample
+//  puts it back on the free list of the pool it came from. Once the buffers are full, the pool stops touching the heap.
+//
+
+#ifndef MocapDataPool_h
+#define MocapDataPool_h
+
+#include <atomic>
+
+namespace CRCPMotionAnalysis {
+
+#define MOCAPDATAPOOL_DEFAULT_SLAB_SIZE 256
+
+//counts for the allocation stats -- these are totals over every pool in the program. Atomic, as the entities are updated on
+//several threads at once (see MotionAnalysisPipeline::update())
+class MocapDataPoolStats
+{
+public:
+    static std::atomic<long> &slabAllocations() //how many times any pool has gone to the heap for a new slab
+    {
+        static std::atomic<long> count(0);
+        return count;
+    };
+
+    static long &threadSlabAllocations() //same, but only the ones on the calling thread -- see ScopedProfile
+    {
+        static thread_local long count = 0;
+        return count;
+    };
+
+    static std::atomic<long> &samplesAcquired()
+    {
+        static std::atomic<long> count(0);
+        return count;
+    };
+
+    static std::atomic<long> &samplesReleased()
+    {
+        static std::atomic<long> count(0);
+        return count;
+    };
+
+    //call once per frame -- keeps track of how many slabs were allocated during the last frame (should be 0 in steady state)
+    static long endFrame()
+    {
+        static long lastCount = 0;
+        lastFrameSlabAllocations() = slabAllocations() - lastCount;
+        lastCount = slabAllocations();
+        return lastFrameSlabAllocations();
+    };
+
+    static long &lastFrameSlabAllocations()
+    {
+        static long count = 0;
+        return count;
+    };
+
+    static void print()
+    {
+        std::cout << "Sample pools -- slab allocations: " << slabAllocations() << " (last frame: " << lastFrameSlabAllocations() << ")"
+                  << " acquired: " << samplesAcquired() << " released: " << samplesReleased()
+                  << " live: " << samplesAcquired() - samplesReleased() << std::endl;
+    };
+};
+
+//the slabs for one type of sample, eg. NotchDeviceData
+class MocapDeviceDataSlabs
+{
+public:
+    virtual ~MocapDeviceDataSlabs(){};
+    virtual MocapDeviceData *acquire() = 0;
+    virtual void release(MocapDeviceData *sample) = 0;
+    virtual int getSlabCount() = 0;
+    virtual int getFreeCount() = 0;
+};
+
+template<class SampleType>
+class MocapDeviceDataSlabsOf : public MocapDeviceDataSlabs
+{
+protected:
+    std::vector<SampleType *> slabs;
+    std::vector<MocapDeviceData *> freeList;
+    int slabSize;
+    MocapDeviceDataPool *owner;
+
+    void grow()
+    {
+        SampleType *slab = new SampleType[slabSize];
+        slabs.push_back(slab);
+        freeList.reserve(slabs.size() * slabSize); //only grows when the slabs do
+        for(int i=slabSize-1; i>=0; i--)
+        {
+            slab[i].setOwnerPool(owner);
+            freeList.push_back(&slab[i]);
+        }
+        MocapDataPoolStats::slabAllocations()++;
+        MocapDataPoolStats::threadSlabAllocations()++;
+    };
+
+public:
+    MocapDeviceDataSlabsOf(MocapDeviceDataPool *owner_, int slabSize_)
+    {
+        owner = owner_;
+        slabSize = slabSize_;
+    };
+
+    virtual ~MocapDeviceDataSlabsOf()
+    {
+        for(int i=0; i<slabs.size(); i++)
+            delete [] slabs[i];
+    };
+
+    virtual MocapDeviceData *acquire()
+    {
+        if(freeList.empty())
+            grow();
+        MocapDeviceData *sample = freeList.back();
+        freeList.pop_back();
+        sample->reset();
+        return sample;
+    };
+
+    virtual void release(MocapDeviceData *sample)
+    {
+        freeList.push_back(sample);
+    };
+
+    virtual int getSlabCount()
+    {
+        return slabs.size();
+    };
+
+    virtual int getFreeCount()
+    {
+        return freeList.size();
+    };
+};
+
+//hands out samples of the right type for each device
+//not thread-safe -- samples should be acquired and released on the same thread
+class MocapDeviceDataPool
+{
+protected:
+    MocapDeviceDataSlabs *slabs[3]; //indexed by MocapDeviceData::MocapDevice
+    int slabSize;
+
+    MocapDeviceDataSlabs *getSlabs(MocapDeviceData::MocapDevice device)
+    {
+        if(slabs[device] == NULL)
+        {
+            if(device == MocapDeviceData::MocapDevice::NOTCH)
+                slabs[device] = new MocapDeviceDataSlabsOf<NotchDeviceData>(this, slabSize);
+            else if(device == MocapDeviceData::MocapDevice::IPHONE)
+                slabs[device] = new MocapDeviceDataSlabsOf<IPhoneDeviceData>(this, slabSize);
+            else
+                slabs[device] = new MocapDeviceDataSlabsOf<MocapDeviceData>(this, slabSize);
+        }
+        return slabs[device];
+    };
+
+public:
+    MocapDeviceDataPool(int slabSize_ = MOCAPDATAPOOL_DEFAULT_SLAB_SIZE)
+    {
+        slabSize = slabSize_;
+        for(int i=0; i<3; i++)
+            slabs[i] = NULL;
+    };
+
+    ~MocapDeviceDataPool()
+    {
+        for(int i=0; i<3; i++)
+        {
+            if(slabs[i] != NULL)
+                delete slabs[i];
+        }
+    };
+
+    //the default is the wiimote, which is the plain MocapDeviceData -- also what the filters output
+    MocapDeviceData *acquire(MocapDeviceData::MocapDevice device = MocapDeviceData::MocapDevice::WIIMOTE)
+    {
+        MocapDataPoolStats::samplesAcquired()++;
+        return getSlabs(device)->acquire();
+    };
+
+    void release(MocapDeviceData *sample)
+    {
+        if(sample == NULL) return;
+
+        if(sample->getOwnerPool() != this)
+        {
+            recycle(sample); //it's from somewhere else so send it back there
+            return;
+        }
+        MocapDataPoolStats::samplesReleased()++;
+        getSlabs(sample->getDeviceType())->release(sample);
+    };
+
+    //gives the sample back to whatever pool it came from or deletes it if it didn't come from a pool
+    static void recycle(MocapDeviceData *sample)
+    {
+        if(sample == NULL) return;
+
+        if(sample->getOwnerPool() != NULL)
+            sample->getOwnerPool()->release(sample);
+        else delete sample;
+    };
+
+    int getSlabCount()
+    {
+        int count = 0;
+        for(int i=0; i<3; i++)
+        {
+            if(slabs[i] != NULL)
+                count += slabs[i]->getSlabCount();
+        }
+        return count;
+    };
+
+    int getFreeCount()
+    {
+        int count = 0;
+        for(int i=0; i<3; i++)
+        {
+            if(slabs[i] != NULL)
+                count += slabs[i]->getFreeCount();
+        }
+        return count;
+    };
+};
+
+};
+
+#endif /* MocapDataPool_h */
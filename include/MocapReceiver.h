@@ -0,0 +1,801 @@
+//
+//  MocapReceiver.h
+//  VideoAndOSCLab
+//
+//  Receives the mocap OSC (Notch, Syntien/iPhone & wiimotes) on its own thread & hands the samples to the main thread
+//  through lock-free queues, one queue per sensor. The receiving thread never locks or allocates: it reads each packet
+//  in place (see OSCPacket.h), decodes the samples into fixed-size records & pushes them onto the queue of their sensor.
+//  update() then drains all the queues at once at the start of the frame, so the sensors & ugens are only ever touched by
+//  the main thread.
+//
+//  Sensors are created by the main thread. Until a sensor has a queue, its samples go on a shared 'announcement' queue;
+//  the main thread creates the sensor when it sees the first one & publishes a route so the following samples go
+//  straight to the sensor's queue.
+//
+//  If a queue is full, the sample is dropped & counted -- see printStats().
+//
+
+#ifndef MocapReceiver_h
+#define MocapReceiver_h
+
+#include <thread>
+#include <chrono>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+namespace CRCPMotionAnalysis {
+
+#define MOCAP_NAME_MAX 32 //longest bone/device name, incl. the null
+#define MOCAP_RECORD_VALUE_MAX 12 //accel, bone angles, relative angles & angular velocity
+#define MOCAPRECEIVER_ROUTE_COUNT 512 //max sensors -- power of 2
+#define MOCAPRECEIVER_INBOX_SIZE 256 //samples waiting per sensor
+#define MOCAPRECEIVER_ANNOUNCE_SIZE 1024
+#define MOCAPRECEIVER_PACKET_QUEUE_SIZE 64
+#define WEKINATOR_VALUE_MAX 256
+#define OSC_UDP_PACKET_MAX 65536
+#define NOTCH_SCHEMA_SENDER_MAX 8
+#define NOTCH_SCHEMA_BONE_MAX 64
+#define NOTCH_SCHEMA_TAGS_MAX 1024
+#define NOTCH_DATA_ID 9 //the sensor # of the first dancer's notch bones -- the next dancer's are 10, & so on (see MocapReceiver::notchWhich())
+#define MOCAPRECEIVER_WHO_MAX 32 //dancers (notch senders) told apart -- any more share the last sensor #
+
+//one sample, as it came in
+class MocapSampleRecord
+{
+public:
+    char name[MOCAP_NAME_MAX]; //device id, eg. bone name or wiimote #
+    int which;
+    char who[MOCAP_NAME_MAX]; //the dancer -- the notch sender, empty for phones & wiimotes
+    MocapDeviceData::MocapDevice device;
+    MocapDeviceData::SendingDevice sendingDevice;
+    float values[MOCAP_RECORD_VALUE_MAX];
+    int valueCount;
+    double receiveTime; //MocapReceiver::now() when the packet arrived
+
+    //false if it had to be cut short
+    bool setName(const char *s, int len)
+    {
+        bool fits = len < MOCAP_NAME_MAX;
+        if( !fits ) len = MOCAP_NAME_MAX - 1;
+        memcpy(name, s, len);
+        name[len] = '\0';
+        return fits;
+    };
+};
+
+//the values sent on to wekinator for one notch packet
+class WekinatorFrame
+{
+public:
+    float values[WEKINATOR_VALUE_MAX];
+    int count;
+    double receiveTime;
+};
+
+//where one sensor's samples wait for the main thread
+class MocapSensorInbox
+{
+public:
+    SPSCQueue<MocapSampleRecord> samples;
+    SensorData *sensor; //only for the main thread
+    long reportedOverflows; //main thread -- for warning about new overflows
+
+    MocapSensorInbox(SensorData *s) : samples(MOCAPRECEIVER_INBOX_SIZE)
+    {
+        sensor = s;
+        reportedOverflows = 0;
+    };
+};
+
+//finds the inbox for (name, which, sending device) -- read by the receiving thread, written only by the main thread.
+//routes are never removed, so the receiving thread can read without a lock: an entry is filled in first & only then
+//published by setting its inbox
+class MocapRouteTable
+{
+protected:
+    class Route
+    {
+    public:
+        char name[MOCAP_NAME_MAX];
+        int which;
+        MocapDeviceData::SendingDevice sendingDevice;
+        std::atomic<MocapSensorInbox *> inbox;
+    };
+    Route routes[MOCAPRECEIVER_ROUTE_COUNT];
+
+    static unsigned int hash(const char *name, int which, MocapDeviceData::SendingDevice sendingDevice)
+    {
+        unsigned int h = 2166136261u; //FNV-1a
+        for(const char *c = name; *c != '\0'; c++)
+        {
+            h ^= (unsigned char) *c;
+            h *= 16777619u;
+        }
+        h ^= (unsigned int) which * 2654435761u;
+        h ^= (unsigned int) sendingDevice << 28;
+        return h;
+    };
+
+public:
+    MocapRouteTable()
+    {
+        for(int i=0; i<MOCAPRECEIVER_ROUTE_COUNT; i++)
+            routes[i].inbox.store(NULL);
+    };
+
+    //either thread -- NULL if there is no route yet
+    MocapSensorInbox *find(const char *name, int which, MocapDeviceData::SendingDevice sendingDevice) const
+    {
+        unsigned int h = hash(name, which, sendingDevice);
+        for(int probe=0; probe<MOCAPRECEIVER_ROUTE_COUNT; probe++)
+        {
+            const Route &r = routes[(h + probe) & (MOCAPRECEIVER_ROUTE_COUNT-1)];
+            MocapSensorInbox *inbox = r.inbox.load(std::memory_order_acquire);
+            if( inbox == NULL ) return NULL; //end of the chain
+            if( r.which == which && r.sendingDevice == sendingDevice && strcmp(r.name, name) == 0 )
+                return inbox;
+        }
+        return NULL;
+    };
+
+    //main thread only -- false if the table is full
+    bool add(const char *name, int which, MocapDeviceData::SendingDevice sendingDevice, MocapSensorInbox *inbox)
+    {
+        unsigned int h = hash(name, which, sendingDevice);
+        for(int probe=0; probe<MOCAPRECEIVER_ROUTE_COUNT; probe++)
+        {
+            Route &r = routes[(h + probe) & (MOCAPRECEIVER_ROUTE_COUNT-1)];
+            if( r.inbox.load(std::memory_order_relaxed) != NULL ) continue;
+
+            strncpy(r.name, name, MOCAP_NAME_MAX-1);
+            r.name[MOCAP_NAME_MAX-1] = '\0';
+            r.which = which;
+            r.sendingDevice = sendingDevice;
+            r.inbox.store(inbox, std::memory_order_release); //publish
+            return true;
+        }
+        return false;
+    };
+};
+
+//the layout of one sender's notch messages: where each measured bone's name & floats are, relative to the first bone.
+//Only the receiving thread uses these
+class NotchSchema
+{
+public:
+    class Bone
+    {
+    public:
+        char name[MOCAP_NAME_MAX];
+        int nameLength;
+        int nameOffset;
+        int floatOffset;
+        int valueCount;
+        MocapSensorInbox *inbox; //where its samples go, once the main thread has created the sensor
+    };
+
+    char sender[MOCAP_NAME_MAX];
+    char sendingDeviceName[MOCAP_NAME_MAX];
+    MocapDeviceData::SendingDevice sendingDevice;
+    int which; //the sensor # for the sender's bones
+
+    char typeTags[NOTCH_SCHEMA_TAGS_MAX]; //from the first bone on
+    int typeTagLength;
+    int size; //bytes from the first bone to the end of the message
+    Bone bones[NOTCH_SCHEMA_BONE_MAX];
+    int boneCount;
+    bool valid;
+
+    NotchSchema()
+    {
+        sender[0] = '\0';
+        sendingDeviceName[0] = '\0';
+        sendingDevice = MocapDeviceData::SendingDevice::UNSPECIFIED;
+        which = NOTCH_DATA_ID;
+        valid = false;
+        boneCount = 0;
+    };
+
+    bool isFrom(const char *sender_, const char *sendingDeviceName_) const
+    {
+        //long names are kept cut short, so only compare what was kept
+        return strncmp(sender, sender_, MOCAP_NAME_MAX-1) == 0 && strncmp(sendingDeviceName, sendingDeviceName_, MOCAP_NAME_MAX-1) == 0;
+    };
+
+    //same bones in the same places? tags & bones point at the first bone's type tag & data
+    bool matches(const char *tags, const char *bonesData, const char *end) const
+    {
+        if( !valid || end - bonesData != size ) return false;
+        if( memcmp(typeTags, tags, typeTagLength + 1) != 0 ) return false;
+        for(int i=0; i<boneCount; i++)
+        {
+            if( memcmp(bonesData + bones[i].nameOffset, bones[i].name, bones[i].nameLength + 1) != 0 )
+                return false;
+        }
+        return true;
+    };
+
+    //starts over
+    void learn(const char *tags)
+    {
+        boneCount = 0;
+        typeTagLength = strlen(tags);
+        valid = typeTagLength < NOTCH_SCHEMA_TAGS_MAX;
+        if( valid ) memcpy(typeTags, tags, typeTagLength + 1);
+    };
+
+    void addBone(const char *name, int nameLength, int nameOffset, int floatOffset, int valueCount)
+    {
+        if( boneCount >= NOTCH_SCHEMA_BONE_MAX )
+        {
+            valid = false;
+            return;
+        }
+        Bone &b = bones[boneCount++];
+        memcpy(b.name, name, nameLength + 1);
+        b.nameLength = nameLength;
+        b.nameOffset = nameOffset;
+        b.floatOffset = floatOffset;
+        b.valueCount = valueCount;
+        b.inbox = NULL;
+    };
+
+    void finish(int size_)
+    {
+        size = size_;
+    };
+
+    void invalidate()
+    {
+        valid = false;
+    };
+};
+
+//one schema per sender (& sending device) -- only a handful of phones send at once
+class NotchSchemaCache
+{
+protected:
+    NotchSchema schemas[NOTCH_SCHEMA_SENDER_MAX];
+    int count;
+    int next; //which one to replace when all are taken
+public:
+    NotchSchemaCache()
+    {
+        count = 0;
+        next = 0;
+    };
+
+    NotchSchema *find(const char *sender, const char *sendingDeviceName)
+    {
+        for(int i=0; i<count; i++)
+        {
+            if( schemas[i].isFrom(sender, sendingDeviceName) ) return &schemas[i];
+        }
+        return NULL;
+    };
+
+    //the sender's schema, emptied, for learning -- reuses the sender's old one or takes the oldest if there is no room
+    NotchSchema *add(const char *sender, const char *sendingDeviceName)
+    {
+        NotchSchema *schema = find(sender, sendingDeviceName);
+        if( schema == NULL )
+        {
+            if( count < NOTCH_SCHEMA_SENDER_MAX ) schema = &schemas[count++];
+            else
+            {
+                schema = &schemas[next];
+                next = (next + 1) % NOTCH_SCHEMA_SENDER_MAX;
+            }
+            strncpy(schema->sender, sender, MOCAP_NAME_MAX-1);
+            schema->sender[MOCAP_NAME_MAX-1] = '\0';
+            strncpy(schema->sendingDeviceName, sendingDeviceName, MOCAP_NAME_MAX-1);
+            schema->sendingDeviceName[MOCAP_NAME_MAX-1] = '\0';
+            schema->sendingDevice = MocapDeviceData::sendingDeviceFromCString(sendingDeviceName);
+        }
+        schema->valid = false;
+        schema->boneCount = 0;
+        return schema;
+    };
+};
+
+class MocapReceiver
+{
+protected:
+    int port;
+    int socketID;
+    std::thread receiveThread;
+    std::atomic<bool> running;
+
+    MocapRouteTable routes;
+    std::vector<MocapSensorInbox *> inboxes; //main thread
+
+    SPSCQueue<MocapSampleRecord> announcements; //samples for sensors w/o a route yet
+    SPSCQueue<WekinatorFrame> wekinatorFrames;
+    SPSCQueue<OSCRawPacket> rawPackets;
+    std::atomic<SessionRecorder *> recorder; //records every packet, if set
+
+    //receiving thread's stats
+    std::atomic<long> packetsReceived;
+    std::atomic<long> malformedPackets;
+    std::atomic<long> oversizedPackets; //too big to pass on a raw copy
+    std::atomic<long> truncatedNames;
+    std::atomic<long> notchSchemaHits; //notch packets decoded w/the cached layout
+    std::atomic<long> notchSchemaLearned; //...& the ones it had to be learned (or relearned) from
+
+    NotchSchemaCache notchSchemas; //receiving thread
+    char whos[MOCAPRECEIVER_WHO_MAX][MOCAP_NAME_MAX]; //receiving thread -- the notch senders, in the order first heard
+    int whoCount;
+    int notchProbe, accelProbe; //for timing the listeners, see Profiler
+    long reportedAnnouncementOverflows; //main thread
+    long reportedPacketOverflows;
+
+    char buffer[OSC_UDP_PACKET_MAX]; //receiving thread
+
+    //------------------ receiving thread
+
+    void receiveLoop()
+    {
+        while( running.load() )
+        {
+            ssize_t size = recv(socketID, buffer, OSC_UDP_PACKET_MAX, 0);
+            if( size <= 0 ) continue; //timed out (so that we check running) or interrupted
+            handlePacket(buffer, (int) size, now());
+        }
+    };
+
+    //the sensor # for a notch sender's bones -- each dancer gets their own, so the same bone from 2 dancers is 2 sensors
+    int notchWhich(const char *sender)
+    {
+        for(int i=0; i<whoCount; i++)
+        {
+            if( strncmp(whos[i], sender, MOCAP_NAME_MAX-1) == 0 ) return NOTCH_DATA_ID + i;
+        }
+        if( whoCount >= MOCAPRECEIVER_WHO_MAX ) return NOTCH_DATA_ID + MOCAPRECEIVER_WHO_MAX - 1;
+
+        strncpy(whos[whoCount], sender, MOCAP_NAME_MAX-1);
+        whos[whoCount][MOCAP_NAME_MAX-1] = '\0';
+        return NOTCH_DATA_ID + whoCount++;
+    };
+
+    //sends the sample to its sensor's queue or announces it
+    void deliver(const MocapSampleRecord &record)
+    {
+        MocapSensorInbox *inbox = routes.find(record.name, record.which, record.sendingDevice);
+        if( inbox != NULL ) inbox->samples.push(record);
+        else announcements.push(record);
+    };
+
+    //the receiving thread's message handler -- see oscForEachMessage()
+    class MessageHandler
+    {
+    public:
+        MocapReceiver *receiver;
+        double receiveTime;
+        bool decodedAll; //false if any message was left for the main thread
+
+        void operator()(const OSCMessageReader &msg)
+        {
+            if( msg.addressIs(NOTCH_MESSAGE) )
+            {
+                ScopedProfile timer(receiver->notchProbe, 1);
+                receiver->decodeNotch(msg, receiveTime);
+            }
+            else if( msg.addressIs(SYNTIEN_MESSAGE) )
+            {
+                ScopedProfile timer(receiver->accelProbe, 1);
+                receiver->decodeAccel(msg, PHONE_ID, MocapDeviceData::MocapDevice::IPHONE, receiveTime);
+            }
+            else if( MocapReceiver::isWiimoteAccel(msg.getAddress()) )
+            {
+                ScopedProfile timer(receiver->accelProbe, 1);
+                char whichWii[2] = { msg.getAddress()[strlen(WIIMOTE_ACCEL_MESSAGE_PART1)], '\0' };
+                receiver->decodeAccel(msg, whichWii, MocapDeviceData::MocapDevice::WIIMOTE, receiveTime);
+            }
+            else decodedAll = false;
+        };
+    };
+
+    void handlePacket(const char *data, int size, double receiveTime)
+    {
+        packetsReceived.fetch_add(1, std::memory_order_relaxed);
+
+        MessageHandler handler;
+        handler.receiver = this;
+        handler.receiveTime = receiveTime;
+        handler.decodedAll = true;
+        if( !oscForEachMessage(data, size, handler) )
+            malformedPackets.fetch_add(1, std::memory_order_relaxed);
+
+        SessionRecorder *r = recorder.load(std::memory_order_acquire);
+        if( r != NULL ) r->record(data, size, receiveTime);
+
+        //pass on a copy for whatever we didn't decode here
+        if( !handler.decodedAll )
+        {
+            if( size > OSC_RAW_PACKET_MAX )
+            {
+                oversizedPackets.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            OSCRawPacket *packet = rawPackets.beginPush();
+            if( packet == NULL ) return; //full -- counted by the queue
+            memcpy(packet->data, data, size);
+            packet->size = size;
+            packet->receiveTime = receiveTime;
+            rawPackets.commitPush();
+        }
+    };
+
+    //3 floats of accel, from the phone or a wiimote
+    void decodeAccel(const OSCMessageReader &msg, const char *name, MocapDeviceData::MocapDevice device, double receiveTime)
+    {
+        MocapSampleRecord record;
+        record.setName(name, strlen(name));
+        record.which = atoi(name);
+        record.who[0] = '\0';
+        record.device = device;
+        record.sendingDevice = MocapDeviceData::SendingDevice::UNSPECIFIED;
+        record.receiveTime = receiveTime;
+        record.valueCount = 0;
+
+        OSCArgReader arg = msg.getArgs();
+        while( !arg.atEnd() && record.valueCount < 3 )
+        {
+            if( arg.getType() != 'f' )
+            {
+                malformedPackets.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            record.values[record.valueCount++] = arg.readFloat();
+        }
+        if( record.valueCount < 3 || !arg.isValid() ) return;
+        deliver(record);
+    };
+
+    /*** format of the notch OSC message
+     0. sender (who)
+     1. sending device, eg. "iOS" or "Android"
+     2. frame
+
+     Then for each bone:
+     Bone name (eg, Root)
+     acceleration - x, y, z
+     then the different angles for each bone, for example the chest: 1. anterior/posterior tilt,  2. rotation left or right, and 3. lateral tilt -  left & right
+     then (in newer versions of the app) the angles relative to the parent bone & the angular velocity
+
+     Only measured bones have all 6+ values. Static bones w.o notches attached are reported but only have position info
+     The measured bones' values also go to wekinator
+
+     The bones & their number of values don't change from packet to packet, so the layout is learned from a sender's first
+     packet (see NotchSchema) & after that the floats are read straight from where the schema says they are.
+     ***/
+    void decodeNotch(const OSCMessageReader &msg, double receiveTime)
+    {
+        OSCArgReader arg = msg.getArgs();
+        int senderLength, deviceLength;
+        if( arg.getType() != 's' ) { malformedPackets.fetch_add(1, std::memory_order_relaxed); return; }
+        const char *sender = arg.readString(senderLength); //who -- the dancer
+        if( arg.getType() != 's' ) { malformedPackets.fetch_add(1, std::memory_order_relaxed); return; }
+        const char *sendingDeviceName = arg.readString(deviceLength);
+        if( !arg.atEnd() ) arg.skip(); //frame
+        if( !arg.isValid() ) { malformedPackets.fetch_add(1, std::memory_order_relaxed); return; }
+
+        NotchSchema *schema = notchSchemas.find(sender, sendingDeviceName);
+
+        WekinatorFrame *wek = SEND_TO_WEKINATOR ? wekinatorFrames.beginPush() : NULL;
+        if( wek != NULL )
+        {
+            wek->count = 0;
+            wek->receiveTime = receiveTime;
+        }
+
+        if( schema != NULL && schema->matches(arg.getTypeTag(), arg.getPosition(), msg.getEnd()) )
+        {
+            decodeNotchWithSchema(*schema, arg.getPosition(), wek, receiveTime);
+            notchSchemaHits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            //new sender or the bones changed -- (re)learn the layout while decoding this one the long way
+            schema = notchSchemas.add(sender, sendingDeviceName);
+            schema->which = notchWhich(schema->sender);
+            decodeNotchAndLearn(*schema, arg, wek, receiveTime);
+            notchSchemaLearned.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if( wek != NULL ) wekinatorFrames.commitPush();
+    };
+
+    //the fast path -- the floats go straight from the packet into the sensors' queue slots & the wekinator frame
+    void decodeNotchWithSchema(NotchSchema &schema, const char *bones, WekinatorFrame *wek, double receiveTime)
+    {
+        for(int b=0; b<schema.boneCount; b++)
+        {
+            NotchSchema::Bone &bone = schema.bones[b];
+            if( bone.inbox == NULL ) //sensor not created yet? see if the main thread has done it since
+                bone.inbox = routes.find(bone.name, schema.which, schema.sendingDevice);
+
+            //the wekinator gets every bone, even one whose queue is full, so its features stay where they are
+            const char *p = bones + bone.floatOffset;
+            for(int i=0; wek != NULL && i<bone.valueCount && wek->count < WEKINATOR_VALUE_MAX; i++, p+=4)
+            {
+                uint32_t bits = oscReadUInt32(p);
+                memcpy(&wek->values[wek->count++], &bits, 4);
+            }
+
+            MocapSampleRecord announcement;
+            MocapSampleRecord *record = bone.inbox != NULL ? bone.inbox->samples.beginPush() : &announcement;
+            if( record == NULL ) continue; //queue full -- dropped & counted
+
+            memcpy(record->name, bone.name, bone.nameLength + 1);
+            record->which = schema.which;
+            memcpy(record->who, schema.sender, MOCAP_NAME_MAX);
+            record->device = MocapDeviceData::MocapDevice::NOTCH;
+            record->sendingDevice = schema.sendingDevice;
+            record->receiveTime = receiveTime;
+            record->valueCount = bone.valueCount;
+
+            p = bones + bone.floatOffset;
+            for(int i=0; i<bone.valueCount; i++, p+=4)
+            {
+                uint32_t bits = oscReadUInt32(p);
+                memcpy(&record->values[i], &bits, 4);
+            }
+
+            if( bone.inbox != NULL ) bone.inbox->samples.commitPush();
+            else announcements.push(announcement);
+        }
+    };
+
+    //the slow path -- walks through every argument & notes where everything is in the schema
+    void decodeNotchAndLearn(NotchSchema &schema, OSCArgReader &arg, WekinatorFrame *wek, double receiveTime)
+    {
+        const int NUMBER_OFVALUES_NEEDED_TOBE_LIVE = 6; //just sayin'
+
+        const char *bones = arg.getPosition();
+        schema.learn(arg.getTypeTag());
+
+        MocapSampleRecord record;
+        record.which = schema.which;
+        memcpy(record.who, schema.sender, MOCAP_NAME_MAX);
+        record.device = MocapDeviceData::MocapDevice::NOTCH;
+        record.sendingDevice = schema.sendingDevice;
+        record.receiveTime = receiveTime;
+
+        int len;
+        while( !arg.atEnd() )
+        {
+            if( arg.getType() != 's' )
+            {
+                arg.skip();
+                continue;
+            }
+            const char *bone = arg.readString(len);
+            if( !record.setName(bone, len) )
+                truncatedNames.fetch_add(1, std::memory_order_relaxed);
+
+            const char *floats = arg.getPosition();
+            int floatCount = 0;
+            record.valueCount = 0;
+            while( !arg.atEnd() && arg.getType() == 'f' )
+            {
+                float f = arg.readFloat();
+                if( record.valueCount < MOCAP_RECORD_VALUE_MAX )
+                    record.values[record.valueCount++] = f;
+                floatCount++;
+            }
+
+            if( floatCount >= NUMBER_OFVALUES_NEEDED_TOBE_LIVE ) //this is then, a measured value
+            {
+                deliver(record);
+                for(int i=0; wek != NULL && i<record.valueCount && wek->count < WEKINATOR_VALUE_MAX; i++)
+                    wek->values[wek->count++] = record.values[i];
+
+                if( len < MOCAP_NAME_MAX )
+                    schema.addBone(record.name, len, int(bone - bones), int(floats - bones), record.valueCount);
+                else schema.invalidate(); //would have to cut the name short every time
+            }
+        }
+
+        if( !arg.isValid() )
+        {
+            malformedPackets.fetch_add(1, std::memory_order_relaxed);
+            schema.invalidate();
+        }
+        else schema.finish( int(arg.getPosition() - bones) );
+    };
+
+public:
+    MocapReceiver(int port_) : running(false), announcements(MOCAPRECEIVER_ANNOUNCE_SIZE), wekinatorFrames(MOCAPRECEIVER_PACKET_QUEUE_SIZE),
+        rawPackets(MOCAPRECEIVER_PACKET_QUEUE_SIZE), recorder(NULL), packetsReceived(0), malformedPackets(0), oversizedPackets(0),
+        truncatedNames(0), notchSchemaHits(0), notchSchemaLearned(0)
+    {
+        port = port_;
+        socketID = -1;
+        reportedAnnouncementOverflows = 0;
+        reportedPacketOverflows = 0;
+        whoCount = 0;
+        notchProbe = Profiler::get().probe("receive/notch");
+        accelProbe = Profiler::get().probe("receive/accel");
+    };
+
+    ~MocapReceiver()
+    {
+        stop();
+        for(int i=0; i<inboxes.size(); i++)
+            delete inboxes[i];
+    };
+
+    // "/wii/" + one digit + "/accel/pry"
+    static bool isWiimoteAccel(const char *addr)
+    {
+        int len1 = strlen(WIIMOTE_ACCEL_MESSAGE_PART1);
+        return strncmp(addr, WIIMOTE_ACCEL_MESSAGE_PART1, len1) == 0 && addr[len1] >= '0' && addr[len1] < '0' + MAX_NUM_OF_WIIMOTES
+            && strcmp(addr + len1 + 1, WIIMOTE_ACCEL_MESSAGE_PART2) == 0;
+    };
+
+    //seconds on a steady clock -- the receive times of the samples
+    static double now()
+    {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now().time_since_epoch();
+        return d.count();
+    };
+
+    //opens the socket & starts the receiving thread -- false if the port couldn't be bound
+    bool start()
+    {
+        MocapDeviceData::sendingDeviceStrings(); //make sure these exist before the receiving thread looks at them
+        MocapDeviceData::availableSendingDevices();
+
+        socketID = socket(AF_INET, SOCK_DGRAM, 0);
+        if( socketID < 0 ) return false;
+
+        int yes = 1;
+        setsockopt(socketID, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        int bufferSize = 1 << 20; //room for bursts while the thread is busy
+        setsockopt(socketID, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000; //wake up to check whether we are still running
+        setsockopt(socketID, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if( bind(socketID, (struct sockaddr *) &addr, sizeof(addr)) < 0 )
+        {
+            close(socketID);
+            socketID = -1;
+            return false;
+        }
+
+        running.store(true);
+        receiveThread = std::thread(&MocapReceiver::receiveLoop, this);
+        return true;
+    };
+
+    void stop()
+    {
+        if( !running.load() ) return;
+        running.store(false);
+        if( receiveThread.joinable() ) receiveThread.join();
+        close(socketID);
+        socketID = -1;
+    };
+
+    //decodes a packet that didn't come over the network, eg. from SessionPlayer::playAsFastAsPossible(). Only while the
+    //receiver is stopped (or never started) -- the calling thread then takes the receiving thread's place
+    void injectPacket(const char *data, int size, double receiveTime)
+    {
+        handlePacket(data, size, receiveTime);
+    };
+
+    bool isRunning()
+    {
+        return running.load();
+    };
+
+    //the packets that weren't well-formed OSC, or had the wrong arguments
+    long getMalformedPacketCount()
+    {
+        return malformedPackets.load();
+    };
+
+    //records every packet from now on, or stops recording if NULL. Stop the receiver before deleting a recorder
+    void setRecorder(SessionRecorder *r)
+    {
+        recorder.store(r, std::memory_order_release);
+    };
+
+    //------------------ main thread
+
+    //gives the sensor its own queue -- returns the existing one if it already has one
+    MocapSensorInbox *addRoute(const MocapSampleRecord &record, SensorData *sensor)
+    {
+        MocapSensorInbox *inbox = routes.find(record.name, record.which, record.sendingDevice);
+        if( inbox != NULL ) return inbox;
+
+        inbox = new MocapSensorInbox(sensor);
+        if( !routes.add(record.name, record.which, record.sendingDevice, inbox) )
+        {
+            std::cout << "MocapReceiver: too many sensors, " << record.name << " will keep using the announcement queue\n";
+            delete inbox;
+            return NULL;
+        }
+        inboxes.push_back(inbox);
+        return inbox;
+    };
+
+    bool popAnnouncement(MocapSampleRecord &record)
+    {
+        return announcements.pop(record);
+    };
+
+    const std::vector<MocapSensorInbox *> &getInboxes()
+    {
+        return inboxes;
+    };
+
+    SPSCQueue<WekinatorFrame> &getWekinatorFrames()
+    {
+        return wekinatorFrames;
+    };
+
+    SPSCQueue<OSCRawPacket> &getRawPackets()
+    {
+        return rawPackets;
+    };
+
+    //prints a warning for any queue that dropped samples since the last check -- call once a frame
+    void warnAboutOverflows()
+    {
+        for(int i=0; i<inboxes.size(); i++)
+        {
+            long overflows = inboxes[i]->samples.getOverflowCount();
+            if( overflows > inboxes[i]->reportedOverflows )
+            {
+                std::cout << "MocapReceiver: dropped " << overflows - inboxes[i]->reportedOverflows << " samples for " << inboxes[i]->sensor->getDeviceID() << ", queue full\n";
+                inboxes[i]->reportedOverflows = overflows;
+            }
+        }
+        if( announcements.getOverflowCount() > reportedAnnouncementOverflows )
+        {
+            std::cout << "MocapReceiver: dropped " << announcements.getOverflowCount() - reportedAnnouncementOverflows << " samples from new sensors, queue full\n";
+            reportedAnnouncementOverflows = announcements.getOverflowCount();
+        }
+        long packetOverflows = rawPackets.getOverflowCount() + wekinatorFrames.getOverflowCount();
+        if( packetOverflows > reportedPacketOverflows )
+        {
+            std::cout << "MocapReceiver: dropped " << packetOverflows - reportedPacketOverflows << " packets for wekinator/the main thread, queue full\n";
+            reportedPacketOverflows = packetOverflows;
+        }
+    };
+
+    void printStats()
+    {
+        std::cout << "-------- MocapReceiver on port " << port << ": " << packetsReceived.load() << " packets, " << malformedPackets.load() << " malformed, "
+                  << oversizedPackets.load() << " too big to pass on, " << truncatedNames.load() << " names cut short\n";
+        std::cout << " notch packets: " << notchSchemaHits.load() << " decoded w/a cached layout, " << notchSchemaLearned.load() << " layouts learned\n";
+        std::cout << " new sensors queue: depth " << announcements.size() << "/" << announcements.getCapacity() << ", max " << announcements.getHighWater()
+                  << ", overflows " << announcements.getOverflowCount() << "\n";
+        std::cout << " raw packet queue: depth " << rawPackets.size() << "/" << rawPackets.getCapacity() << ", max " << rawPackets.getHighWater()
+                  << ", overflows " << rawPackets.getOverflowCount() << "\n";
+        std::cout << " wekinator queue: depth " << wekinatorFrames.size() << "/" << wekinatorFrames.getCapacity() << ", max " << wekinatorFrames.getHighWater()
+                  << ", overflows " << wekinatorFrames.getOverflowCount() << "\n";
+        for(int i=0; i<inboxes.size(); i++)
+        {
+            SPSCQueue<MocapSampleRecord> &q = inboxes[i]->samples;
+            std::cout << " " << inboxes[i]->sensor->getDeviceID() << ": depth " << q.size() << "/" << q.getCapacity() << ", max " << q.getHighWater()
+                      << ", samples " << q.getPushedCount() << ", overflows " << q.getOverflowCount() << "\n";
+        }
+        SessionRecorder *r = recorder.load();
+        if( r != NULL ) r->printStats();
+    };
+};
+
+};
+
+#endif /* MocapReceiver_h */
@@ -0,0 +1,171 @@
+//
+//  MocapRingBuffer.h
+//  VideoAndOSCLab
+//
+//  A fixed-capacity ring buffer of mocap samples, stored as a structure of arrays: each data channel (timestamp, accel,
+//  bone angles, relative angles, angular velocity, quaternion) is its own contiguous column. The sample pointers are kept
+//  in a column as well, for ugens that still want MocapDeviceData objects.
+//
+//  The ring is mirrored -- every sample is written twice, at i and i+capacity -- so the last N samples are always one
+//  contiguous run in every column. That way a window of the most recent samples is just a pointer + a count, never a copy.
+//
+
+#ifndef MocapRingBuffer_h
+#define MocapRingBuffer_h
+
+namespace CRCPMotionAnalysis {
+
+#define MOCAPRINGBUFFER_CHANNEL_COUNT (DEVICE_ARG_COUNT_MAX+1) //the data[] channels, indexed by MocapDeviceData::DataIndices
+#define MOCAPRINGBUFFER_QUATERNION_COUNT 4
+
+class MocapRingBuffer;
+
+//a view of the last size() samples in a MocapRingBuffer, oldest first
+//only valid until the next sample is pushed into the buffer
+class MocapSampleWindow
+{
+protected:
+    const MocapRingBuffer *ring;
+    int start; //index into the mirrored columns
+    int count;
+
+public:
+    MocapSampleWindow(const MocapRingBuffer *r = NULL, int s = 0, int c = 0)
+    {
+        ring = r;
+        start = s;
+        count = c;
+    };
+
+    inline int size() const { return count; };
+    inline bool empty() const { return count <= 0; };
+
+    //contiguous columns -- valid from [0] to [size()-1]
+    inline const float *column(int whichData) const;
+    inline const float *quaternionColumn(int which) const;
+    inline const double *timeStamps() const;
+    inline MocapDeviceData * const *samples() const;
+
+    inline MocapDeviceData *operator[](int i) const { return samples()[i]; };
+    inline MocapDeviceData * const *begin() const { return samples(); };
+    inline MocapDeviceData * const *end() const { return samples() + count; };
+
+    //the last n samples of this window
+    MocapSampleWindow last(int n) const
+    {
+        if( n >= count ) return *this;
+        if( n < 0 ) n = 0;
+        return MocapSampleWindow(ring, start + (count - n), n);
+    };
+};
+
+class MocapRingBuffer
+{
+protected:
+    int capacity;
+    int head;  //where the next sample goes, 0..capacity-1
+    int count; //how many valid samples, up to capacity
+    bool keepColumns; //false if only the sample pointers are kept
+
+    //each column is 2*capacity long, see the mirroring note at the top
+    std::vector<float> channels[MOCAPRINGBUFFER_CHANNEL_COUNT];
+    std::vector<float> quaternions[MOCAPRINGBUFFER_QUATERNION_COUNT];
+    std::vector<double> timeStamps; //doubles so that timestamps keep their precision over a long session
+    std::vector<MocapDeviceData *> samples;
+
+    friend class MocapSampleWindow;
+
+    inline void write(int i, MocapDeviceData *sample)
+    {
+        samples[i] = sample;
+        if( !keepColumns ) return;
+        
+        for(int c=0; c<MOCAPRINGBUFFER_CHANNEL_COUNT; c++)
+            channels[c][i] = (float) sample->getRawData(c);
+        for(int q=0; q<MOCAPRINGBUFFER_QUATERNION_COUNT; q++)
+            quaternions[q][i] = sample->getQuarternion(q);
+        timeStamps[i] = sample->getTimeStamp();
+    };
+
+public:
+    //keepColumns_ = false for a ring of sample pointers only, eg. for ugen outputs that may be modified after they are added
+    MocapRingBuffer(int capacity_, bool keepColumns_ = true)
+    {
+        capacity = capacity_;
+        head = 0;
+        count = 0;
+        keepColumns = keepColumns_;
+        samples.assign(capacity*2, NULL);
+        if( !keepColumns ) return;
+
+        for(int c=0; c<MOCAPRINGBUFFER_CHANNEL_COUNT; c++)
+            channels[c].assign(capacity*2, NO_DATA);
+        for(int q=0; q<MOCAPRINGBUFFER_QUATERNION_COUNT; q++)
+            quaternions[q].assign(capacity*2, NO_DATA);
+        timeStamps.assign(capacity*2, NO_DATA);
+    };
+
+    //adds a sample -- returns the sample that was pushed out of the buffer to make room, or NULL if nothing was
+    MocapDeviceData *push(MocapDeviceData *sample)
+    {
+        MocapDeviceData *evicted = NULL;
+        if( count == capacity )
+            evicted = samples[head];
+        else count++;
+
+        write(head, sample);
+        write(head+capacity, sample);
+        head = (head + 1) % capacity;
+
+        return evicted;
+    };
+
+    //the last n samples (or all of them, if there are fewer)
+    MocapSampleWindow window(int n) const
+    {
+        if( n > count ) n = count;
+        if( n < 0 ) n = 0;
+        return MocapSampleWindow(this, head + capacity - n, n);
+    };
+
+    //the most recent sample or NULL if empty
+    MocapDeviceData *newest() const
+    {
+        if( count == 0 ) return NULL;
+        return samples[head + capacity - 1];
+    };
+
+    inline int size() const { return count; };
+    inline int getCapacity() const { return capacity; };
+    inline bool hasColumns() const { return keepColumns; };
+};
+
+inline const float *MocapSampleWindow::column(int whichData) const
+{
+    assert( whichData >= 0 && whichData < MOCAPRINGBUFFER_CHANNEL_COUNT );
+    if( ring == NULL || !ring->keepColumns ) return NULL;
+    return ring->channels[whichData].data() + start;
+}
+
+inline const float *MocapSampleWindow::quaternionColumn(int which) const
+{
+    assert( which >= 0 && which < MOCAPRINGBUFFER_QUATERNION_COUNT );
+    if( ring == NULL || !ring->keepColumns ) return NULL;
+    return ring->quaternions[which].data() + start;
+}
+
+inline const double *MocapSampleWindow::timeStamps() const
+{
+    if( ring == NULL || !ring->keepColumns ) return NULL;
+    return ring->timeStamps.data() + start;
+}
+
+inline MocapDeviceData * const *MocapSampleWindow::samples() const
+{
+    if( ring == NULL ) return NULL; //an empty window
+    return ring->samples.data() + start;
+}
+
+};
+
+#endif /* MocapRingBuffer_h */
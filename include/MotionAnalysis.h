@@ -0,0 +1,75 @@
+//
+//  MotionAnalysis.h
+//  VideoAndOSCLab
+//
+//  Everything the motion analysis needs, in the order the headers depend on each other (they don't include each other).
+//  Needs no window or GL context for the analysis itself -- only the draw() functions use GL. For the app & the offline
+//  tools (src/offlineAnalysisMain.cpp etc.), which are built w/MOTIONANALYSIS_HEADLESS defined: then GL isn't included
+//  & the drawing compiles to nothing, so they link w/o a renderer (see the LamentAnalysis & lament-* targets).
+//
+
+#ifndef MotionAnalysis_h
+#define MotionAnalysis_h
+
+#include "cinder/Cinder.h"
+#ifndef MOTIONANALYSIS_HEADLESS
+#include "cinder/gl/gl.h"
+#endif
+#include "cinder/Log.h" //needed to log errors
+
+#include <sstream>
+#include <math.h>
+#include <algorithm>
+
+#include "Osc.h"
+
+#include "OSCAddresses.h"
+
+#include "Containers.h"
+#include "BeatTiming.h"
+#include "MotionCaptureData.h"
+#include "MocapDataPool.h"
+#include "Profiler.h"
+#include "LatencyTrace.h"
+#include "MocapRingBuffer.h"
+#include "Sensor.h"
+#include "SensorRegistry.h"
+#include "SPSCQueue.h"
+#include "OSCPacket.h"
+#include "SessionRecorder.h"
+#include "MocapReceiver.h"
+#include "SessionPlayer.h"
+#include "OSCBundleSender.h"
+#include "OSCFanOut.h"
+#include "MotionAnalysisOuput.h"
+#include "ForwardKinematics.h"
+#include "BatchForwardKinematics.h"
+#include "BatchPeakDetection.h"
+#include "UGENs.h"
+#include "WorkerPool.h"
+#include "UGENGraph.h"
+
+
+#include "PerceptualMappingScheme.h"
+#include "PerceptualSchemas.h"
+
+#include "Instruments.h"
+#include "MIDIUtility.h"
+//#include "MusicPlayer.h"
+//#include "ChordGeneration.h"
+#include "MelodyGeneratorAlgorithm.h"
+#include "MelodyGenerator.h"
+#include "PeakDetection.h"
+
+//#include "ExperimentalMusicPlayer.h"
+
+#include "FactorOracle.h"
+
+
+#include "MeasuredEntities.h"
+#include "SaveOSC.h"
+
+#include "MotionAnalysisPipeline.h"
+#include "OfflineAnalysis.h"
+
+#endif /* MotionAnalysis_h */
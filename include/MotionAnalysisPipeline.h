@@ -0,0 +1,343 @@
+//
+//  MotionAnalysisPipeline.h
+//  VideoAndOSCLab
+//
+//  The analysis from the received mocap OSC to the OSC it sends out -- the receiver, the sensors, the body parts & the
+//  entities (people) -- w/o a window, GL or a clock of its own. The app runs it live & OfflineAnalysisEngine runs it on
+//  a session's clock, & both step it the same way each frame:
+//      receive(seconds) -- adds what the receiving thread has queued to the sensors, time-stamped w/seconds
+//      update(seconds, msgs) -- updates the sensors & entities, then adds the OSC they send to msgs
+//  Wekinator frames & packets the receiver doesn't decode are left in the receiver's queues for whoever runs it.
+//
+//  There is one entity per dancer, made when their first sensor shows up: notch bones go to the entity of the notch
+//  sender (the "who" in the message), phones & wiimotes -- which don't say who -- to the first entity. update() runs all
+//  the entities' ugens as one graph (see UGENGraph) on a pool of worker threads, so each bone's chain & each dancer runs
+//  on its own, then adds the entities' OSC in the order they were made -- the same messages in the same order as if
+//  they were updated one at a time.
+//
+//  Each step is timed -- see Profiler. The ugens are timed by the graph, under the dancer's name. If the LatencyTracer is
+//  on, update() also collects the frame's peaks so that traceSent() can time them from packet to send.
+//  Every frame's onsets (see FindPeaks::getOnsets()) are collected too, all the dancers' in the order of their samples --
+//  getPeakOnsets().
+//
+
+#ifndef MotionAnalysisPipeline_h
+#define MotionAnalysisPipeline_h
+
+namespace CRCPMotionAnalysis {
+
+class MotionAnalysisPipeline
+{
+protected:
+    MocapReceiver receiver; //receives the mocap OSC on its own thread -- or use injectPacket() when stopped
+    SensorRegistry sensors; //all the sensors which have sent us OSC, found by id w/o searching the list
+    std::vector<BodyPartSensor *> bodyParts;  //who are we measuring? change name when specifics are known.
+    std::vector<Entity *> people;
+    std::unordered_map<std::string, int> peopleByWho; //index in people by the notch sender
+    std::vector<std::string> peopleNames; //for the profile
+    std::vector<int> getOSCProbes;
+    int receiveProbe, sensorsProbe, graphProbe;
+    std::vector<LatencyTrace> peakTraces; //this frame's peaks, if tracing
+    std::vector<PeakOnset> peakOnsets; //this frame's onsets from every body part, in time order
+    std::vector<PeakOnset> peakRetractions; //& the onsets taken back, see FindPeaks::setPrediction()
+    PeakPrediction peakPrediction; //every body part's, incl. the ones still to come
+    double onsetTimeOffset; //same, see setOnsetTimeOffset()
+    std::vector< std::vector<ci::osc::Message> > peopleMsgs; //each entity's OSC this frame, filled in in parallel
+    WorkerPool workers;
+    UGENGraph graph; //every entity's ugens -- rebuilt when a body part is added
+    bool graphChanged;
+
+    float seconds; //the time stamp for the samples being added
+
+    //adds one phone or wiimote sample (3 floats of accel) to its sensor
+    void addPhoneAndWiiData(SensorData *sensor, const float *vals, double receiveTime)
+    {
+        MocapDeviceData *sensorData = sensor->createSample(); //recycled from the sensor's pool
+
+        //set time stamp
+        sensorData->setData( MocapDeviceData::DataIndices::TIME_STAMP, seconds ); //set timestamp from program -- synch with call to update()
+        sensorData->setReceiveTime( receiveTime ); //& when it actually came in, for the latency
+
+        //add accel data
+        for(int i= 0; i<3; i++)
+            sensorData->setData(MocapDeviceData::DataIndices::ACCELX+i, vals[i]);
+
+        sensor->addSensorData(sensorData);
+    };
+
+    //adds one live notch bone sample -- accel, bone angles &, in newer versions of the app, relative angles & angular velocity
+    void createNotchMotionData(SensorData *sensor, const float *vals, int count, double receiveTime)
+    {
+        MocapDeviceData *sensorData = sensor->createSample(); //recycled from the sensor's pool
+
+        //set time stamp
+        sensorData->setData( MocapDeviceData::DataIndices::TIME_STAMP, seconds ); //set timestamp from program -- synch with call to update()
+        sensorData->setReceiveTime( receiveTime ); //& when it actually came in, for the latency
+
+        //add accel + bone position data
+        for(int i= 0; i<3; i++){
+            sensorData->setData(MocapDeviceData::DataIndices::ACCELX+i, vals[i]);
+            sensorData->setData(MocapDeviceData::DataIndices::BONEANGLE_TILT+i, vals[i+3]);
+            if(count >= 12) //make compatible with previous recordings... I guess
+            {
+                sensorData->setData(MocapDeviceData::DataIndices::RELATIVE_TILT+i, vals[i+6]);
+                sensorData->setData(MocapDeviceData::DataIndices::ANGVEL_TILT+i, vals[i+9]);
+            }
+        }
+
+        sensor->addSensorData(sensorData);
+    };
+
+    //adds a sample from the receiving thread to its sensor
+    void addSample(SensorData *sensor, const MocapSampleRecord &record)
+    {
+        if(record.device == MocapDeviceData::MocapDevice::NOTCH)
+            createNotchMotionData(sensor, record.values, record.valueCount, record.receiveTime);
+        else addPhoneAndWiiData(sensor, record.values, record.receiveTime);
+    };
+
+public:
+    //threads: the workers for updating the entities besides the calling thread, < 0 for one less than the cores
+    MotionAnalysisPipeline(int port, int threads = -1) : receiver(port), workers(threads)
+    {
+        seconds = 0;
+        onsetTimeOffset = 0;
+        graphChanged = false;
+        receiveProbe = Profiler::get().probe("frame/receive");
+        sensorsProbe = Profiler::get().probe("frame/sensors");
+        graphProbe = Profiler::get().probe("frame/ugens");
+    };
+
+    //the receiver stops before the sensors it fills go
+    ~MotionAnalysisPipeline()
+    {
+        receiver.stop();
+        for(int i=0; i<people.size(); i++)
+            delete people[i];
+        for(int i=0; i<bodyParts.size(); i++)
+            delete bodyParts[i];
+        for(int i=0; i<sensors.size(); i++)
+            delete sensors[i];
+    };
+
+    MocapReceiver &getReceiver() { return receiver; };
+    SensorRegistry &getSensors() { return sensors; };
+    std::vector<Entity *> &getPeople() { return people; };
+    std::vector<BodyPartSensor *> &getBodyParts() { return bodyParts; };
+    WorkerPool &getWorkers() { return workers; };
+    UGENGraph &getGraph() { return graph; };
+
+    //the entity for the dancer, made if it's new -- who is the notch sender, or empty for the sensors that don't say
+    Entity *getEntity(const std::string &who)
+    {
+        if( who.empty() && !people.empty() ) return people[0];
+
+        std::unordered_map<std::string, int>::iterator iter = peopleByWho.find(who);
+        if( iter != peopleByWho.end() ) return people[iter->second];
+
+        peopleByWho[who] = people.size();
+        people.push_back(new Entity());
+        peopleMsgs.resize(people.size());
+        peopleNames.push_back( who.empty() ? "phones" : who );
+        getOSCProbes.push_back( Profiler::get().probe(peopleNames.back() + "/getOSC") );
+        graphChanged = true;
+        if( people.size() > 1 ) std::cout << "New dancer: " << (who.empty() ? "(phones & wiimotes)" : who) << ", " << people.size() << " in all\n";
+        return people.back();
+    };
+
+    //the same for a dancer's body part every run, but different from the other dancers' & body parts'
+    unsigned int melodySeed(Entity *person, const std::string &part)
+    {
+        int i = std::find(people.begin(), people.end(), person) - people.begin();
+        return (unsigned int) std::hash<std::string>()( peopleNames[i] + "/" + part );
+    };
+
+    //return sensor with id & or create one w/detected id then return that one
+    SensorData *getSensor( const std::string &_id, int which, MocapDeviceData::MocapDevice device, MocapDeviceData::SendingDevice sDevice, const std::string &who = "" )
+    {
+        SensorData *found = sensors.find( _id, which, sDevice );
+
+        if(found != NULL)
+        {
+            return found;
+        }
+        else
+        {
+            SensorData *sensor = new SensorData( _id, which, device, sDevice );
+
+            sensors.add(sensor);
+
+            Entity *person = getEntity(who);
+
+            //okay now test if this body part already exists in the person
+            //this is bc do not want to use different sensors from the same bodypart (eg. chest) which
+            // bc it is a root bone will need to be duplicated across phones
+            //ergo this info will be discarded...
+            if(person->bodyPartExists(sensor->getDeviceID()))  //eg. the same dancer sending from 2 phones
+            {
+                std::cout << "Note that " << sensor->getDeviceID() << " exists already. Not using data from device ";
+                if (sDevice == MocapDeviceData::SendingDevice::ANDROID)
+                    std::cout << "Android\n";
+                else std::cout << "iOS\n";
+
+                return sensor;
+            }
+
+            //add to 'body part' the data structure which can combine sensors. It currently only has one body part so it is simple.
+
+            //TODO: check the UGEN / averaging sensor ID
+            int bodyPartID  = sensors.size()-1;
+            BodyPartSensor *bodyPart = new BodyPartSensor();
+            bodyPart->addSensor(bodyPartID, sensor, sDevice);  //note that this should change if using bones, etc.
+            bodyPart->setPeakPrediction(peakPrediction);
+            bodyPart->setOnsetTimeOffset(onsetTimeOffset);
+            bodyPart->seedMelodies( melodySeed(person, sensor->getDeviceID()) );
+            bodyParts.push_back(bodyPart);
+
+            person->addBodyPart(bodyPart);
+            graphChanged = true;
+
+            return sensor;
+        }
+    };
+
+    void printSensors()
+    {
+        std::cout << "-------- SensorList: \n";
+
+        for (SensorData *sensor : sensors)
+        {
+            if(sensor != NULL)
+            {
+                std::cout << "Bone: " << sensor->getDeviceID() ;
+                std::cout << " Sending Device: " << sensor->getSendingDeviceString() << std::endl ;
+            }
+        }
+    };
+
+    //takes the samples the receiving thread has queued since the last frame. Samples from sensors we haven't seen yet come
+    //first, so that the sensor is created (& gets its own queue) before any of its later samples are added
+    void receive(float seconds_)
+    {
+        seconds = seconds_;
+        ScopedProfile timer(receiveProbe);
+
+        MocapSampleRecord record;
+        while( receiver.popAnnouncement(record) )
+        {
+            SensorData *sensor = getSensor( record.name, record.which, record.device, record.sendingDevice, record.who );
+            receiver.addRoute(record, sensor);
+            addSample(sensor, record);
+        }
+
+        const std::vector<MocapSensorInbox *> &inboxes = receiver.getInboxes();
+        for(int i=0; i<inboxes.size(); i++)
+        {
+            const MocapSampleRecord *r;
+            while( (r = inboxes[i]->samples.front()) != NULL )
+            {
+                addSample(inboxes[i]->sensor, *r);
+                inboxes[i]->samples.popFront();
+            }
+        }
+
+        receiver.warnAboutOverflows();
+    };
+
+    //updates the sensors & entities for the time (seconds) & adds the OSC from the entities to msgs
+    void update(float seconds_, std::vector<ci::osc::Message> &msgs)
+    {
+        seconds = seconds_;
+
+        //update sensors
+        {
+            ScopedProfile timer(sensorsProbe);
+            for(int i=0; i<sensors.size(); i++)
+            {
+                sensors[i]->update(seconds);
+            }
+        }
+        //update all entities
+        if( graphChanged )
+        {
+            graph.clear();
+            for(int i=0; i<people.size(); i++)
+                people[i]->addToGraph(graph, peopleNames[i]);
+            graph.prepare();
+            graphChanged = false;
+        }
+        {
+            ScopedProfile timer(graphProbe);
+            graph.run(seconds, workers);
+        }
+
+        //& collect their OSC, each on whichever worker is free
+        workers.run(people.size(), [&](int i)
+        {
+            ScopedProfile timer(getOSCProbes[i]);
+            peopleMsgs[i] = people[i]->getOSC();
+            timer.setSamples(peopleMsgs[i].size());
+        });
+
+        //the OSC from the entities -- after all are updated, in order
+        for(int i=0; i<people.size(); i++)
+        {
+            msgs.insert(msgs.end(), peopleMsgs[i].begin(), peopleMsgs[i].end());
+        }
+
+        peakOnsets.clear();
+        for(int i=0; i<people.size(); i++)
+            people[i]->getPeakOnsets(peakOnsets);
+        std::stable_sort(peakOnsets.begin(), peakOnsets.end(), [](const PeakOnset &a, const PeakOnset &b){ return a.time < b.time; });
+        peakRetractions.clear();
+        for(int i=0; i<people.size(); i++)
+            people[i]->getPeakRetractions(peakRetractions);
+
+        peakTraces.clear();
+        if( LatencyTracer::get().isEnabled() )
+        {
+            for(int i=0; i<people.size(); i++)
+                people[i]->getPeakTraces(peakTraces);
+            for(int i=0; i<peakTraces.size(); i++)
+                LatencyTracer::get().detected(peakTraces[i]);
+        }
+    };
+
+    //the frame's onsets, every body part's together in the order of their samples -- see FindPeaks::getOnsets()
+    const std::vector<PeakOnset> &getPeakOnsets() { return peakOnsets; };
+    const std::vector<PeakOnset> &getPeakRetractions() { return peakRetractions; };
+
+    //fire the onsets before their peaks, for every body part -- see FindPeaks::setPrediction()
+    void setPeakPrediction(const PeakPrediction &p)
+    {
+        peakPrediction = p;
+        for(int i=0; i<bodyParts.size(); i++)
+            bodyParts[i]->setPeakPrediction(p);
+    };
+
+    //the onset times in the OSC (NOTCH_ONSET & NOTCH_ONSET_RETRACT) go out on the receiver's clock plus this -- the app
+    //gives it the receive clock offset, so they're getElapsedSeconds() like the rest. Offline they're the session's
+    void setOnsetTimeOffset(double offset)
+    {
+        onsetTimeOffset = offset;
+        for(int i=0; i<bodyParts.size(); i++)
+            bodyParts[i]->setOnsetTimeOffset(offset);
+    };
+
+    const PeakPrediction &getPeakPrediction() { return peakPrediction; };
+
+    //the frame's peaks, if tracing -- eg. for OSCFanOut::addTrace(), which times them when they're actually sent
+    const std::vector<LatencyTrace> &getPeakTraces() { return peakTraces; };
+
+    //call once the OSC from update() has been sent -- times the frame's peaks from detection & from the packet to now
+    void traceSent()
+    {
+        double sendTime = LatencyTracer::now();
+        for(int i=0; i<peakTraces.size(); i++)
+            LatencyTracer::get().sent(peakTraces[i], sendTime);
+    };
+};
+
+};
+
+#endif /* MotionAnalysisPipeline_h */
@@ -22,6 +22,7 @@
 
 namespace CRCPMotionAnalysis {
 
+class MocapDeviceDataPool; //see MocapDataPool.h -- samples remember which pool they came from
 
 class MocapDeviceData
 {
@@ -31,20 +32,60 @@ class MocapDeviceData
         float quaternion[4];
         float orientationMatrix[3];
         bool isAccelScaled;
+        double receiveTime; //when its packet arrived, on the receiver's clock (MocapReceiver::now()) -- 0 if not known. See LatencyTrace.h
     
         //the default is wiimote
         virtual double getAccelMax(){ return WIIMOTE_ACCELMAX; };
         virtual double getAccelMin(){ return WIIMOTE_ACCELMIN; };
     
         std::string mWho;
+    
+        MocapDeviceDataPool *mOwnerPool; //NULL if this sample was created w/new instead of from a pool
     public:
                                                                                                                 //see documentation of these angles in the main
         enum DataIndices { INDEX=0, TIME_STAMP=1, ACCELX=2, ACCELY=3, ACCELZ=4, GYROX=11, GYROY=12, GYROZ=13, BONEANGLE_TILT=14, BONEANGLE_ROTATE=15, BONEANGLE_LATERAL=16, RELATIVE_TILT=17, RELATIVE_ROTATE=18, RELATIVE_LATERAL=19, ANGVEL_TILT=20, ANGVEL_ROTATE=21, ANGVEL_LATERAL=22, QX=23, QY=24, QZ=25, QA=26 };
         enum MocapDevice { WIIMOTE=0, IPHONE=1, NOTCH=2 };
         enum SendingDevice { UNSPECIFIED=0, ANDROID=1, IOS=2 };
         //not SUPER happy about this schema -> basically if you want it to be unspecified DO NOT SET IT.
-        std::vector<std::string> mSendingDeviceStrings;
-        std::vector<SendingDevice> mAvailableSendingDevices;
+        //these are shared by all samples so that creating a sample does not allocate
+        static const std::vector<std::string> &sendingDeviceStrings()
+        {
+            static const std::vector<std::string> strs = {"Android", "iOS"};
+            return strs;
+        };
+    
+        static const std::vector<SendingDevice> &availableSendingDevices()
+        {
+            static const std::vector<SendingDevice> devices = { SendingDevice::ANDROID, SendingDevice::IOS };
+            return devices;
+        };
+    
+        //converts the sending device string from the OSC message, eg. "Android" -- returns UNSPECIFIED if not recognized
+        static SendingDevice sendingDeviceFromString(const std::string &sendingDevice)
+        {
+            const std::vector<std::string> &strs = sendingDeviceStrings();
+            auto iter = std::find(strs.begin(), strs.end(), sendingDevice);
+            int index = iter - strs.begin();
+            
+            if(index > strs.size()-1)
+            {
+                std::cout << "Warning! " << sendingDevice << " is not recognized by this system.\n";
+                return SendingDevice::UNSPECIFIED;
+            }
+            else return availableSendingDevices()[index];
+        };
+
+        //same, w/o allocating or printing, for the OSC receiving thread
+        static SendingDevice sendingDeviceFromCString(const char *sendingDevice)
+        {
+            const std::vector<std::string> &strs = sendingDeviceStrings();
+            for(int i=0; i<strs.size(); i++)
+            {
+                if( strcmp(strs[i].c_str(), sendingDevice) == 0 )
+                    return availableSendingDevices()[i];
+            }
+            return SendingDevice::UNSPECIFIED;
+        };
 
         MocapDevice getDeviceType()
         {
@@ -58,12 +99,24 @@ class MocapDeviceData
     
         void setSendingDevice(std::string sendingDevice)
         {
-            auto iter = std::find(mSendingDeviceStrings.begin(), mSendingDeviceStrings.end(), sendingDevice);
-            int index = iter - mSendingDeviceStrings.begin();
-            
-            if(index > mSendingDeviceStrings.size()-1)
-            std::cout << "Warning! " << sendingDevice << " is not recognized by this system.\n";
-            else mSendingDevice = mAvailableSendingDevices[index];
+            SendingDevice d = sendingDeviceFromString(sendingDevice);
+            if(d != SendingDevice::UNSPECIFIED)
+                mSendingDevice = d;
+        }
+    
+        void setSendingDevice(SendingDevice sendingDevice)
+        {
+            mSendingDevice = sendingDevice;
+        }
+    
+        MocapDeviceDataPool *getOwnerPool()
+        {
+            return mOwnerPool;
+        }
+    
+        void setOwnerPool(MocapDeviceDataPool *pool)
+        {
+            mOwnerPool = pool;
         }
     
         //scale accel to 0 - 1 -- obv. not needed if wiimote
@@ -88,6 +141,20 @@ class MocapDeviceData
             isAccelScaled = true;
         };
     
+        //the value as scaleAccel() would make it, w/o changing the sample -- for reading a buffer other ugens read too
+        double getScaledData(int index)
+        {
+            bool isScaled = ( index >= ACCELX && index <= ACCELZ ) || ( index >= BONEANGLE_TILT && index <= BONEANGLE_ROTATE );
+            if( isAccelScaled || !isScaled ) return getData(index);
+            return ( getData(index) - getAccelMin() )  / ( getAccelMax() - getAccelMin() );
+        };
+    
+        //whether scaleAccel() has been done to it
+        bool isScaled()
+        {
+            return isAccelScaled;
+        };
+    
         std::string toString()
         {
             std::stringstream sstr;
@@ -119,6 +186,8 @@ class MocapDeviceData
         };
         
         inline double getTimeStamp(){ return data[1]; };
+        inline double getReceiveTime(){ return receiveTime; };
+        inline void setReceiveTime(double t){ receiveTime = t; };
         inline ci::vec3 getAccelData()
         {
             ci::vec3 accelData(data[ACCELX], data[ACCELY], data[ACCELZ]);
@@ -164,6 +233,12 @@ class MocapDeviceData
             }
             
         }
+        //the stored value as-is, 0..DEVICE_ARG_COUNT_MAX -- unlike getData(), does not substitute the quaternion for 20-23
+        inline double getRawData(int index)
+        {
+            assert( index >= 0 && index <= DEVICE_ARG_COUNT_MAX );
+            return data[index];
+        }
         inline float getQuarternion(int index)
         {
             assert( index < 4 && index >= 0 );
@@ -203,6 +278,19 @@ class MocapDeviceData
         };
         
         MocapDeviceData()
+        {
+            device = MocapDevice::WIIMOTE;
+            mOwnerPool = NULL;
+            reset();
+        }
+    
+        virtual ~MocapDeviceData()
+        {
+        }
+    
+        //puts the sample back the way the constructor left it -- used when a pool recycles a sample
+        //note: the device type is fixed per sample class so it is not touched here
+        void reset()
         {
             //init memory
             for(int i=0; i<DEVICE_ARG_COUNT_MAX; i++)
@@ -216,12 +304,9 @@ class MocapDeviceData
             for(int i=0; i<3; i++ )
                 orientationMatrix[i] = NO_DATA;
             
-            device = MocapDevice::WIIMOTE;
             isAccelScaled = false;
-            
-            mSendingDeviceStrings = {"Android", "iOS"};
-            mAvailableSendingDevices = { SendingDevice::ANDROID, SendingDevice::IOS };
-            mSendingDevice = SendingDevice::UNSPECIFIED; 
+            receiveTime = 0;
+            mSendingDevice = SendingDevice::UNSPECIFIED;
         }
     
 protected:
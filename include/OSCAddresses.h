@@ -0,0 +1,48 @@
+//
+//  OSCAddresses.h
+//  VideoAndOSCLab
+//
+//  The OSC addresses the analysis sends & receives. Shared by the app & the offline analysis (see OfflineAnalysis.h),
+//  so include this before the rest of the headers -- the ports are in each main.
+//
+
+#ifndef OSCAddresses_h
+#define OSCAddresses_h
+
+//osc messages
+#define ELAPSED_FRAMES_ADDR "/VideoAndOSCLab/elapsedFrames"
+#define ELAPSED_SECS_ADDR "/VideoAndOSCLab/elapsedSeconds"
+#define SYNTIEN_MESSAGE "/syntien/motion/1/scope1"
+#define WIIMOTE_ACCEL_MESSAGE_PART1 "/wii/"
+#define WIIMOTE_ACCEL_MESSAGE_PART2 "/accel/pry"
+#define WIIMOTE_BUTTON_1 "/wii/1/button/1"
+#define NOTCH_MESSAGE "/Notch/BonePosAndAccel"
+#define NOTCH_PEAK "/Notch/Peak" //body part, id, is peak -- & the receive time (double) if the LatencyTracer is appending it
+#define NOTCH_ONSET "/Notch/Onset" //body part, id, axis (0-2 for x-z), the peak sample's time (double, the app's seconds -- see MotionAnalysisPipeline::setOnsetTimeOffset()), height (0-1) -- one per onset
+#define NOTCH_ONSET_RETRACT "/Notch/Onset/Retract" //body part, id, axis, the time it was sent w/-- a predicted onset whose peak didn't come, see FindPeaks::setPrediction()
+#define DERIVATIVE_OSCMESSAGE "/CBIS/Derivative"
+#define SIGAVG_OSCMESSAGE "/CBIS/Average"
+#define CI_OSCMESSAGE "/CBIS/CI" //send contraction index
+#define ARMHEIGHT_OSCMESSAGE "/CBIS/ArmHeight" //send relative arm height index
+#define VERTICALITY_OSCMESSAGE "/CBIS/Verticality" //send verticality
+#define MIDINOTE_OSCMESSAGE "/CBIS/MidiNote" //body part id, pitch -- & the receive time, same as NOTCH_PEAK
+#define STATS_OSCMESSAGE "/CBIS/Stats" //timing of the analysis, see ProfileReporter -- probe, calls, p50/p99/max us, samples, allocations
+
+
+#define SEND_TO_WEKINATOR 1
+#define WEK_MESSAGE "/wek/inputs"
+
+#define MAX_NUM_OF_WIIMOTES 6 //limitation of bluetooth class 2
+#define PHONE_ID "7" //this assumes only one phone using Syntien or some such -- can modify if you have more...
+
+//for sending busy spase to max 7
+#define BUSY_SPARSE_PERCUSSION "/InteractiveTango/BusySparse/Beats"
+#define BUSY_SPARSE_DANCERS "/InteractiveTango/BusySparse/Dancers"
+#define EXPMUSIC_HARMONY "/InteractiveTango/Experimental/Harmony"
+#define EXPMUSIC_INTROFILL "/InteractiveTango/Experimental/HarmonyIntroFill"
+#define EXPMUSIC_CLOSEFILL "/InteractiveTango/Experimental/HarmonyCloseFill"
+#define EXPMUSIC_MELODY_INSTRUMENT "/InteractiveTango/Experimental/Melody/Instrument"
+#define EXPMUSIC_ACCOMP_INSTRUMENT "/InteractiveTango/Experimental/Accompaniment/Instrument"
+#define EXPMUSIC_SECTION "/InteractiveTango/Experimental/Section"
+
+#endif /* OSCAddresses_h */
@@ -0,0 +1,275 @@
+//
+//  OSCBundleSender.h
+//  VideoAndOSCLab
+//
+//  The analysis' output, a frame at a time. Every ugen's OSC used to go out as its own tiny UDP datagram, hundreds a
+//  frame, each w/its own send. Now the frame's messages are added to the sender & sendFrame() packs them into as few
+//  OSC bundles as fit under the MTU (so nothing is fragmented), all w/the frame's time tag, & hands them to the kernel
+//  together -- w/sendmmsg() on linux, a sendto() each elsewhere. A message too big for a bundle of its own goes out bare.
+//  The stats compare the datagrams & bytes per frame w/what one datagram per message would have been.
+//
+
+#ifndef OSCBundleSender_h
+#define OSCBundleSender_h
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <chrono>
+
+namespace CRCPMotionAnalysis {
+
+#define OSC_BUNDLE_MTU 1472 //the most that fits in one ethernet frame: 1500 - the IP (20) & UDP (8) headers
+#define OSC_BUNDLE_HEADER_SIZE 16 //"#bundle" & the time tag
+
+//packs messages into bundles of up to maxSize bytes -- the buffers are kept from frame to frame
+class OSCBundleWriter
+{
+protected:
+    int maxSize;
+    OSCPacketWriter writer;
+    std::vector< std::vector<char> > datagrams;
+    int count; //datagrams in use
+    bool open; //whether the last one is a bundle that can take more
+
+    std::vector<char> &next()
+    {
+        if( count == datagrams.size() ) datagrams.push_back( std::vector<char>() );
+        std::vector<char> &d = datagrams[count++];
+        d.clear();
+        return d;
+    };
+
+    static void appendUInt32(std::vector<char> &d, uint32_t n)
+    {
+        d.push_back( char(n >> 24) );
+        d.push_back( char(n >> 16) );
+        d.push_back( char(n >> 8) );
+        d.push_back( char(n) );
+    };
+
+public:
+    OSCBundleWriter(int maxSize_ = OSC_BUNDLE_MTU)
+    {
+        maxSize = maxSize_;
+        count = 0;
+        open = false;
+    };
+
+    //now, as an OSC time tag -- seconds since 1900 & the fraction in 1/2^32ths
+    static uint64_t timeTagNow()
+    {
+        const uint64_t SECONDS_1900_TO_1970 = 2208988800ULL;
+        std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::system_clock::now().time_since_epoch() );
+        uint64_t seconds = ns.count() / 1000000000LL, fraction = ns.count() % 1000000000LL;
+        return ( (seconds + SECONDS_1900_TO_1970) << 32 ) | ( (fraction << 32) / 1000000000ULL );
+    };
+
+    void clear()
+    {
+        count = 0;
+        open = false;
+    };
+
+    //of all the bundles -- the messages that went out bare don't have one
+    void setTimeTag(uint64_t timeTag)
+    {
+        for(int i=0; i<count; i++)
+        {
+            std::vector<char> &d = datagrams[i];
+            if( d[0] != '#' ) continue;
+            for(int b=0; b<8; b++)
+                d[8+b] = char( timeTag >> (56 - 8*b) );
+        }
+    };
+
+    //returns the size of the message on its own
+    int add(const ci::osc::Message &msg)
+    {
+        writer.write(msg);
+        return add(writer.getData(), writer.getSize());
+    };
+
+    //a message that's already been written out, eg. by OSCPacketWriter
+    int add(const char *data, int size)
+    {
+        if( OSC_BUNDLE_HEADER_SIZE + 4 + size > maxSize ) //too big to bundle
+        {
+            std::vector<char> &d = next();
+            d.insert(d.end(), data, data + size);
+            open = false;
+            return size;
+        }
+
+        if( !open || datagrams[count-1].size() + 4 + size > maxSize )
+        {
+            std::vector<char> &d = next();
+            const char *header = "#bundle";
+            d.insert(d.end(), header, header + 8); //incl. the null
+            appendUInt32(d, 0); //the time tag, see setTimeTag()
+            appendUInt32(d, 1); //immediately
+            open = true;
+        }
+        std::vector<char> &d = datagrams[count-1];
+        appendUInt32(d, uint32_t(size));
+        d.insert(d.end(), data, data + size);
+        return size;
+    };
+
+    int getDatagramCount() const { return count; };
+    const std::vector<char> &getDatagram(int i) const { return datagrams[i]; };
+};
+
+//one destination, like ci::osc::SenderUdp -- add() the frame's messages then sendFrame()
+class OSCBundleSender
+{
+protected:
+    int localPort;
+    int socketID;
+    struct sockaddr_in destination;
+    OSCBundleWriter bundles;
+    OSCPacketWriter writer; //for send()
+
+    //per frame, since the start
+    long frames, messages, messageBytes, datagrams, datagramBytes, sendCalls, failedSends;
+    long frameMessages, frameMessageBytes;
+
+#ifdef __linux__
+    std::vector<struct mmsghdr> headers;
+    std::vector<struct iovec> parts;
+#endif
+
+    //the datagrams in one go if we can -- returns how many went out
+    int sendAll()
+    {
+        int n = bundles.getDatagramCount();
+#ifdef __linux__
+        headers.resize(n);
+        parts.resize(n);
+        for(int i=0; i<n; i++)
+        {
+            const std::vector<char> &d = bundles.getDatagram(i);
+            parts[i].iov_base = (void *) d.data();
+            parts[i].iov_len = d.size();
+            memset(&headers[i], 0, sizeof(headers[i]));
+            headers[i].msg_hdr.msg_name = &destination;
+            headers[i].msg_hdr.msg_namelen = sizeof(destination);
+            headers[i].msg_hdr.msg_iov = &parts[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = 0;
+        while( sent < n )
+        {
+            int r = sendmmsg(socketID, &headers[sent], n - sent, 0);
+            sendCalls++;
+            if( r <= 0 ) break;
+            sent += r;
+        }
+        return sent;
+#else
+        int sent = 0;
+        for(int i=0; i<n; i++)
+        {
+            const std::vector<char> &d = bundles.getDatagram(i);
+            sendCalls++;
+            if( sendto(socketID, d.data(), d.size(), 0, (struct sockaddr *) &destination, sizeof(destination)) == d.size() ) sent++;
+        }
+        return sent;
+#endif
+    };
+
+public:
+    //localPort: the port to send from, 0 for any
+    OSCBundleSender(int localPort_, std::string desthost, int destport, int mtu = OSC_BUNDLE_MTU) : bundles(mtu)
+    {
+        localPort = localPort_;
+        socketID = -1;
+        memset(&destination, 0, sizeof(destination));
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(destport);
+        inet_pton(AF_INET, desthost.c_str(), &destination.sin_addr);
+        frames = messages = messageBytes = datagrams = datagramBytes = sendCalls = failedSends = 0;
+        frameMessages = frameMessageBytes = 0;
+    };
+
+    ~OSCBundleSender()
+    {
+        if( socketID >= 0 ) ::close(socketID);
+    };
+
+    //opens the socket -- false if the local port couldn't be bound
+    bool bind()
+    {
+        if( socketID >= 0 ) return true;
+        socketID = socket(AF_INET, SOCK_DGRAM, 0);
+        if( socketID < 0 ) return false;
+
+        struct sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(localPort);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if( ::bind(socketID, (struct sockaddr *) &local, sizeof(local)) < 0 )
+        {
+            ::close(socketID);
+            socketID = -1;
+            return false;
+        }
+        return true;
+    };
+
+    //to this frame's bundles
+    void add(const ci::osc::Message &msg)
+    {
+        frameMessageBytes += bundles.add(msg);
+        frameMessages++;
+    };
+
+    void add(const char *data, int size)
+    {
+        frameMessageBytes += bundles.add(data, size);
+        frameMessages++;
+    };
+
+    //sends the frame's messages w/the time tag, eg. OSCBundleWriter::timeTagNow() -- the same for all the destinations
+    void sendFrame(uint64_t timeTag)
+    {
+        int n = bundles.getDatagramCount();
+        bundles.setTimeTag(timeTag);
+        if( n > 0 && bind() )
+        {
+            int sent = sendAll();
+            failedSends += n - sent;
+            datagrams += n;
+            for(int i=0; i<n; i++)
+                datagramBytes += bundles.getDatagram(i).size();
+        }
+        else failedSends += n;
+
+        messages += frameMessages;
+        messageBytes += frameMessageBytes;
+        frames++;
+        frameMessages = frameMessageBytes = 0;
+        bundles.clear();
+    };
+
+    //right away, on its own -- not counted
+    bool send(const ci::osc::Message &msg)
+    {
+        writer.write(msg);
+        return bind() && sendto(socketID, writer.getData(), writer.getSize(), 0, (struct sockaddr *) &destination, sizeof(destination)) == writer.getSize();
+    };
+
+    void printStats(std::string name)
+    {
+        double f = std::max(1L, frames);
+        std::cout << " " << name << ": " << frames << " frames -- " << messages / f << " datagrams & " << messageBytes / f
+                  << " payload bytes/frame as one message each, " << datagrams / f << " datagrams & " << datagramBytes / f << " payload bytes/frame bundled, "
+                  << sendCalls / f << " send calls/frame, " << failedSends << " datagrams not sent\n";
+    };
+};
+
+};
+
+#endif /* OSCBundleSender_h */
@@ -0,0 +1,507 @@
+//
+//  OSCFanOut.h
+//  VideoAndOSCLab
+//
+//  Sends the analysis' OSC from a thread of its own, so that update() never waits on the network. update() add()s the
+//  frame's messages & calls sendFrame() -- they're written straight into a slot of a lock-free queue (SPSCQueue). The
+//  frames' policy: if the sending thread is so far behind that the queue is full, the newest frame is dropped whole,
+//  its events too (see addEventAddress()) -- they're counted, & printStats() reports them.
+//
+//  The sending thread hands each frame to every destination (OSCDestination) whose address filter takes the message.
+//  A destination can be rate limited (messages per second): what it can't send yet waits in its backlog & goes out as
+//  the limit allows. The overflow policy says what happens to it: OSC_DROP_OLDEST keeps every message in order & drops
+//  the oldest when the backlog is full, OSC_COALESCE_LATEST replaces a waiting message to the same address (& the same
+//  first args, if they're ids or names, eg. the bone & its id) w/the newer one, so a slow destination gets the latest
+//  values instead of stale ones. That's only for the continuous values & states (eg. /Notch/Peak) -- the events (eg.
+//  the onsets & the notes) have to all go out, so addEventAddress() gives their addresses OSC_DROP_OLDEST everywhere.
+//  The two wait in backlogs of their own, so a backlog full of values never drops an event, & go out in the order
+//  they came. Each destination bundles what it sends w/an OSCBundleSender.
+//
+
+#ifndef OSCFanOut_h
+#define OSCFanOut_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace CRCPMotionAnalysis {
+
+enum OSCOverflowPolicy { OSC_DROP_OLDEST, OSC_COALESCE_LATEST };
+
+//one frame's messages, written out back to back -- the slots are reused, so the vectors keep their memory
+class OSCFanOutFrame
+{
+public:
+    std::vector<char> bytes;
+    std::vector<int> ends; //where each message ends in bytes
+    std::vector<LatencyTrace> traces; //the frame's peaks, see LatencyTracer
+    uint64_t timeTag;
+    uint32_t enabled; //the destinations on when it was sent, a bit each
+
+    void clear()
+    {
+        bytes.clear();
+        ends.clear();
+        traces.clear();
+    };
+};
+
+//a place the OSC goes -- set it up before OSCFanOut::start(), after that it's only used by the sending thread
+class OSCDestination
+{
+protected:
+    //a message waiting for the rate limit
+    class Pending
+    {
+    public:
+        std::vector<char> bytes;
+        int keyLength; //the address, type tags & maybe the first args -- see keyLength()
+        long order; //when it was queued, to send the two backlogs' messages in the order they came
+    };
+
+    //messages waiting for the rate limit, oldest first -- the slots are reused, so the vectors keep their memory
+    class Backlog
+    {
+    protected:
+        std::vector<Pending> ring;
+        int start;
+    public:
+        int count;
+
+        Backlog() : ring(512), start(0), count(0) {};
+
+        void resize(int size)
+        {
+            ring.resize( std::max(1, size) );
+            start = count = 0;
+        };
+
+        bool isFull() { return count == ring.size(); };
+        Pending &at(int i) { return ring[ (start + i) % ring.size() ]; };
+        Pending &pushNewest() { return at(count++); };
+
+        void popOldest()
+        {
+            start = (start + 1) % ring.size();
+            count--;
+        };
+    };
+
+    std::string name;
+    OSCBundleSender sender;
+    std::vector<std::string> only, except; //address prefixes
+
+    double rate; //messages per second, 0 for no limit
+    double burst; //how many can go at once
+    double tokens;
+    double lastRefill;
+
+    OSCOverflowPolicy policy;
+    std::vector<std::string> policyPrefixes; //addresses w/a policy of their own, see setOverflowFor()
+    std::vector<OSCOverflowPolicy> prefixPolicies;
+    Backlog events, values; //the OSC_DROP_OLDEST messages & the OSC_COALESCE_LATEST ones -- a full one only drops its own
+    long order;
+
+    long queued, dropped, droppedEvents, coalesced, deferred;
+    bool sentAny; //since the last flush()
+
+    //what coalescing compares -- up to the end of the first two args if they're ints or strings (eg. the bone & its id,
+    //as each dancer's bones have the same names), else as far as they are, else up to the end of the type tags
+    static int keyLength(const char *data, int size)
+    {
+        int address = int( strnlen(data, size) + 4 ) & ~3;
+        if( address >= size || data[address] != ',' ) return std::min(address, size);
+        int tagLength = int( strnlen(data + address, size - address) );
+        int key = ( address + tagLength + 4 ) & ~3;
+        for(int i=1; i<=2 && i<tagLength; i++)
+        {
+            char tag = data[address + i];
+            if( tag == 'i' ) key += 4;
+            else if( tag == 's' ) key = int( key + strnlen(data + key, std::max(0, size - key)) + 4 ) & ~3;
+            else break;
+            if( key >= size ) break;
+        }
+        return std::min(key, size);
+    };
+
+    void refill(double now)
+    {
+        if( rate <= 0 ) return;
+        tokens = std::min( burst, tokens + (now - lastRefill) * rate );
+        lastRefill = now;
+    };
+
+    bool canSend()
+    {
+        return rate <= 0 || tokens >= 1;
+    };
+
+    void sendNow(const char *data, int size)
+    {
+        sender.add(data, size);
+        if( rate > 0 ) tokens -= 1;
+        sentAny = true;
+    };
+
+public:
+    OSCDestination(std::string name_, int localPort, std::string host, int port, int mtu = OSC_BUNDLE_MTU) : sender(localPort, host, port, mtu)
+    {
+        name = name_;
+        rate = 0;
+        burst = 0;
+        tokens = 0;
+        lastRefill = 0;
+        policy = OSC_DROP_OLDEST;
+        order = 0;
+        queued = dropped = droppedEvents = coalesced = deferred = 0;
+        sentAny = false;
+    };
+
+    std::string getName() { return name; };
+    bool bind() { return sender.bind(); };
+
+    //only messages whose address starts w/one of these -- all of them if none are given
+    void addOnly(std::string prefix) { only.push_back(prefix); };
+
+    //never messages whose address starts w/this
+    void addExcept(std::string prefix) { except.push_back(prefix); };
+
+    //messagesPerSecond: 0 for no limit. burstSeconds: how many seconds' worth can go at once after waiting
+    void setRateLimit(double messagesPerSecond, double burstSeconds = 0.05)
+    {
+        rate = std::max(0.0, messagesPerSecond);
+        burst = std::max(1.0, rate * burstSeconds);
+        tokens = burst;
+        lastRefill = LatencyTracer::now();
+    };
+
+    //what to do when more is waiting for the rate limit than the backlog holds -- maxBacklog for each of the events &
+    //the values
+    void setOverflow(OSCOverflowPolicy policy_, int maxBacklog = 512)
+    {
+        policy = policy_;
+        events.resize(maxBacklog);
+        values.resize(maxBacklog);
+    };
+
+    //the policy for the addresses starting w/prefix, instead of setOverflow()'s -- eg. OSC_DROP_OLDEST for the events
+    void setOverflowFor(std::string prefix, OSCOverflowPolicy policy_)
+    {
+        policyPrefixes.push_back(prefix);
+        prefixPolicies.push_back(policy_);
+    };
+
+    OSCOverflowPolicy getOverflow(const char *address)
+    {
+        for(int i=0; i<policyPrefixes.size(); i++)
+        {
+            if( strncmp(address, policyPrefixes[i].c_str(), policyPrefixes[i].size()) == 0 ) return prefixPolicies[i];
+        }
+        return policy;
+    };
+
+    bool accepts(const char *address)
+    {
+        for(int i=0; i<except.size(); i++)
+        {
+            if( strncmp(address, except[i].c_str(), except[i].size()) == 0 ) return false;
+        }
+        if( only.empty() ) return true;
+        for(int i=0; i<only.size(); i++)
+        {
+            if( strncmp(address, only[i].c_str(), only[i].size()) == 0 ) return true;
+        }
+        return false;
+    };
+
+    //sending thread -- sends it w/the next flush() if the rate limit allows, else it waits in its backlog. A full
+    //backlog drops its oldest, so the values never push out the events
+    void queue(const char *data, int size, double now)
+    {
+        queued++;
+        refill(now);
+        if( !isBacklogged() && canSend() )
+        {
+            sendNow(data, size);
+            return;
+        }
+        deferred++;
+
+        int key = keyLength(data, size);
+        bool coalescing = getOverflow(data) == OSC_COALESCE_LATEST;
+        Backlog &backlog = coalescing ? values : events;
+        if( coalescing )
+        {
+            for(int i=0; i<backlog.count; i++)
+            {
+                Pending &p = backlog.at(i);
+                if( p.keyLength == key && memcmp(p.bytes.data(), data, key) == 0 )
+                {
+                    p.bytes.assign(data, data + size);
+                    coalesced++;
+                    return;
+                }
+            }
+        }
+        if( backlog.isFull() )
+        {
+            backlog.popOldest();
+            if( coalescing ) dropped++;
+            else droppedEvents++;
+        }
+        Pending &p = backlog.pushNewest();
+        p.bytes.assign(data, data + size);
+        p.keyLength = key;
+        p.order = order++;
+    };
+
+    //sending thread -- sends what the rate limit allows from the backlogs, in the order it came, & everything queued
+    //since the last time
+    void flush(uint64_t timeTag, double now)
+    {
+        refill(now);
+        while( isBacklogged() && canSend() )
+        {
+            bool event = values.count == 0 || ( events.count > 0 && events.at(0).order < values.at(0).order );
+            Backlog &backlog = event ? events : values;
+            Pending &p = backlog.at(0);
+            sendNow(p.bytes.data(), int(p.bytes.size()));
+            backlog.popOldest();
+        }
+        if( sentAny ) sender.sendFrame(timeTag);
+        sentAny = false;
+    };
+
+    bool isBacklogged() { return events.count > 0 || values.count > 0; };
+
+    void printStats()
+    {
+        sender.printStats(name);
+        std::cout << "    " << queued << " messages queued, " << deferred << " waited for the rate limit, " << coalesced
+                  << " coalesced, dropped " << droppedEvents << " kept in order (the events) & " << dropped << " coalescing, "
+                  << events.count + values.count << " waiting\n";
+    };
+};
+
+class OSCFanOut
+{
+protected:
+    std::vector<OSCDestination *> destinations;
+    uint32_t enabled; //update thread's -- copied into each frame
+
+    SPSCQueue<OSCFanOutFrame> frames;
+    OSCFanOutFrame *current; //the frame being added to, in the queue's next slot
+    bool currentDropped; //the queue was full when this frame started
+    OSCPacketWriter writer;
+
+    std::thread sendingThread;
+    std::atomic<bool> running;
+    std::atomic<bool> printRequested;
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    uint64_t lastTimeTag;
+    int probe;
+    std::vector<std::string> eventPrefixes; //see addEventAddress()
+    std::atomic<long> droppedEvents; //in the frames that didn't fit in the queue
+
+    void sendQueuedFrame(const OSCFanOutFrame &frame)
+    {
+        ScopedProfile timer(probe, frame.ends.size());
+        double now = LatencyTracer::now();
+        for(int d=0; d<destinations.size(); d++)
+        {
+            if( !(frame.enabled & (1u << d)) ) continue;
+            int start = 0;
+            for(int i=0; i<frame.ends.size(); i++)
+            {
+                const char *data = frame.bytes.data() + start;
+                if( destinations[d]->accepts(data) ) destinations[d]->queue(data, frame.ends[i] - start, now);
+                start = frame.ends[i];
+            }
+            destinations[d]->flush(frame.timeTag, now);
+        }
+
+        double sendTime = LatencyTracer::now();
+        for(int i=0; i<frame.traces.size(); i++)
+            LatencyTracer::get().sent(frame.traces[i], sendTime);
+        lastTimeTag = frame.timeTag;
+    };
+
+    void sendLoop()
+    {
+        for(;;)
+        {
+            bool stopping = !running.load(std::memory_order_acquire);
+
+            const OSCFanOutFrame *frame;
+            while( (frame = frames.front()) != NULL )
+            {
+                sendQueuedFrame(*frame);
+                frames.popFront();
+            }
+
+            //what's waiting for the rate limits
+            bool backlogged = false;
+            double now = LatencyTracer::now();
+            for(int d=0; d<destinations.size(); d++)
+            {
+                if( !destinations[d]->isBacklogged() ) continue;
+                destinations[d]->flush(lastTimeTag, now);
+                backlogged = backlogged || destinations[d]->isBacklogged();
+            }
+
+            if( printRequested.exchange(false) ) printDestinations();
+            if( stopping ) return;
+
+            //a missed notify only costs a few ms -- update() never takes the lock
+            std::unique_lock<std::mutex> l(wakeLock);
+            wake.wait_for( l, std::chrono::milliseconds(backlogged ? 1 : 5) );
+        }
+    };
+
+    void printDestinations()
+    {
+        std::cout << "-------- OSC out: " << frames.getPushedCount() << " frames queued, " << frames.getOverflowCount() << " dropped w/"
+                  << droppedEvents.load(std::memory_order_relaxed) << " events (the sending thread was " << frames.getCapacity()
+                  << " frames behind), most waiting at once: " << frames.getHighWater() << "\n";
+        for(int d=0; d<destinations.size(); d++)
+            destinations[d]->printStats();
+    };
+
+public:
+    //queueSize: how many frames the sending thread can fall behind by before they're dropped
+    OSCFanOut(int queueSize = 32) : frames(queueSize), running(false), printRequested(false), droppedEvents(0)
+    {
+        enabled = 0;
+        current = NULL;
+        currentDropped = false;
+        lastTimeTag = 1;
+        probe = Profiler::get().probe("send/frame");
+    };
+
+    ~OSCFanOut()
+    {
+        stop();
+        for(int d=0; d<destinations.size(); d++)
+            delete destinations[d];
+    };
+
+    //before start() -- returns its index for getDestination() & setEnabled(). Up to 32 of them.
+    int addDestination(std::string name, int localPort, std::string host, int port, int mtu = OSC_BUNDLE_MTU)
+    {
+        if( running || destinations.size() >= 32 ) return -1;
+        destinations.push_back( new OSCDestination(name, localPort, host, port, mtu) );
+        for(int i=0; i<eventPrefixes.size(); i++)
+            destinations.back()->setOverflowFor(eventPrefixes[i], OSC_DROP_OLDEST);
+        enabled |= 1u << (destinations.size() - 1);
+        return destinations.size() - 1;
+    };
+
+    OSCDestination &getDestination(int d) { return *destinations[d]; };
+
+    //before start() -- the messages whose addresses start w/this are events, eg. the onsets: no destination coalesces
+    //them (OSC_DROP_OLDEST, whatever its policy for the rest) & they're counted when their frame is dropped
+    void addEventAddress(std::string prefix)
+    {
+        if( running ) return;
+        eventPrefixes.push_back(prefix);
+        for(int d=0; d<destinations.size(); d++)
+            destinations[d]->setOverflowFor(prefix, OSC_DROP_OLDEST);
+    };
+
+    bool isEvent(const std::string &address)
+    {
+        for(int i=0; i<eventPrefixes.size(); i++)
+        {
+            if( address.compare(0, eventPrefixes[i].size(), eventPrefixes[i]) == 0 ) return true;
+        }
+        return false;
+    };
+
+    //binds the destinations' sockets & starts sending -- false if any of them couldn't be bound
+    bool start()
+    {
+        if( running ) return true;
+        bool bound = true;
+        for(int d=0; d<destinations.size(); d++)
+        {
+            if( !destinations[d]->bind() )
+            {
+                std::cout << "OSCFanOut: couldn't bind the socket for " << destinations[d]->getName() << std::endl;
+                bound = false;
+            }
+        }
+        running = true;
+        sendingThread = std::thread( &OSCFanOut::sendLoop, this );
+        return bound;
+    };
+
+    //sends whatever frames are still queued first
+    void stop()
+    {
+        if( !running ) return;
+        running = false;
+        wake.notify_one();
+        sendingThread.join();
+    };
+
+    //update thread -- from the next sendFrame() on, eg. not sending to the remote laptop while reanalysing
+    void setEnabled(int d, bool on)
+    {
+        if( d < 0 || d >= destinations.size() ) return;
+        if( on ) enabled |= 1u << d;
+        else enabled &= ~(1u << d);
+    };
+
+    //update thread -- to this frame
+    void add(const ci::osc::Message &msg)
+    {
+        if( current == NULL && !currentDropped )
+        {
+            current = frames.beginPush();
+            if( current != NULL ) current->clear();
+            else currentDropped = true;
+        }
+        if( current == NULL ) //dropped w/the rest of the frame
+        {
+            if( isEvent(msg.getAddress()) ) droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        writer.write(msg);
+        current->bytes.insert(current->bytes.end(), writer.getData(), writer.getData() + writer.getSize());
+        current->ends.push_back( current->bytes.size() );
+    };
+
+    //update thread -- the frame's peaks, timed to when they're sent
+    void addTrace(const LatencyTrace &trace)
+    {
+        if( current != NULL ) current->traces.push_back(trace);
+    };
+
+    //update thread -- hands the frame to the sending thread, w/the time tag for its bundles, eg. OSCBundleWriter::timeTagNow()
+    void sendFrame(uint64_t timeTag)
+    {
+        if( current != NULL )
+        {
+            current->timeTag = timeTag;
+            current->enabled = enabled;
+            frames.commitPush();
+            wake.notify_one();
+        }
+        current = NULL;
+        currentDropped = false;
+    };
+
+    //printed by the sending thread, next time it wakes up
+    void printStats()
+    {
+        printRequested = true;
+        wake.notify_one();
+    };
+};
+
+};
+
+#endif /* OSCFanOut_h */
@@ -0,0 +1,362 @@
+//
+//  OSCPacket.h
+//  VideoAndOSCLab
+//
+//  Reads OSC messages straight out of a received UDP packet without copying or allocating anything -- strings come back as
+//  pointers into the packet. This is for the receiving thread, which can't allocate. ci::osc::Message is still what the
+//  rest of the program uses, see toCinderMessage(). OSCPacketWriter goes the other way, eg. to record the analysis' output.
+//  Spec: http://opensoundcontrol.org/spec-1_0
+//
+
+#ifndef OSCPacket_h
+#define OSCPacket_h
+
+#include <cstring>
+#include <stdint.h>
+
+namespace CRCPMotionAnalysis {
+
+#define OSC_RAW_PACKET_MAX 8192 //bigger packets are still decoded but not queued or recorded
+
+//a copy of a whole packet & when it came in, for handing over to another thread
+class OSCRawPacket
+{
+public:
+    char data[OSC_RAW_PACKET_MAX];
+    int size;
+    double receiveTime;
+};
+
+//OSC is big-endian
+inline uint32_t oscReadUInt32(const char *p)
+{
+    const unsigned char *u = (const unsigned char *) p;
+    return ( uint32_t(u[0]) << 24 ) | ( uint32_t(u[1]) << 16 ) | ( uint32_t(u[2]) << 8 ) | uint32_t(u[3]);
+}
+
+inline uint64_t oscReadUInt64(const char *p)
+{
+    return ( uint64_t(oscReadUInt32(p)) << 32 ) | oscReadUInt32(p+4);
+}
+
+//the length of a padded OSC string starting at p, incl. the null & the padding to 4 bytes -- or -1 if it runs past end
+inline int oscPaddedStringLength(const char *p, const char *end)
+{
+    const char *s = p;
+    while( s < end && *s != '\0' ) s++;
+    if( s >= end ) return -1;
+    int len = int(s - p) + 1;
+    len = (len + 3) & ~3;
+    if( p + len > end ) return -1;
+    return len;
+}
+
+//walks through the arguments of one message, in order
+class OSCArgReader
+{
+protected:
+    const char *tag; //the current type tag
+    const char *pos; //the current argument's data
+    const char *end;
+    bool valid;
+
+public:
+    OSCArgReader(const char *typeTags = "", const char *data = NULL, const char *end_ = NULL)
+    {
+        tag = typeTags;
+        pos = data;
+        end = end_;
+        valid = true;
+    };
+
+    inline bool atEnd() const { return !valid || *tag == '\0'; };
+    inline bool isValid() const { return valid; };
+    inline char getType() const { return *tag; }; //eg. 'f', see ci::osc::ArgType for the letters
+
+    //these read the current argument & move on to the next -- they don't check the type, so check getType() first
+    float readFloat()
+    {
+        if( pos + 4 > end ) { valid = false; return 0; }
+        uint32_t bits = oscReadUInt32(pos);
+        float f;
+        std::memcpy(&f, &bits, 4);
+        pos += 4;
+        tag++;
+        return f;
+    };
+
+    int32_t readInt32()
+    {
+        if( pos + 4 > end ) { valid = false; return 0; }
+        int32_t i = (int32_t) oscReadUInt32(pos);
+        pos += 4;
+        tag++;
+        return i;
+    };
+
+    double readDouble()
+    {
+        if( pos + 8 > end ) { valid = false; return 0; }
+        uint64_t bits = oscReadUInt64(pos);
+        double d;
+        std::memcpy(&d, &bits, 8);
+        pos += 8;
+        tag++;
+        return d;
+    };
+
+    int64_t readInt64()
+    {
+        if( pos + 8 > end ) { valid = false; return 0; }
+        int64_t i = (int64_t) oscReadUInt64(pos);
+        pos += 8;
+        tag++;
+        return i;
+    };
+
+    //returns a pointer into the packet (null-terminated) & its length in len
+    const char *readString(int &len)
+    {
+        int padded = oscPaddedStringLength(pos, end);
+        if( padded < 0 ) { valid = false; len = 0; return ""; }
+        const char *s = pos;
+        len = int(strlen(s));
+        pos += padded;
+        tag++;
+        return s;
+    };
+
+    //skips over the current argument, whatever it is -- never past the end, the sizes come from the network
+    void skip()
+    {
+        int len;
+        switch( *tag )
+        {
+            case 'i': case 'f': case 'c': case 'r': case 'm':
+                if( pos + 4 > end ) { valid = false; return; }
+                pos += 4;
+                break;
+            case 'h': case 't': case 'd':
+                if( pos + 8 > end ) { valid = false; return; }
+                pos += 8;
+                break;
+            case 's': case 'S':
+                readString(len);
+                return;
+            case 'b':
+            {
+                if( pos + 4 > end ) { valid = false; return; }
+                int64_t padded = ( int64_t(oscReadUInt32(pos)) + 3 ) & ~int64_t(3);
+                if( end - (pos + 4) < padded ) { valid = false; return; }
+                pos += 4 + padded;
+                break;
+            }
+            default: //T, F, N, I & anything else have no data
+                break;
+        }
+        tag++;
+    };
+
+    //where the current argument's data starts -- for readers that know the layout already
+    inline const char *getPosition() const { return pos; };
+    inline const char *getTypeTag() const { return tag; };
+};
+
+//one OSC message in a packet
+class OSCMessageReader
+{
+protected:
+    const char *address;
+    const char *typeTags; //without the leading ','
+    const char *args;
+    const char *end;
+    bool valid;
+
+public:
+    OSCMessageReader()
+    {
+        address = "";
+        typeTags = "";
+        args = NULL;
+        end = NULL;
+        valid = false;
+    };
+
+    //false if it isn't a well-formed message
+    bool parse(const char *data, int size)
+    {
+        valid = false;
+        end = data + size;
+        if( size < 4 || data[0] != '/' ) return false;
+
+        int addrLen = oscPaddedStringLength(data, end);
+        if( addrLen < 0 ) return false;
+        address = data;
+
+        const char *tags = data + addrLen;
+        if( tags >= end || *tags != ',' ) return false;
+        int tagLen = oscPaddedStringLength(tags, end);
+        if( tagLen < 0 ) return false;
+        typeTags = tags + 1;
+        args = tags + tagLen;
+
+        valid = true;
+        return true;
+    };
+
+    inline bool isValid() const { return valid; };
+    inline const char *getAddress() const { return address; };
+    inline const char *getEnd() const { return end; };
+    inline const char *getTypeTags() const { return typeTags; };
+    inline int getNumArgs() const { return int(strlen(typeTags)); };
+    inline bool addressIs(const char *addr) const { return valid && strcmp(address, addr) == 0; };
+
+    OSCArgReader getArgs() const
+    {
+        return OSCArgReader(typeTags, args, end);
+    };
+
+    //the message as a ci::osc::Message, for the rest of the program -- this allocates, so not on the receiving thread
+    ci::osc::Message toCinderMessage() const
+    {
+        ci::osc::Message msg;
+        msg.setAddress(address);
+
+        OSCArgReader arg = getArgs();
+        int len;
+        while( !arg.atEnd() )
+        {
+            switch( arg.getType() )
+            {
+                case 'i': msg.append( arg.readInt32() ); break;
+                case 'f': msg.append( arg.readFloat() ); break;
+                case 'd': msg.append( arg.readDouble() ); break;
+                case 's': msg.append( std::string(arg.readString(len)) ); break;
+                default: arg.skip(); break; //only what SaveOSC handles
+            }
+        }
+        return msg;
+    };
+};
+
+//calls handler(const OSCMessageReader &) for each message in the packet, going into bundles. Returns false if any of it was malformed
+template<typename Handler>
+bool oscForEachMessage(const char *data, int size, Handler &handler, int depth=0)
+{
+    if( size < 8 ) return false;
+
+    if( data[0] == '#' )
+    {
+        if( depth > 8 || size < 16 || strncmp(data, "#bundle", 8) != 0 ) return false;
+
+        const char *pos = data + 16; //past "#bundle\0" & the time tag
+        const char *end = data + size;
+        bool ok = true;
+        while( pos + 4 <= end )
+        {
+            uint32_t elementSize = oscReadUInt32(pos);
+            pos += 4;
+            if( elementSize > uint32_t(end - pos) ) return false;
+            ok = oscForEachMessage(pos, elementSize, handler, depth+1) && ok;
+            pos += elementSize;
+        }
+        return ok;
+    }
+
+    OSCMessageReader msg;
+    if( !msg.parse(data, size) ) return false;
+    handler(msg);
+    return true;
+}
+
+//writes one OSC message into a packet -- reuse it to avoid allocating. Either begin() & add the args in the order of the
+//type tags, or write() a whole ci::osc::Message
+class OSCPacketWriter
+{
+protected:
+    std::vector<char> buffer;
+
+    void appendUInt32(uint32_t n)
+    {
+        buffer.push_back( char(n >> 24) );
+        buffer.push_back( char(n >> 16) );
+        buffer.push_back( char(n >> 8) );
+        buffer.push_back( char(n) );
+    };
+
+    void appendUInt64(uint64_t n)
+    {
+        appendUInt32( uint32_t(n >> 32) );
+        appendUInt32( uint32_t(n) );
+    };
+
+    //null-terminated & padded to 4 bytes -- from the start of the message, so the type tags can start w/the ','
+    void appendString(const char *str, int len)
+    {
+        buffer.insert(buffer.end(), str, str + len);
+        buffer.resize((buffer.size() + 4) & ~size_t(3), '\0');
+    };
+
+public:
+    //starts a new message -- typeTags w/o the leading ','
+    void begin(const char *address, const char *typeTags)
+    {
+        buffer.clear();
+        appendString(address, int(strlen(address)));
+        buffer.push_back(',');
+        appendString(typeTags, int(strlen(typeTags)));
+    };
+
+    void addInt32(int32_t i) { appendUInt32( uint32_t(i) ); };
+    void addInt64(int64_t i) { appendUInt64( uint64_t(i) ); };
+
+    void addFloat(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, 4);
+        appendUInt32(bits);
+    };
+
+    void addDouble(double d)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &d, 8);
+        appendUInt64(bits);
+    };
+
+    void addString(const std::string &str)
+    {
+        appendString(str.c_str(), int(str.size()));
+    };
+
+    //the whole message -- only the arg types SaveOSC handles & the ones w/o data, the rest are left out
+    void write(const ci::osc::Message &msg)
+    {
+        std::string tags;
+        for(int i=0; i<msg.getNumArgs(); i++)
+        {
+            char type = (char) msg.getArgType(i);
+            if( strchr("ifdsTFNI", type) != NULL ) tags.push_back(type);
+        }
+        begin(msg.getAddress().c_str(), tags.c_str());
+
+        for(int i=0; i<msg.getNumArgs(); i++)
+        {
+            switch( (char) msg.getArgType(i) )
+            {
+                case 'i': addInt32( msg.getArgInt32(i) ); break;
+                case 'f': addFloat( msg.getArgFloat(i) ); break;
+                case 'd': addDouble( msg.getArgDouble(i) ); break;
+                case 's': addString( msg.getArgString(i) ); break;
+                default: break;
+            }
+        }
+    };
+
+    const char *getData() const { return buffer.data(); };
+    int getSize() const { return int(buffer.size()); };
+};
+
+};
+
+#endif /* OSCPacket_h */
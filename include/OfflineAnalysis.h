@@ -0,0 +1,126 @@
+//
+//  OfflineAnalysis.h
+//  VideoAndOSCLab
+//
+//  Runs the analysis on a recorded session w/o a window, GL, the network or the wall clock -- eg. for re-running a long
+//  rehearsal on a server, or checking that a change to the analysis gives the same output. The session's packets are fed
+//  to the pipeline in order & the pipeline is updated every frame of the session's own clock (a virtual clock), so the
+//  same session always gives the same output however fast the machine is.
+//
+//  The OSC the analysis sends (incl. the MIDI notes, see MIDINOTE_OSCMESSAGE) is written to another session log, one
+//  packet per message w/the frame's time -- play it back w/SessionPlayer or convert it to CSV like any other recording.
+//  See src/offlineAnalysisMain.cpp for the command line tool.
+//
+
+#ifndef OfflineAnalysis_h
+#define OfflineAnalysis_h
+
+namespace CRCPMotionAnalysis {
+
+class OfflineAnalysisEngine
+{
+protected:
+    MotionAnalysisPipeline pipeline; //its receiver is never started -- packets are injected
+    SessionPlayer player;
+    SessionRecorder *output;
+    OSCPacketWriter writer;
+    std::vector<ci::osc::Message> msgs;
+
+    double frameSeconds;
+    long frames, packetsIn, messagesOut, wekinatorFrames;
+    double wallSeconds; //how long the last run() took
+
+public:
+    //frameRate is how often the analysis updates, in frames per session second -- the app runs at 60. threads: see
+    //MotionAnalysisPipeline -- the output is the same however many there are
+    OfflineAnalysisEngine(std::string sessionFilename, std::string outputFilename, double frameRate = 60.0, int threads = -1) : pipeline(0, threads), player(sessionFilename, "127.0.0.1", 0)
+    {
+        frameSeconds = 1.0 / std::max(1.0, frameRate);
+        frames = packetsIn = messagesOut = wekinatorFrames = 0;
+        wallSeconds = 0;
+
+        output = new SessionRecorder(outputFilename, 0, false); //writes as it goes, so nothing is dropped however fast we run
+    };
+
+    ~OfflineAnalysisEngine()
+    {
+        delete output; //writes the index & closes the file
+    };
+
+    bool isValid()
+    {
+        return player.isValid() && output->isOpen();
+    };
+
+    //in the session's seconds
+    double getStartTime() { return player.getStartTime(); };
+    double getEndTime() { return player.getEndTime(); };
+
+    MotionAnalysisPipeline &getPipeline() { return pipeline; };
+
+    //analyses the session from start to end, both in seconds from the beginning of the session (< 0 for the whole thing)
+    void run(double start = -1, double end = -1)
+    {
+        if( !isValid() ) return;
+        if( start > 0 ) player.seek( player.getStartTime() + start );
+        double until = end < 0 ? -1 : player.getStartTime() + end;
+
+        std::chrono::steady_clock::time_point began = std::chrono::steady_clock::now();
+        player.playAsFastAsPossible(*this, frameSeconds, until);
+        output->close();
+        wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    };
+
+    //------------------ called by SessionPlayer::playAsFastAsPossible()
+
+    void packet(const char *data, int size, double sessionSeconds)
+    {
+        pipeline.getReceiver().injectPacket(data, size, sessionSeconds);
+        packetsIn++;
+    };
+
+    void frame(double sessionSeconds)
+    {
+        pipeline.receive(sessionSeconds);
+
+        //nothing to forward these to offline
+        MocapReceiver &receiver = pipeline.getReceiver();
+        while( receiver.getWekinatorFrames().front() != NULL )
+        {
+            receiver.getWekinatorFrames().popFront();
+            wekinatorFrames++;
+        }
+        while( receiver.getRawPackets().front() != NULL )
+            receiver.getRawPackets().popFront();
+
+        msgs.clear();
+        pipeline.update(sessionSeconds, msgs);
+        for(int i=0; i<msgs.size(); i++)
+        {
+            writer.write(msgs[i]);
+            output->record(writer.getData(), writer.getSize(), sessionSeconds);
+        }
+        messagesOut += msgs.size();
+        frames++;
+    };
+
+    //------------------
+
+    void printStats()
+    {
+        double sessionSeconds = frames * frameSeconds;
+        std::cout << "Offline analysis: " << packetsIn << " packets in, " << frames << " frames, " << messagesOut << " messages out ("
+                  << wekinatorFrames << " wekinator frames not sent)\n";
+        std::cout << " " << pipeline.getPeople().size() << " dancer(s), updated on " << pipeline.getWorkers().getThreadCount() + 1 << " thread(s) -- "
+                  << pipeline.getGraph().getNodeCount() << " ugens & tasks, " << pipeline.getGraph().getDepth() << " deep\n";
+        std::cout << " " << sessionSeconds << " session seconds in " << wallSeconds << " seconds";
+        if( wallSeconds > 0 ) std::cout << " -- " << sessionSeconds / wallSeconds << "x real time";
+        std::cout << "\n";
+        pipeline.getReceiver().printStats();
+        ProfileReporter::print(); //the stats aren't sent, so the output stays the same from run to run
+    };
+};
+
+};
+
+#endif /* OfflineAnalysis_h */
@@ -0,0 +1,255 @@
+//
+//  OnsetEvaluation.h
+//  VideoAndOSCLab
+//
+//  How FindPeaks' predictive mode (see FindPeaks::setPrediction()) does against finding the peaks once they've happened,
+//  on a recorded session. The session is run through the analysis on its own clock, as OfflineAnalysisEngine does,
+//  once as it is for the reference onsets & then once for each prediction horizon. Each run's onsets are matched w/the
+//  reference's of the same body part -- the nearest within the tolerance, in time order -- for the precision & recall,
+//  & the matched ones are timed from the reference's peak sample to the frame they were sent in.
+//
+//  Precision is for the onsets that stood (the taken back ones don't count) & again for all that fired -- a note that
+//  has sounded can't be taken back. Included by src/onsetEvaluationMain.cpp only, like Benchmarks.h.
+//
+
+#ifndef OnsetEvaluation_h
+#define OnsetEvaluation_h
+
+#include <map>
+
+namespace CRCPMotionAnalysis {
+
+//one run of a session through the analysis -- every onset, w/the frame it was sent in & whether it was taken back
+class OnsetRun
+{
+public:
+    class Onset
+    {
+    public:
+        PeakOnset onset;
+        double sent; //the session seconds of the frame it was sent in
+        bool retracted;
+    };
+
+protected:
+    MotionAnalysisPipeline pipeline; //its receiver is never started -- packets are injected
+    SessionPlayer player;
+    std::vector<ci::osc::Message> msgs;
+    std::vector<Onset> onsets;
+    double frameSeconds;
+    double thresh; //for every axis of every body part, < 0 for their own
+    int threshed; //the body parts that have it
+
+public:
+    OnsetRun(std::string sessionFilename, const PeakPrediction &prediction, double frameRate = 60.0, double thresh_ = -1, int threads = -1)
+        : pipeline(0, threads), player(sessionFilename, "127.0.0.1", 0)
+    {
+        frameSeconds = 1.0 / std::max(1.0, frameRate);
+        thresh = thresh_;
+        threshed = 0;
+        pipeline.setPeakPrediction(prediction);
+    };
+
+    bool isValid() { return player.isValid(); };
+
+    //from start to end, in seconds from the beginning of the session (< 0 for the whole thing)
+    void run(double start = -1, double end = -1)
+    {
+        if( !isValid() ) return;
+        if( start > 0 ) player.seek( player.getStartTime() + start );
+        player.playAsFastAsPossible(*this, frameSeconds, end < 0 ? -1 : player.getStartTime() + end);
+    };
+
+    const std::vector<Onset> &getOnsets() { return onsets; };
+
+    //------------------ called by SessionPlayer::playAsFastAsPossible()
+
+    void packet(const char *data, int size, double sessionSeconds)
+    {
+        pipeline.getReceiver().injectPacket(data, size, sessionSeconds);
+    };
+
+    void frame(double sessionSeconds)
+    {
+        pipeline.receive(sessionSeconds);
+
+        MocapReceiver &receiver = pipeline.getReceiver();
+        while( receiver.getWekinatorFrames().front() != NULL )
+            receiver.getWekinatorFrames().popFront();
+        while( receiver.getRawPackets().front() != NULL )
+            receiver.getRawPackets().popFront();
+
+        std::vector<BodyPartSensor *> &parts = pipeline.getBodyParts();
+        for( ; thresh >= 0 && threshed < parts.size(); threshed++ )
+            parts[threshed]->setPeakThresh(thresh, thresh, thresh);
+
+        msgs.clear();
+        pipeline.update(sessionSeconds, msgs);
+
+        const std::vector<PeakOnset> &taken = pipeline.getPeakRetractions();
+        for(int i=0; i<taken.size(); i++)
+        {
+            for(int j=onsets.size()-1; j>=0; j--)
+            {
+                const PeakOnset &o = onsets[j].onset;
+                if( !onsets[j].retracted && o.sensor == taken[i].sensor && o.axis == taken[i].axis && o.time == taken[i].time )
+                {
+                    onsets[j].retracted = true;
+                    break;
+                }
+            }
+        }
+
+        const std::vector<PeakOnset> &fired = pipeline.getPeakOnsets();
+        for(int i=0; i<fired.size(); i++)
+        {
+            Onset o;
+            o.onset = fired[i];
+            o.sent = sessionSeconds;
+            o.retracted = false;
+            onsets.push_back(o);
+        }
+    };
+};
+
+//a run's onsets against the reference's
+class OnsetComparison
+{
+public:
+    long reference, fired, retracted, matched, matchedFired;
+    std::vector<double> latency; //ms from the reference's peak to sending, for the matched ones that stood
+    std::vector<double> earlier; //ms sooner than the reference's, same
+
+protected:
+    //the onsets, in time order, by body part
+    typedef std::map< int, std::vector<const OnsetRun::Onset *> > BySensor;
+
+    static BySensor bySensor(const std::vector<OnsetRun::Onset> &onsets, bool standingOnly)
+    {
+        BySensor sensors;
+        for(int i=0; i<onsets.size(); i++)
+        {
+            if( standingOnly && onsets[i].retracted ) continue;
+            sensors[onsets[i].onset.sensor].push_back(&onsets[i]);
+        }
+        for(BySensor::iterator it = sensors.begin(); it != sensors.end(); it++)
+            std::stable_sort(it->second.begin(), it->second.end(), [](const OnsetRun::Onset *a, const OnsetRun::Onset *b){ return a->onset.time < b->onset.time; });
+        return sensors;
+    };
+
+    //the pairs within the tolerance (seconds), in time order -- returns how many
+    long match(BySensor &ref, BySensor &run, double tolerance, bool time)
+    {
+        long count = 0;
+        for(BySensor::iterator it = ref.begin(); it != ref.end(); it++)
+        {
+            std::vector<const OnsetRun::Onset *> &r = it->second, &c = run[it->first];
+            int i = 0, j = 0;
+            while( i < r.size() && j < c.size() )
+            {
+                double dt = c[j]->onset.time - r[i]->onset.time;
+                if( std::abs(dt) <= tolerance )
+                {
+                    if( time )
+                    {
+                        latency.push_back( (c[j]->sent - r[i]->onset.time) * 1000.0 );
+                        earlier.push_back( (r[i]->sent - c[j]->sent) * 1000.0 );
+                    }
+                    count++;
+                    i++;
+                    j++;
+                }
+                else if( dt < 0 ) j++; //nothing in the reference
+                else i++; //missed
+            }
+        }
+        return count;
+    };
+
+public:
+    OnsetComparison(const std::vector<OnsetRun::Onset> &ref, const std::vector<OnsetRun::Onset> &run, double tolerance)
+    {
+        reference = ref.size();
+        fired = run.size();
+        retracted = 0;
+        for(int i=0; i<run.size(); i++)
+            retracted += run[i].retracted;
+
+        BySensor r = bySensor(ref, false), standing = bySensor(run, true), all = bySensor(run, false);
+        matched = match(r, standing, tolerance, true);
+        matchedFired = match(r, all, tolerance, false);
+    };
+
+    double getPrecision() { return fired - retracted > 0 ? double(matched) / (fired - retracted) : 0; };
+    double getPrecisionAsFired() { return fired > 0 ? double(matchedFired) / fired : 0; };
+    double getRecall() { return reference > 0 ? double(matched) / reference : 0; };
+
+    static double percentile(std::vector<double> v, double p)
+    {
+        if( v.empty() ) return 0;
+        std::sort(v.begin(), v.end());
+        return v[ std::min( int(v.size())-1, int(p * v.size()) ) ];
+    };
+
+    static double mean(const std::vector<double> &v)
+    {
+        double sum = 0;
+        for(int i=0; i<v.size(); i++) sum += v[i];
+        return v.empty() ? 0 : sum / v.size();
+    };
+};
+
+//the reference run, then one for each horizon -- printed as they finish
+class OnsetEvaluation
+{
+protected:
+    std::string sessionFilename;
+
+public:
+    double frameRate; //as the app
+    double thresh; //see OnsetRun
+    double tolerance; //seconds between a prediction & its peak that still match
+    double start, end;
+    int threads;
+
+    OnsetEvaluation(std::string sessionFilename_)
+    {
+        sessionFilename = sessionFilename_;
+        frameRate = 60;
+        thresh = -1;
+        tolerance = 0.1;
+        start = end = -1;
+        threads = -1;
+    };
+
+    bool run(const std::vector<int> &horizons, bool retract)
+    {
+        OnsetRun reference(sessionFilename, PeakPrediction(), frameRate, thresh, threads);
+        if( !reference.isValid() ) return false;
+        reference.run(start, end);
+
+        //the reference against itself, for its own latency
+        OnsetComparison self(reference.getOnsets(), reference.getOnsets(), 0);
+        std::cout << "---------------------------------------------------------------------\n";
+        std::cout << "Onsets in " << sessionFilename << ", matched within " << tolerance * 1000.0 << " ms\n";
+        std::cout << " after the peak: " << self.reference << " onsets, sent " << OnsetComparison::percentile(self.latency, 0.5) << " ms after the peak at p50, "
+                  << OnsetComparison::percentile(self.latency, 0.9) << " at p90\n";
+
+        for(int h=0; h<horizons.size(); h++)
+        {
+            OnsetRun predicted(sessionFilename, PeakPrediction(horizons[h], retract), frameRate, thresh, threads);
+            predicted.run(start, end);
+            OnsetComparison c(reference.getOnsets(), predicted.getOnsets(), tolerance);
+            std::cout << " predicting " << horizons[h] << " sample(s) ahead" << (retract ? ", taking back" : "") << ": " << c.fired << " fired, "
+                      << c.retracted << " taken back -- precision " << c.getPrecision() << " (" << c.getPrecisionAsFired() << " as fired), recall "
+                      << c.getRecall() << ", sent " << OnsetComparison::percentile(c.latency, 0.5) << " ms after the peak at p50, "
+                      << OnsetComparison::percentile(c.latency, 0.9) << " at p90, " << OnsetComparison::mean(c.earlier) << " ms sooner on average\n";
+        }
+        std::cout << "---------------------------------------------------------------------\n";
+        return true;
+    };
+};
+
+};
+
+#endif /* OnsetEvaluation_h */
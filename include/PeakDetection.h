@@ -53,12 +53,187 @@ public:
     {
         return ( (peakTime + waitTime) < curTime );
     };
+    
+    //for taking a peak back -- see FindPeaks' predictive mode
+    double getLastPeakTime()
+    {
+        return peakTime;
+    };
+    
+    void setLastPeakTime(double t)
+    {
+        peakTime = t;
+    };
 };
 
 //---------------------------------------------------------------------------------------------
 //---------------------------------------------------------------------------------------------
 
-    //the actual ugen for finding peaks
+//a peak in one axis, found by PeakStream
+class PeakEvent
+{
+public:
+    //PEAK unless predicting: PREDICTED when the crossing is extrapolated, then CONFIRMED when it comes (w/the actual
+    //peak) or RETRACTED if it doesn't (w/the predicted one's sample, time & height)
+    enum Kind { PEAK=0, PREDICTED=1, CONFIRMED=2, RETRACTED=3 };
+    Kind kind;
+    int axis; //0, 1, 2 for x, y, z
+    long sample; //which sample it was at, counting from the first one the stream saw
+    double time; //& when, see PeakStream::sampleTime()
+    double height; //the signal (eg. the derivative) at the peak
+};
+
+//FindPeaks' predictive mode -- see FindPeaks::setPrediction()
+class PeakPrediction
+{
+public:
+    int horizon; //how many samples ahead the derivative is extrapolated, 0 for off
+    bool retract; //whether the onsets whose crossing doesn't come are taken back
+    
+    PeakPrediction(int horizon_ = 0, bool retract_ = true)
+    {
+        horizon = horizon_;
+        retract = retract_;
+    };
+};
+
+//a peak over its threshold, far enough from the last one to be its own event -- see FindPeaks::getOnsets()
+class PeakOnset
+{
+public:
+    int sensor; //the FindPeaks' id, eg. the body part's
+    int axis; //0, 1, 2 for x, y, z
+    double time; //the peak sample's, see PeakStream::sampleTime()
+    double height; //normalized, 0 at the threshold to 1 at the max -- as FindPeaks::getCurrentPeak()
+    double received; //when the packet w/the sample that showed it was a peak came in, for LatencyTrace
+    bool predicted; //fired before the crossing, see FindPeaks::setPrediction() -- its time is the sample it fired at
+};
+
+//finds peaks in the x, y & z of a signal a sample at a time -- where it goes from + to -, skipping the 0s (plateaus),
+//as matlab/octave's findpeaks does w/the derivative: https://octave.sourceforge.io/signal/function/findpeaks.html
+//The last non-zero value of each axis is kept from frame to frame, so each sample is only looked at once & a peak
+//between the last frame's samples & this one's isn't missed. The events are kept until clearEvents(), in a vector
+//w/room for them reserved up front.
+//
+//Predicting (setHorizon() > 0), a falling positive value whose slope from the sample before would take it to 0 or below
+//within the horizon is a PREDICTED peak, a sample or more before the crossing. If the crossing comes within the
+//horizon (or the sample after) it's CONFIRMED, if the value turns back up or it doesn't come it's RETRACTED.
+class PeakStream
+{
+protected:
+    double last[3]; //each axis' last non-zero value
+    long lastSample[3]; //& which sample it was
+    double lastTime[3]; //& when
+    long samples;
+    std::vector<PeakEvent> events;
+    
+    int horizon; //0 for no predicting
+    double prev[3]; //each axis' value the sample before, for the slope
+    bool predicting[3]; //whether a predicted peak is waiting for its crossing
+    PeakEvent predicted[3]; //& the peak
+    
+    void push(PeakEvent::Kind kind, int axis, long sample, double time, double height)
+    {
+        PeakEvent e;
+        e.kind = kind;
+        e.axis = axis;
+        e.sample = sample;
+        e.time = time;
+        e.height = height;
+        events.push_back(e);
+    };
+
+public:
+    PeakStream(int maxEvents = 32)
+    {
+        horizon = 0;
+        events.reserve(maxEvents);
+        reset();
+    };
+
+    void reset()
+    {
+        for(int a=0; a<3; a++)
+        {
+            last[a] = 0;
+            lastSample[a] = -1;
+            lastTime[a] = 0;
+            prev[a] = 0;
+            predicting[a] = false;
+        }
+        samples = 0;
+        events.clear();
+    };
+
+    //when the packet w/the sample arrived (MocapReceiver::now(), or the session's clock offline) -- each sample has its
+    //own, unlike the TIME_STAMP, which is the frame's. The TIME_STAMP if it didn't come from a receiver, eg. synthetic.
+    static double sampleTime(MocapDeviceData *d)
+    {
+        double t = d->getReceiveTime();
+        return t > 0 ? t : d->getData(MocapDeviceData::DataIndices::TIME_STAMP);
+    };
+
+    //the next sample -- its ACCELX, ACCELY & ACCELZ
+    void add(MocapDeviceData *d)
+    {
+        double t = sampleTime(d);
+        for(int a=0; a<3; a++)
+        {
+            double v = d->getData(MocapDeviceData::DataIndices::ACCELX + a);
+            double before = prev[a];
+            prev[a] = v;
+            bool crossed = v < 0 && last[a] > 0;
+            
+            if( predicting[a] && !crossed && ( v > before || samples - predicted[a].sample > horizon ) )
+            {
+                predicting[a] = false;
+                push(PeakEvent::RETRACTED, a, predicted[a].sample, predicted[a].time, predicted[a].height);
+            }
+            
+            if( v == 0 ) continue; //a plateau, the peak would be where it started
+            if( crossed )
+            {
+                push(predicting[a] ? PeakEvent::CONFIRMED : PeakEvent::PEAK, a, lastSample[a], lastTime[a], last[a]);
+                predicting[a] = false;
+            }
+            else if( horizon > 0 && !predicting[a] && v > 0 && before > 0 && v < before && v + (v - before)*horizon <= 0 )
+            {
+                predicting[a] = true;
+                push(PeakEvent::PREDICTED, a, samples, t, v);
+                predicted[a] = events.back();
+            }
+            last[a] = v;
+            lastSample[a] = samples;
+            lastTime[a] = t;
+        }
+        samples++;
+    };
+
+    //samples ahead to extrapolate, 0 to only find the crossings
+    void setHorizon(int h)
+    {
+        horizon = std::max(0, h);
+        for(int a=0; a<3; a++)
+            predicting[a] = false;
+    };
+
+    const std::vector<PeakEvent> &getEvents() { return events; };
+    void clearEvents() { events.clear(); };
+    long getSampleCount() { return samples; };
+};
+
+//---------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------
+
+    //the actual ugen for finding peaks -- each new sample of the derivative is looked at as it comes in, & every peak over
+    //the threshold that's far enough from the last (by the samples' times) is an onset, w/the time of its own sample.
+    //A frame can have any number of them: getOnsets(). getCombinedPeak() is whether there were any.
+    //
+    //A peak is only known once the derivative has gone below 0, the sample after it. setPrediction() fires before that,
+    //when the derivative is falling fast enough to get there within a sample or two (see PeakStream) -- a note can sound
+    //on the accent rather than after it. If the crossing doesn't come, the onset is taken back (getRetractions()) & the
+    //wait between peaks is as if it hadn't happened. A prediction under the threshold or too soon after the last onset
+    //doesn't stop its crossing being an onset as usual.
 class FindPeaks: public SignalAnalysis
 {
 protected:
@@ -67,20 +242,32 @@ protected:
     MocapDeviceData::DataIndices whichAxisPeak;
     double xThresh, yThresh, zThresh;
     float  waitBetweenPeaks;
-    bool combinedPeak; //whether there is a peak in the x y or z signals
+    bool combinedPeak; //whether there was an onset this frame
     int _id;
     std::string whichBodyPart;
     
     Derivative derivative; //we need this to find the peaks according to matlab func. using
+    Derivative *derivativeIn; //&derivative, or the same derivative from the graph -- see shareOwned()
+    PeakStream peakStream; //the peaks in the derivative's new samples, see PeakStream
+    std::vector<PeakOnset> onsets; //this frame's
     int newSamples;
     
+    PeakPrediction prediction;
+    std::vector<PeakOnset> retractions; //this frame's, see setPrediction()
+    bool predictedOnset[3]; //whether each axis' prediction is out as an onset, waiting for its crossing
+    PeakOnset predictedOnsets[3]; //& the onset
+    double timerBefore[3]; //& the last peak before it, to put back if it's retracted
+    LatencyTrace peakTrace; //the last peak's, if tracing -- see LatencyTrace.h
+    double oscTimeOffset; //added to the onsets' times in the OSC, see setOSCTimeOffset()
+    
 //    //send a note for each peak (obv. optional)
 //    MelodyGenerator *melodyGenerator;
 //    MidiNote note;
     
 public:
-    FindPeaks( float waitBetween, SignalAnalysis *s, int id_, std::string whichBodyPart_="", int bufferSize=12) : SignalAnalysis( s, bufferSize, NULL ), derivative(s, buffersize)
+    FindPeaks( float waitBetween, SignalAnalysis *s, int id_, std::string whichBodyPart_="", int bufferSize=12) : SignalAnalysis( s, bufferSize, NULL ), derivative(s, buffersize), peakStream(3*bufferSize)
     {
+        derivativeIn = &derivative;
         combinedPeak = false;
         _id = id_;
         whichBodyPart = whichBodyPart_;
@@ -93,6 +280,11 @@ public:
         curPeakHeight = 0; //current peak, of all axes
         whichAxisPeak = MocapDeviceData::DataIndices::ACCELX; //just a default
         newSamples = 0;
+        oscTimeOffset = 0;
+        onsets.reserve(bufferSize);
+        retractions.reserve(bufferSize);
+        for(int a=0; a<3; a++)
+            predictedOnset[a] = false;
         
 //        melodyGenerator = NULL;
 //        note = NULL;
@@ -108,11 +300,71 @@ public:
         return newSamples;
     };
     
+    virtual void getInputs(std::vector<UGEN *> &inputs)
+    {
+        SignalAnalysis::getInputs(inputs);
+        if( derivativeIn != &derivative ) inputs.push_back(derivativeIn);
+    };
+    
+    virtual void getOwnedUGENs(std::vector<UGEN *> &owned)
+    {
+        owned.push_back(&derivative);
+    };
+    
+    //reads an identical derivative the graph updates instead of taking its own -- eg. BodyPartSensor's
+    virtual bool shareOwned(UGEN *owned, UGEN *shared)
+    {
+        Derivative *d = dynamic_cast<Derivative *>(shared);
+        if( owned != &derivative || d == NULL ) return false;
+        derivativeIn = d;
+        return true;
+    };
+    
+    //whether there were any onsets this frame -- see getOnsets() for each of them
     bool getCombinedPeak()
     {
         return combinedPeak;
     };
     
+    //this frame's onsets, in the order of their samples -- however many came in, each at the time of its own sample
+    const std::vector<PeakOnset> &getOnsets()
+    {
+        return onsets;
+    };
+    
+    //the onsets taken back this frame, as they were in getOnsets() -- only w/setPrediction() & retracting
+    const std::vector<PeakOnset> &getRetractions()
+    {
+        return retractions;
+    };
+    
+    //fire onsets before the crossing -- see above & PeakPrediction. PeakPrediction() turns it off
+    void setPrediction(const PeakPrediction &p)
+    {
+        prediction = p;
+        peakStream.setHorizon(p.horizon);
+        for(int a=0; a<3; a++)
+            predictedOnset[a] = false;
+    };
+    
+    const PeakPrediction &getPrediction()
+    {
+        return prediction;
+    };
+    
+    //the onsets' times are the receiver's clock (MocapReceiver::now()) -- this puts the ones in the OSC on the app's, eg.
+    //w/getElapsedSeconds() - MocapReceiver::now(). getOnsets() & getRetractions() keep the receiver's
+    void setOSCTimeOffset(double offset)
+    {
+        oscTimeOffset = offset;
+    };
+    
+    //when the last peak's newest sample arrived & when it was found
+    const LatencyTrace &getPeakTrace()
+    {
+        return peakTrace;
+    };
+    
     void setThreshes(double x, double y, double z)
     {
         xThresh = x;
@@ -120,123 +372,24 @@ public:
         zThresh = z;
     };
     
-    //this is normalized
+    //this is normalized -- the highest onset this frame, or the last frame w/one
     double getCurrentPeak()
     {
         return curPeakHeight;
     };
     
-    //finds a peak in 1d buffered signal
-    void findpeaks(double input[], std::vector<double> &peaks, std::vector<int> &indices, int sz, int start )
-    {
-        //https://octave.sourceforge.io/signal/function/findpeaks.html --> documentation
-        
-        /* this algorithm is lifted straight from matlab/octave copied here:
-         y = y(:)';
-         
-         switch length(y)
-         case 0
-         ind = [];
-         case 1
-         ind = 1;
-         otherwise
-         dy = diff(y);
-         not_plateau_ind = find(dy~=0);
-         ind = find( ([dy(not_plateau_ind) 0]<0) & ([0 dy(not_plateau_ind)]>0) );
-         ind = not_plateau_ind(ind);
-         if y(1)>y(2)
-         ind = [1 ind];
-         end
-         if y(end-1)<y(end)
-         ind = [ind length(y)];
-         end
-         end
-         
-         if nargout > 1
-         peaks = y(ind);
-         end
-         
-         the important thing here is to test the cases at the edge, since this works with buffered sound instead of with complete vector like matlab
-         that is how I have altered the function other than xlating into C++
-         */
-        
-        //find non-zero
-        std::vector<int> not_plateau_ind;
-        for(int i=start; i<sz; i++)
-        {
-            if( input[i]!=0 ) not_plateau_ind.push_back(i);
-        }
-        
-        if(not_plateau_ind.empty()) return;
-        for( int i=1; i<not_plateau_ind.size()-1; i++ )
-        {
-            if( ( input[not_plateau_ind[i+1]] < 0 )  &  ( input[not_plateau_ind[i]] > 0 )  )
-            {
-                indices.push_back( not_plateau_ind[i]  );
-            }
-        }
-        
-        /* expanding the buffer input to this function takes care of edge cases (rather than the matlab version) */
-        for( int i=0; i<indices.size(); i++)
-            peaks.push_back(input[indices[i]]);
-        
-    }
-    
-    //find the peak for each axis.
-    bool findIC(int dataIndex, double &curpeak, double thresh=0.75 )
+    //every peak in the derivative found this frame, over the threshold or not
+    const std::vector<PeakEvent> &getPeakEvents()
     {
-        std::vector<double> inputX;
-        double input[data1.size()];
-        std::vector<double> xmin;
-        std::vector<int> xminIndex;
-    
-        //this mess is so I don't have to change the datatypes, hack hack hack
-
-        for(int i=0; i<data1.size(); i++)
-        {
-            input[i] = data1[i]->getData(dataIndex);
-        }
-
-        int windowSize;
-        
-//        if(data1[0]->getDeviceType()==MocapDeviceData::MocapDevice::IPHONE) //assume all data comes from the same device
-        windowSize = data1.size() - getNewSampleCount(); //really where we start in the data buffer
-        
-//        std::cout << "start: " << windowSize
-//        else
-//        {
-//            windowSize = data1.size() - 210; //really where we start in the data buffer
-//        }
-
-        
-        bool FoundPeakX = false; //have not found the peak yet
-        //    void findpeaks(double input[], std::vector<double> &peaks, std::vector<int> &indices, int sz, int start )
-
-        findpeaks( input, xmin, xminIndex, data1.size(), windowSize ); //send data to the re-written matlab function
-        
-        //makes sure the peaks found are greater than the threshhold
-        //also finds the curPeakHeight
-        curpeak = 0.0;
-
-//                std::cout << "xmin[i]: "; //NOTE: print out these values to check for what your thresholds should be
-        for( int i=0; i<xminIndex.size(); i++ )
-        {
-//            std::cout << xmin[i] << " , index: "  << xminIndex[i] << " , " ;
-            if(!FoundPeakX) FoundPeakX = (xminIndex[i] >= windowSize+4) && (xmin[i] > thresh );
-            if((xminIndex[i] >= windowSize+4))
-                curpeak = std::max( curpeak, xmin[i]);
-        }
-        
-//        std::cout << "FoundPeakX: "  << FoundPeakX << " thresh: " << thresh;
-
-//        std::cout << std::endl;
-        
-        
-
-        return FoundPeakX;
+        return peakStream.getEvents();
     };
     
+    double getThresh(int axis)
+    {
+        return axis == 0 ? xThresh : ( axis == 1 ? yThresh : zThresh );
+    };
     
+    //the axis of the highest onset this frame, or the last frame w/one
     MocapDeviceData::DataIndices whichAxisWasPeak()
     {
         return whichAxisPeak;
@@ -299,25 +452,29 @@ public:
         return p;
     };
     
-    //finds if there was a peak & how high it was & which axis
+    //finds the onsets in the derivative's new samples -- how high each was & which axis
     virtual void update(float seconds)
     {
         combinedPeak = false;
+        onsets.clear();
+        retractions.clear();
 
         SignalAnalysis::update(seconds);
-        derivative.update();
-        data1 =  derivative.getBuffer();
+        if( derivativeIn == &derivative ) derivative.update();
+        data1 =  derivativeIn->getBuffer();
+        peakStream.clearEvents();
+        newSamples = std::min( derivativeIn->getNewSampleCount(), int(data1.size()) );
 
         
         if( data1.size() < MIN_PEAK_WINDOW ) return ; //this is only useful if there is enough of a buffer
         
-        newSamples += derivative.getNewSampleCount();
-        
-        if( getNewSampleCount() <= 10 )
+        //only the derivative's new samples, all 3 axes in one go -- each sample's peaks are looked at as soon as it's in
+        const std::vector<PeakEvent> &events = peakStream.getEvents();
+        for(int i=data1.size()-newSamples; i<data1.size(); i++)
         {
-            
-            return ; //don't bother if no new samples
-            
+            int first = events.size();
+            peakStream.add(data1[i]);
+            if( events.size() > first ) addOnset(first, data1[i]);
         }
         
         //debug.
@@ -329,23 +486,21 @@ public:
 //            }
 //        }
         
-        peakTimer.update(seconds);
-        curPeakHeight = NO_DATA;
+        combinedPeak = onsets.size() > 0;
+        if( !combinedPeak ) return;
         
-        double peakx=0, peaky=0, peakz=0;
+        //the highest this frame is the current peak
+        int highest = 0;
+        for(int i=1; i<onsets.size(); i++)
+            if( onsets[i].height > onsets[highest].height ) highest = i;
+        curPeakHeight = onsets[highest].height;
+        whichAxisPeak = MocapDeviceData::DataIndices( MocapDeviceData::DataIndices::ACCELX + onsets[highest].axis );
         
-        combinedPeak = ( findIC(MocapDeviceData::DataIndices::ACCELX, peakx, xThresh) || findIC(MocapDeviceData::DataIndices::ACCELY, peaky, yThresh) || findIC(MocapDeviceData::DataIndices::ACCELZ, peakz, zThresh) );
-        
-        //we only count peaks that occur far enough apart to be considered a separate event
-        combinedPeak = ( combinedPeak ) && ( peakTimer.readyForNextPeak() );
-        
-//        if(!peakTimer.readyForNextPeak())
-//            std::cout << "not ready!!\n";
-
-        if(combinedPeak) //reset peak timer
-            peakTimer.peakHappened();
-        
-        curPeakHeight = findNormalizedPeakHeight(peakx, peaky, peakz); //find how big the peak was.
+        if(LatencyTracer::get().isEnabled())
+        {
+            peakTrace.received = onsets[onsets.size()-1].received;
+            peakTrace.detected = LatencyTracer::now();
+        }
         
 //        if(combinedPeak && melodyGenerator != NULL)
 //        {
@@ -353,8 +508,6 @@ public:
 //            if(notes.size()>0)
 //                note = notes[0];
 //        }
-        
-        newSamples = 0; //reset
     };
     
     virtual std::vector<ci::osc::Message> getOSC()
@@ -364,6 +517,18 @@ public:
         
         //TODO: add OSC messages here -- eg. if peak is true create and send a message
         
+        //the onsets taken back first -- an onset can be retracted & another fire in the same frame
+        for(int i=0; i<retractions.size(); i++)
+        {
+            ci::osc::Message retractMessage;
+            retractMessage.setAddress(NOTCH_ONSET_RETRACT);
+            retractMessage.append(whichBodyPart);
+            retractMessage.append(_id);
+            retractMessage.append(retractions[i].axis);
+            retractMessage.append(retractions[i].time + oscTimeOffset);
+            msgs.push_back(retractMessage);
+        }
+        
         //this tests the peak -- the count is to differentiate it from the last peak
         int isPeak = getCombinedPeak();
         ci::osc::Message peakMessage;
@@ -371,13 +536,96 @@ public:
         peakMessage.append(whichBodyPart); 
         peakMessage.append(_id);
         peakMessage.append(isPeak);
+        if(LatencyTracer::get().isAppendingOrigin())
+            peakMessage.append(isPeak ? peakTrace.received : 0.0);
 //        peakMessage.append(note.pitch);
         msgs.push_back(peakMessage);
+        
+        //& each onset on its own, w/when its sample was
+        for(int i=0; i<onsets.size(); i++)
+        {
+            ci::osc::Message onsetMessage;
+            onsetMessage.setAddress(NOTCH_ONSET);
+            onsetMessage.append(whichBodyPart);
+            onsetMessage.append(_id);
+            onsetMessage.append(onsets[i].axis);
+            onsetMessage.append(onsets[i].time + oscTimeOffset);
+            onsetMessage.append(float(onsets[i].height));
+            msgs.push_back(onsetMessage);
+        }
         return msgs;
     }
     
     
 protected:
+    //the peaks the sample showed, one per axis at most -- an onset if any is over its threshold (the highest above its
+    //threshold if more than one) & it's been long enough since the last one, by the samples' times
+    void addOnset(int first, MocapDeviceData *d)
+    {
+        const std::vector<PeakEvent> &events = peakStream.getEvents();
+        int best = -1;
+        double bestHeight = 0;
+        for(int i=first; i<events.size(); i++)
+        {
+            int a = events[i].axis;
+            if( events[i].kind == PeakEvent::RETRACTED )
+            {
+                retract(a);
+                continue;
+            }
+            if( events[i].kind == PeakEvent::CONFIRMED && predictedOnset[a] )
+            {
+                predictedOnset[a] = false; //it's already out
+                continue;
+            }
+            
+            double thresh = getThresh(a);
+            if( events[i].height <= thresh ) continue;
+            double h = ( events[i].height - thresh ) / ( 1 - thresh ); //as findNormalizedPeakHeight()
+            if( h > bestHeight )
+            {
+                best = i;
+                bestHeight = h;
+            }
+        }
+        if( best < 0 ) return;
+        
+        //we only count peaks that occur far enough apart to be considered a separate event
+        double lastPeak = peakTimer.getLastPeakTime();
+        peakTimer.update(events[best].time);
+        if( !peakTimer.readyForNextPeak() ) return;
+        peakTimer.peakHappened();
+        
+        PeakOnset onset;
+        onset.sensor = _id;
+        onset.axis = events[best].axis;
+        onset.time = events[best].time;
+        onset.height = bestHeight;
+        onset.received = d->getReceiveTime();
+        onset.predicted = events[best].kind == PeakEvent::PREDICTED;
+        onsets.push_back(onset);
+        
+        if( onset.predicted )
+        {
+            predictedOnset[onset.axis] = true;
+            predictedOnsets[onset.axis] = onset;
+            timerBefore[onset.axis] = lastPeak;
+        }
+    };
+    
+    //the axis' predicted onset didn't get its crossing
+    void retract(int a)
+    {
+        if( !predictedOnset[a] ) return;
+        predictedOnset[a] = false;
+        if( !prediction.retract ) return; //it stands
+        
+        //as if it hadn't happened, unless there's been another onset since
+        if( peakTimer.getLastPeakTime() == predictedOnsets[a].time )
+            peakTimer.setLastPeakTime(timerBefore[a]);
+        retractions.push_back(predictedOnsets[a]);
+    };
+    
     //linear interpolation function
     double lerp(double a, double b, double f)
     {
@@ -522,13 +770,25 @@ protected:
             leftOnset = leftFoot->getCombinedPeak();
             rightOnset = rightFoot->getCombinedPeak();
             
+            //every onset of either foot is a step, in the order of their samples -- the last one's is the current peak
+            const std::vector<PeakOnset> &left = leftFoot->getOnsets(), &right = rightFoot->getOnsets();
+            int l = 0, r = 0;
+            while( l < left.size() || r < right.size() )
+            {
+                if( r >= right.size() || ( l < left.size() && left[l].time <= right[r].time ) )
+                    curPeak = left[l++].height;
+                else curPeak = right[r++].height;
+                stepPeaks.push_back(curPeak, seconds);
+            }
+            
             if(fakeStep)
             {
                 fakeStep = false;
                 leftOnset = rightOnset = true;
-                //peak will still be 0 or whatever
+                stepPeaks.push_back(curPeak, seconds); //peak will still be 0 or whatever
             }
             
+            //which foot, for the motion data -- only one at a time
             if( leftOnset && rightOnset )
             {
                 if ( !lastLeftOnset )
@@ -537,14 +797,6 @@ protected:
                 }
                 else leftOnset = false;
             }
-            
-            if(leftOnset || rightOnset)
-            {
-                if( leftOnset )
-                    curPeak = leftFoot->getCurrentPeak();
-                else curPeak = rightFoot->getCurrentPeak();
-                stepPeaks.push_back(curPeak, seconds);
-            }
             if( stepPeaks.size() > 0 )
             {
                 timeSinceLastStep = seconds - stepPeaks.lastTime() ;
@@ -0,0 +1,387 @@
+//
+//  Profiler.h
+//  VideoAndOSCLab
+//
+//  Where the frame time goes. Each thing being timed (a probe, eg. one ugen's update()) gets an id from
+//  Profiler::probe(), & a ScopedProfile around the code adds how long it took, how many samples it did & how many slabs
+//  the sample pools had to allocate meanwhile to the counters of that probe. The counters are per thread & only written
+//  by their thread, so timing something is a clock read at each end & a few adds -- no locks, even w/the entities
+//  updating on several threads.
+//
+//  The times go into a histogram (4 buckets per doubling, 64ns to ~4s) so the p50 & p99 can be read off it.
+//  ProfileReporter collects all the threads' counters every few seconds & publishes what happened since the last time on
+//  STATS_OSCMESSAGE & to a rolling CSV file.
+//
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <mutex>
+#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+
+namespace CRCPMotionAnalysis {
+
+#define PROFILER_BUCKETS 105 //< 64ns, then 4 per doubling up to 2^32ns
+#define PROFILER_BLOCK_SIZE 64 //probes' counters are allocated this many at a time
+#define PROFILER_BLOCK_MAX 256 //so up to 16384 probes
+
+//one probe's counts on one thread -- only that thread writes them, anyone can read them
+class ProfileCounters
+{
+public:
+    std::atomic<long> calls;
+    std::atomic<long> nanos;
+    std::atomic<long> maxNanos; //since the last collect -- ProfileReporter resets it
+    std::atomic<long> samples;
+    std::atomic<long> allocations;
+    std::atomic<long> buckets[PROFILER_BUCKETS];
+
+    ProfileCounters()
+    {
+        calls.store(0);
+        nanos.store(0);
+        maxNanos.store(0);
+        samples.store(0);
+        allocations.store(0);
+        for(int i=0; i<PROFILER_BUCKETS; i++)
+            buckets[i].store(0);
+    };
+
+    //the owning thread's add -- no need for a locked add w/one writer
+    static inline void add(std::atomic<long> &counter, long n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    };
+
+    static int bucket(long ns)
+    {
+        if( ns < 64 ) return 0;
+        int octave = 63 - __builtin_clzl( (unsigned long) ns );
+        int b = 1 + (octave - 6)*4 + ( (ns >> (octave - 2)) & 3 );
+        return std::min(b, PROFILER_BUCKETS - 1);
+    };
+
+    //the longest time that goes in the bucket, in ns
+    static double bucketTop(int b)
+    {
+        if( b == 0 ) return 64;
+        return ldexp( 1.0 + ((b - 1) % 4 + 1) / 4.0, 6 + (b - 1) / 4 );
+    };
+
+    void record(long ns, long samples_, long allocations_)
+    {
+        add(calls, 1);
+        add(nanos, ns);
+        add(samples, samples_);
+        add(allocations, allocations_);
+        add(buckets[bucket(ns)], 1);
+        if( ns > maxNanos.load(std::memory_order_relaxed) ) maxNanos.store(ns, std::memory_order_relaxed);
+    };
+};
+
+//one thread's counters for all the probes
+class ProfileThread
+{
+protected:
+    std::atomic<ProfileCounters *> blocks[PROFILER_BLOCK_MAX];
+public:
+    ProfileThread()
+    {
+        for(int i=0; i<PROFILER_BLOCK_MAX; i++)
+            blocks[i].store(NULL);
+    };
+
+    //the owning thread -- makes the block if it's new
+    ProfileCounters *counters(int probe)
+    {
+        std::atomic<ProfileCounters *> &block = blocks[probe / PROFILER_BLOCK_SIZE];
+        ProfileCounters *b = block.load(std::memory_order_relaxed);
+        if( b == NULL )
+        {
+            b = new ProfileCounters[PROFILER_BLOCK_SIZE];
+            block.store(b, std::memory_order_release);
+        }
+        return &b[probe % PROFILER_BLOCK_SIZE];
+    };
+
+    //any thread -- NULL if this thread never ran the probe
+    ProfileCounters *find(int probe)
+    {
+        ProfileCounters *b = blocks[probe / PROFILER_BLOCK_SIZE].load(std::memory_order_acquire);
+        return b == NULL ? NULL : &b[probe % PROFILER_BLOCK_SIZE];
+    };
+};
+
+//one probe, all threads added up
+class ProfileTotals
+{
+public:
+    long calls, nanos, maxNanos, samples, allocations;
+    long buckets[PROFILER_BUCKETS];
+
+    ProfileTotals()
+    {
+        calls = nanos = maxNanos = samples = allocations = 0;
+        for(int i=0; i<PROFILER_BUCKETS; i++) buckets[i] = 0;
+    };
+
+    //in ns -- the top of the bucket it's in, so at most 25% over
+    double percentile(double p) const
+    {
+        long want = (long) ceil(p * calls);
+        long seen = 0;
+        for(int i=0; i<PROFILER_BUCKETS; i++)
+        {
+            seen += buckets[i];
+            if( seen >= want && seen > 0 ) return std::min( ProfileCounters::bucketTop(i), double(maxNanos) );
+        }
+        return maxNanos;
+    };
+
+    //what happened between before & now -- keeps now's max
+    ProfileTotals since(const ProfileTotals &before) const
+    {
+        ProfileTotals d;
+        d.calls = calls - before.calls;
+        d.nanos = nanos - before.nanos;
+        d.maxNanos = maxNanos;
+        d.samples = samples - before.samples;
+        d.allocations = allocations - before.allocations;
+        for(int i=0; i<PROFILER_BUCKETS; i++) d.buckets[i] = buckets[i] - before.buckets[i];
+        return d;
+    };
+};
+
+class Profiler
+{
+protected:
+    std::mutex lock; //for adding probes & threads
+    std::vector<std::string> names;
+    std::unordered_map<std::string, int> ids;
+    std::vector<ProfileThread *> threads;
+    std::atomic<bool> enabled;
+
+    Profiler() : enabled(true) {};
+
+public:
+    static Profiler &get()
+    {
+        static Profiler profiler;
+        return profiler;
+    };
+
+    //the id for the name -- the same name is the same probe
+    int probe(const std::string &name)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        std::unordered_map<std::string, int>::iterator iter = ids.find(name);
+        if( iter != ids.end() ) return iter->second;
+        if( names.size() >= PROFILER_BLOCK_SIZE * PROFILER_BLOCK_MAX ) return -1; //not timed
+
+        ids[name] = names.size();
+        names.push_back(name);
+        return names.size()-1;
+    };
+
+    std::string getName(int probe)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return names[probe];
+    };
+
+    int getProbeCount()
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return names.size();
+    };
+
+    bool isEnabled() { return enabled.load(std::memory_order_relaxed); };
+    void setEnabled(bool on) { enabled.store(on); };
+
+    //the calling thread's counters
+    ProfileThread *thisThread()
+    {
+        static thread_local ProfileThread *mine = NULL;
+        if( mine == NULL )
+        {
+            mine = new ProfileThread(); //kept after the thread ends -- its counts still count
+            std::lock_guard<std::mutex> l(lock);
+            threads.push_back(mine);
+        }
+        return mine;
+    };
+
+    //adds up every thread's counters. resetMax: start the max over for next time
+    void collect(std::vector<ProfileTotals> &totals, bool resetMax)
+    {
+        std::vector<ProfileThread *> all;
+        int probes;
+        {
+            std::lock_guard<std::mutex> l(lock);
+            all = threads;
+            probes = names.size();
+        }
+
+        totals.assign(probes, ProfileTotals());
+        for(int t=0; t<all.size(); t++)
+        {
+            for(int p=0; p<probes; p++)
+            {
+                ProfileCounters *c = all[t]->find(p);
+                if( c == NULL ) continue;
+                ProfileTotals &total = totals[p];
+                total.calls += c->calls.load(std::memory_order_relaxed);
+                total.nanos += c->nanos.load(std::memory_order_relaxed);
+                total.samples += c->samples.load(std::memory_order_relaxed);
+                total.allocations += c->allocations.load(std::memory_order_relaxed);
+                total.maxNanos = std::max(total.maxNanos, resetMax ? c->maxNanos.exchange(0) : c->maxNanos.load(std::memory_order_relaxed));
+                for(int i=0; i<PROFILER_BUCKETS; i++)
+                    total.buckets[i] += c->buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    };
+};
+
+//times from here to the end of the scope -- probe < 0 or the profiler off: does nothing
+class ScopedProfile
+{
+protected:
+    ProfileCounters *counters;
+    long samples;
+    long allocationsBefore;
+    std::chrono::steady_clock::time_point start;
+public:
+    ScopedProfile(int probe, long samples_ = 0)
+    {
+        counters = NULL;
+        if( probe < 0 || !Profiler::get().isEnabled() ) return;
+        counters = Profiler::get().thisThread()->counters(probe);
+        samples = samples_;
+        allocationsBefore = MocapDataPoolStats::threadSlabAllocations();
+        start = std::chrono::steady_clock::now();
+    };
+
+    //eg. once it's known how many were done
+    void setSamples(long samples_)
+    {
+        samples = samples_;
+    };
+
+    ~ScopedProfile()
+    {
+        if( counters == NULL ) return;
+        long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        counters->record(ns, samples, MocapDataPoolStats::threadSlabAllocations() - allocationsBefore);
+    };
+};
+
+//publishes the probes' stats every so often -- as OSC (STATS_OSCMESSAGE) & to a CSV file that starts over (the old one
+//is kept as .1) once it gets too big
+class ProfileReporter
+{
+protected:
+    double period;
+    double lastReport;
+    std::string filename;
+    long maxFileSize;
+    std::ofstream file;
+    std::vector<ProfileTotals> previous, current;
+
+    void openFile()
+    {
+        if( filename.empty() ) return;
+        file.open(filename.c_str(), std::ios::out | std::ios::app);
+        if( !file.is_open() ) std::cout << "ProfileReporter: could not open " << filename << "\n";
+        else if( file.tellp() <= 0 ) file << "seconds,probe,calls,p50 us,p99 us,max us,total ms,samples,allocations\n";
+    };
+
+    void rollFile()
+    {
+        if( !file.is_open() || file.tellp() < maxFileSize ) return;
+        file.close();
+        std::rename(filename.c_str(), (filename + ".1").c_str());
+        openFile();
+    };
+
+public:
+    //filename: empty for no file
+    ProfileReporter(std::string filename_ = "", double periodSeconds = 2.0, long maxFileBytes = 8*1024*1024)
+    {
+        filename = filename_;
+        period = periodSeconds;
+        lastReport = -1;
+        maxFileSize = maxFileBytes;
+        openFile();
+    };
+
+    //once a frame -- adds a message per probe that ran since the last report to msgs, if it is time
+    void update(double seconds, std::vector<ci::osc::Message> &msgs)
+    {
+        if( lastReport < 0 ) lastReport = seconds;
+        if( seconds - lastReport < period || !Profiler::get().isEnabled() ) return;
+        lastReport = seconds;
+
+        Profiler::get().collect(current, true);
+        previous.resize(current.size());
+        for(int p=0; p<current.size(); p++)
+        {
+            ProfileTotals d = current[p].since(previous[p]);
+            if( d.calls <= 0 ) continue;
+
+            std::string name = Profiler::get().getName(p);
+            float p50 = d.percentile(0.5) / 1000.0, p99 = d.percentile(0.99) / 1000.0, max = d.maxNanos / 1000.0;
+
+            ci::osc::Message msg;
+            msg.setAddress(STATS_OSCMESSAGE);
+            msg.append(name);
+            msg.append(int(d.calls));
+            msg.append(p50);
+            msg.append(p99);
+            msg.append(max);
+            msg.append(int(d.samples));
+            msg.append(int(d.allocations));
+            msgs.push_back(msg);
+
+            if( file.is_open() )
+                file << seconds << "," << name << "," << d.calls << "," << p50 << "," << p99 << "," << max << "," << d.nanos / 1000000.0
+                     << "," << d.samples << "," << d.allocations << "\n";
+        }
+        previous.swap(current);
+        if( file.is_open() )
+        {
+            file.flush();
+            rollFile();
+        }
+    };
+
+    //the top probes by total time, since the start
+    static void print(int top = 25)
+    {
+        std::vector<ProfileTotals> totals;
+        Profiler::get().collect(totals, false);
+
+        std::vector<int> order;
+        for(int p=0; p<totals.size(); p++)
+        {
+            if( totals[p].calls > 0 ) order.push_back(p);
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b){ return totals[a].nanos > totals[b].nanos; });
+
+        std::cout << "Profile -- calls, p50/p99/max us, total ms, samples, slab allocations:\n";
+        for(int i=0; i<order.size() && i<top; i++)
+        {
+            const ProfileTotals &t = totals[order[i]];
+            std::cout << " " << Profiler::get().getName(order[i]) << ": " << t.calls << ", " << t.percentile(0.5) / 1000.0 << "/"
+                      << t.percentile(0.99) / 1000.0 << "/" << t.maxNanos / 1000.0 << ", " << t.nanos / 1000000.0 << ", "
+                      << t.samples << ", " << t.allocations << "\n";
+        }
+    };
+};
+
+};
+
+#endif /* Profiler_h */
@@ -0,0 +1,124 @@
+//
+//  SPSCQueue.h
+//  VideoAndOSCLab
+//
+//  A fixed-size, lock-free queue for handing things from one thread to exactly one other thread (single producer, single
+//  consumer), eg. from the OSC receiving thread to update(). All the memory is allocated in the constructor, so pushing &
+//  popping never allocate or lock. If the queue is full, the push fails & the overflow is counted -- the producer never waits.
+//  (see xcode/concurrent_queue.h for the locking, unbounded version)
+//
+
+#ifndef SPSCQueue_h
+#define SPSCQueue_h
+
+#include <atomic>
+
+namespace CRCPMotionAnalysis {
+
+template<typename T>
+class SPSCQueue
+{
+protected:
+    std::vector<T> items;
+    size_t mask; //capacity - 1, capacity is a power of 2
+
+    //head is only written by the consumer & tail only by the producer. They only ever increase -- index with & mask
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+
+    //stats -- written by the producer only
+    std::atomic<long> pushed;
+    std::atomic<long> overflows;
+    std::atomic<size_t> highWater; //most items ever waiting at once
+
+public:
+    SPSCQueue(size_t capacity = 256) : head(0), tail(0), pushed(0), overflows(0), highWater(0)
+    {
+        size_t c = 1;
+        while( c < capacity ) c <<= 1;
+        items.resize(c);
+        mask = c - 1;
+    };
+
+    //producer thread only -- false if the queue was full & the item was dropped
+    bool push(const T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if( t - h > mask )
+        {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        if( t + 1 - h > highWater.load(std::memory_order_relaxed) )
+            highWater.store(t + 1 - h, std::memory_order_relaxed);
+        return true;
+    };
+
+    //producer thread only -- for filling an item in place when it is too big to copy twice. Returns NULL if full.
+    //call commitPush() when done filling it in
+    T *beginPush()
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if( t - h > mask )
+        {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        return &items[t & mask];
+    };
+
+    void commitPush()
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        tail.store(t + 1, std::memory_order_release);
+
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        if( t + 1 - h > highWater.load(std::memory_order_relaxed) )
+            highWater.store(t + 1 - h, std::memory_order_relaxed);
+    };
+
+    //consumer thread only -- false if there was nothing waiting
+    bool pop(T &item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if( h == tail.load(std::memory_order_acquire) ) return false;
+        item = items[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    };
+
+    //consumer thread only -- the oldest item without copying it out, or NULL. call popFront() when done with it
+    const T *front()
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if( h == tail.load(std::memory_order_acquire) ) return NULL;
+        return &items[h & mask];
+    };
+
+    void popFront()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    };
+
+    //how many are waiting -- only a snapshot if called from the other thread
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    };
+
+    size_t getCapacity() const { return mask + 1; };
+    long getPushedCount() const { return pushed.load(std::memory_order_relaxed); };
+    long getOverflowCount() const { return overflows.load(std::memory_order_relaxed); };
+    size_t getHighWater() const { return highWater.load(std::memory_order_relaxed); };
+};
+
+};
+
+#endif /* SPSCQueue_h */
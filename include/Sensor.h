@@ -18,7 +18,7 @@ namespace CRCPMotionAnalysis {
 class SensorData
 {
 public:
-    SensorData(std::string deviceID, int which, MocapDeviceData::MocapDevice d, MocapDeviceData::SendingDevice sendingDevice)
+    SensorData(std::string deviceID, int which, MocapDeviceData::MocapDevice d, MocapDeviceData::SendingDevice sendingDevice) : mBuffer(SENSORDATA_BUFFER_SIZE)
     {
         setDeviceID(deviceID);
         setWhichSensor(which);
@@ -29,6 +29,16 @@ public:
         mSendingDevice = sendingDevice;
     };
     
+    //gives back the samples still in the ring & the ones not added yet, so the pool stats' live count stays right --
+    //the pool's slabs (& so the samples' memory) go w/the sensor after this
+    virtual ~SensorData()
+    {
+        eraseData();
+        MocapSampleWindow window = mBuffer.window( mBuffer.size() );
+        for(int i=0; i<window.size(); i++)
+            mPool.release(window[i]);
+    };
+    
     inline int getWhichSensor()
     {
         //this is returning which sensor it is according to android/shimmer setup
@@ -55,6 +65,14 @@ public:
         whichSensor = sensor;
     };
     
+    //get a new sample of the right type for this sensor from the sensor's pool -- fill it in & then add it w/addSensorData()
+    MocapDeviceData *createSample()
+    {
+        MocapDeviceData *sample = mPool.acquire(device);
+        sample->setSendingDevice(mSendingDevice);
+        return sample;
+    };
+    
     void addSensorData( MocapDeviceData *data )
     {
         mSensorData.push_back(data);
@@ -62,9 +80,16 @@ public:
     
     void eraseData()
     {
+        for(int i=0; i<mSensorData.size(); i++)
+            mPool.release(mSensorData[i]);
         mSensorData.clear();
     };
     
+    MocapDeviceDataPool *getPool()
+    {
+        return &mPool;
+    };
+    
     virtual void update(float seconds)
     {
         cleanupBuffer();
@@ -73,16 +98,17 @@ public:
         mSensorData.clear();
     };
 
+    //a view of the last bufferSize samples, oldest first -- no copying. Valid until the next update()
+    virtual MocapSampleWindow getWindow( int bufferSize = 25 )
+    {
+        return mBuffer.window(bufferSize);
+    };
+    
+    //copy of the last bufferSize samples -- prefer getWindow()
     virtual std::vector<MocapDeviceData *> getBuffer( int bufferSize = 25 )
     {
-        if( bufferSize > mBuffer.size() )
-        {
-            return mBuffer;
-        }
-        std::vector<MocapDeviceData *>::iterator startIter = mBuffer.end() - bufferSize;
-        std::vector<MocapDeviceData *>::iterator endIter = mBuffer.end();
-        
-        return std::vector<MocapDeviceData *>( startIter, endIter );
+        MocapSampleWindow window = getWindow(bufferSize);
+        return std::vector<MocapDeviceData *>( window.begin(), window.end() );
     };
     
     //this gets all the new samples from the buffer
@@ -103,20 +129,9 @@ public:
         
     };
     
+    //the ring buffer drops the oldest samples as new ones come in (see addToBuffer()) so nothing to do here anymore
     virtual void cleanupBuffer()
     {
-        
-        if( mBuffer.size() > SENSORDATA_BUFFER_SIZE )
-        {
-            int numErase = mBuffer.size() - SENSORDATA_BUFFER_SIZE;
-            for(int i=0; i<numErase; i++ )
-            {
-                if( mBuffer[i] != NULL)
-                    delete mBuffer[i];
-                mBuffer[i] = NULL;
-            }
-            mBuffer.erase( mBuffer.begin(), mBuffer.begin()+numErase );
-        }
     };
     
 //    void setDancerLimb(int dancer, int limb)
@@ -135,6 +150,11 @@ public:
          return device;
      }
     
+    MocapDeviceData::SendingDevice getSendingDevice()
+    {
+        return mSendingDevice;
+    }
+    
     std::string getSendingDeviceString()
     {
         //hack hack
@@ -152,7 +172,7 @@ public:
     
 protected:
     std::vector<MocapDeviceData *> mSensorData;
-    std::vector<MocapDeviceData *> mBuffer; //keep a buffer data
+    MocapRingBuffer mBuffer; //keep a buffer data -- the last SENSORDATA_BUFFER_SIZE samples
     std::string mDeviceID;
     MocapDeviceData::MocapDevice device;
     MocapDeviceData::SendingDevice mSendingDevice;
@@ -162,13 +182,17 @@ protected:
     int whichDancer;
     int whichLimb;
     
+    MocapDeviceDataPool mPool; //where the samples come from & go back to
+    
     // BUFFER_SIZE
-    virtual void addToBuffer( std::vector<MocapDeviceData *> data )
+    virtual void addToBuffer( const std::vector<MocapDeviceData *> &data )
     {
-        
-        mBuffer.reserve( data.size() + mBuffer.size() ); // preallocate memory
-        mBuffer.insert( mBuffer.end(), data.begin(), data.end() );
-        
+        for(int i=0; i<data.size(); i++)
+        {
+            MocapDeviceData *oldest = mBuffer.push(data[i]);
+            if( oldest != NULL )
+                mPool.release(oldest); //back to the pool for the next incoming samples
+        }
     };
     
 };
@@ -0,0 +1,104 @@
+//
+//  SensorRegistry.h
+//  VideoAndOSCLab
+//
+//  Finds sensors by (device id, sensor #, sending device) with a hash lookup instead of searching the whole list.
+//  Device ids (eg. Notch bone names) are interned -- each name gets a small int id the first time it is seen -- and the
+//  same name ids are used by Entity to find its body parts.
+//
+
+#ifndef SensorRegistry_h
+#define SensorRegistry_h
+
+#include <unordered_map>
+
+namespace CRCPMotionAnalysis {
+
+//gives each distinct string a small int id, 0, 1, 2... in the order they are first seen
+class NameInterner
+{
+protected:
+    std::unordered_map<std::string, int> ids;
+    std::vector<std::string> names;
+public:
+    //the id for the name -- adds it if it is new
+    int intern(const std::string &name)
+    {
+        std::unordered_map<std::string, int>::iterator iter = ids.find(name);
+        if( iter != ids.end() ) return iter->second;
+
+        int id = names.size();
+        ids[name] = id;
+        names.push_back(name);
+        return id;
+    };
+
+    //the id for the name or -1 if it has never been seen
+    int find(const std::string &name) const
+    {
+        std::unordered_map<std::string, int>::const_iterator iter = ids.find(name);
+        if( iter == ids.end() ) return -1;
+        return iter->second;
+    };
+
+    const std::string &getName(int id) const
+    {
+        return names[id];
+    };
+
+    int size() const
+    {
+        return names.size();
+    };
+
+    //the body part/device names shared by the sensor registry & the entities
+    static NameInterner &bodyPartNames()
+    {
+        static NameInterner interner;
+        return interner;
+    };
+};
+
+//all the sensors which have sent us data, in the order they were added
+class SensorRegistry
+{
+protected:
+    std::vector<SensorData *> sensors;
+    std::unordered_map<unsigned long long, int> slots; //key (see makeKey()) -> index in sensors
+
+    //packs the name id, sensor # & sending device into one key
+    static unsigned long long makeKey(int nameID, int which, MocapDeviceData::SendingDevice sendingDevice)
+    {
+        return ( (unsigned long long)(unsigned int) nameID << 32 ) | ( (unsigned long long)((unsigned int) which & 0x0FFFFFFF) << 4 ) | ( (unsigned int) sendingDevice & 0xF );
+    };
+
+public:
+    //returns the sensor or NULL if it hasn't been added
+    SensorData *find(const std::string &deviceID, int which, MocapDeviceData::SendingDevice sendingDevice)
+    {
+        int nameID = NameInterner::bodyPartNames().find(deviceID);
+        if( nameID == -1 ) return NULL;
+
+        std::unordered_map<unsigned long long, int>::iterator iter = slots.find( makeKey(nameID, which, sendingDevice) );
+        if( iter == slots.end() ) return NULL;
+        return sensors[iter->second];
+    };
+
+    //adds the sensor & binds its name to its slot
+    void add(SensorData *sensor)
+    {
+        int nameID = NameInterner::bodyPartNames().intern(sensor->getDeviceID());
+        slots[ makeKey(nameID, sensor->getWhichSensor(), sensor->getSendingDevice()) ] = sensors.size();
+        sensors.push_back(sensor);
+    };
+
+    inline int size() const { return sensors.size(); };
+    inline bool empty() const { return sensors.empty(); };
+    inline SensorData *operator[](int i) const { return sensors[i]; };
+    inline std::vector<SensorData *>::const_iterator begin() const { return sensors.begin(); };
+    inline std::vector<SensorData *>::const_iterator end() const { return sensors.end(); };
+};
+
+};
+
+#endif /* SensorRegistry_h */
@@ -0,0 +1,357 @@
+//
+//  SessionPlayer.h
+//  VideoAndOSCLab
+//
+//  Plays back a session log recorded by SessionRecorder. The log is memory-mapped & the packet times are indexed when
+//  it is opened (from the index blocks, or by scanning if the recording was cut short), so seeking is a binary search.
+//  Playback can be slowed down or sped up (0.25x - 20x) & can loop a region. Packets are sent as they were received,
+//  over UDP -- or, w/playAsFastAsPossible(), handed straight to the analysis w/o a network or a clock, for re-analysing
+//  a long rehearsal quickly.
+//
+//  For the old CSV files, see PlayOSC.
+//
+
+#ifndef SessionPlayer_h
+#define SessionPlayer_h
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+
+namespace CRCPMotionAnalysis {
+
+#define SESSIONPLAYER_MIN_RATE 0.25
+#define SESSIONPLAYER_MAX_RATE 20.0
+
+//the read-only, memory-mapped session log & its time index
+class MappedSessionFile
+{
+protected:
+    const char *data;
+    size_t size;
+    double timeOffset;
+    std::vector<SessionIndexEntry> index; //every packet, in order, w/its receive time
+    bool valid;
+
+    uint32_t readUInt32(uint64_t offset) const
+    {
+        uint32_t n;
+        memcpy(&n, data + offset, 4);
+        return n;
+    };
+
+    uint64_t readUInt64(uint64_t offset) const
+    {
+        uint64_t n;
+        memcpy(&n, data + offset, 8);
+        return n;
+    };
+
+    double readDouble(uint64_t offset) const
+    {
+        double d;
+        memcpy(&d, data + offset, 8);
+        return d;
+    };
+
+    //is there a whole entry of this kind at offset?
+    bool isEntry(uint64_t offset, uint32_t kind) const
+    {
+        if( offset < SESSION_HEADER_SIZE || offset + SESSION_ENTRY_HEADER_SIZE > size ) return false;
+        return readUInt32(offset) == kind && offset + SESSION_ENTRY_HEADER_SIZE + readUInt32(offset + 4) <= size;
+    };
+
+    //follows the index blocks back from the end -- false if they are missing or damaged
+    bool readIndexBlocks()
+    {
+        uint64_t endOffset = size - SESSION_ENTRY_HEADER_SIZE - 16;
+        if( size < SESSION_HEADER_SIZE + SESSION_ENTRY_HEADER_SIZE + 16 || !isEntry(endOffset, SESSION_END) ) return false;
+
+        std::vector<uint64_t> blocks;
+        uint64_t offset = readUInt64(endOffset + SESSION_ENTRY_HEADER_SIZE);
+        while( offset != 0 )
+        {
+            if( !isEntry(offset, SESSION_INDEX) || blocks.size() > size / SESSION_ENTRY_HEADER_SIZE ) return false;
+            blocks.push_back(offset);
+            offset = readUInt64(offset + SESSION_ENTRY_HEADER_SIZE + 4);
+        }
+
+        //oldest first
+        for(int b=blocks.size()-1; b>=0; b--)
+        {
+            uint64_t payload = blocks[b] + SESSION_ENTRY_HEADER_SIZE;
+            uint32_t count = readUInt32(payload);
+            if( 12 + uint64_t(count)*16 > readUInt32(blocks[b] + 4) ) return false;
+            for(uint32_t i=0; i<count; i++)
+            {
+                SessionIndexEntry entry;
+                entry.time = readDouble(payload + 12 + i*16);
+                entry.offset = readUInt64(payload + 12 + i*16 + 8);
+                if( !isEntry(entry.offset, SESSION_PACKET) ) return false;
+                index.push_back(entry);
+            }
+        }
+        return true;
+    };
+
+    //reads through every entry -- for logs w/o an end, eg. if the app crashed while recording
+    void scanPackets()
+    {
+        index.clear();
+        uint64_t offset = SESSION_HEADER_SIZE;
+        while( offset + SESSION_ENTRY_HEADER_SIZE <= size )
+        {
+            uint32_t kind = readUInt32(offset);
+            uint64_t entrySize = SESSION_ENTRY_HEADER_SIZE + readUInt32(offset + 4);
+            if( offset + entrySize > size || kind == SESSION_END ) break;
+            if( kind == SESSION_PACKET && entrySize >= SESSION_ENTRY_HEADER_SIZE + 8 )
+            {
+                SessionIndexEntry entry;
+                entry.time = readDouble(offset + SESSION_ENTRY_HEADER_SIZE);
+                entry.offset = offset;
+                index.push_back(entry);
+            }
+            offset += entrySize;
+        }
+    };
+
+public:
+    MappedSessionFile(std::string filename)
+    {
+        data = NULL;
+        size = 0;
+        timeOffset = 0;
+        valid = false;
+
+        int fd = open(filename.c_str(), O_RDONLY);
+        if( fd < 0 ) return;
+        struct stat info;
+        if( fstat(fd, &info) == 0 && info.st_size >= SESSION_HEADER_SIZE )
+        {
+            size = info.st_size;
+            void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if( mapped != MAP_FAILED ) data = (const char *) mapped;
+        }
+        ::close(fd); //the mapping stays
+
+        if( data == NULL || memcmp(data, SESSION_MAGIC, 8) != 0 || readUInt32(8) != SESSION_VERSION ) return;
+        timeOffset = readDouble(16);
+
+        if( !readIndexBlocks() )
+        {
+            std::cout << "SessionPlayer: " << filename << " has no index (was it cut short?), scanning it...\n";
+            scanPackets();
+        }
+        valid = true;
+    };
+
+    ~MappedSessionFile()
+    {
+        if( data != NULL ) munmap((void *) data, size);
+    };
+
+    //true if the file starts like a session log, for telling these apart from the CSV files
+    static bool isSessionLog(std::string filename)
+    {
+        char magic[8];
+        FILE *f = fopen(filename.c_str(), "rb");
+        if( f == NULL ) return false;
+        bool yes = fread(magic, 1, 8, f) == 8 && memcmp(magic, SESSION_MAGIC, 8) == 0;
+        fclose(f);
+        return yes;
+    };
+
+    bool isValid() const { return valid; };
+    int getPacketCount() const { return index.size(); };
+
+    //in the recording app's seconds
+    double getTime(int i) const { return index[i].time + timeOffset; };
+    double getStartTime() const { return index.empty() ? 0 : getTime(0); };
+    double getEndTime() const { return index.empty() ? 0 : getTime(index.size()-1); };
+
+    //the raw OSC packet, pointing into the mapped file
+    const char *getPacket(int i, int &packetSize) const
+    {
+        uint64_t offset = index[i].offset;
+        packetSize = int( readUInt32(offset + 4) ) - 8;
+        return data + offset + SESSION_ENTRY_HEADER_SIZE + 8;
+    };
+
+    //the first packet at or after seconds
+    int findPacket(double seconds) const
+    {
+        int lo = 0, hi = index.size();
+        while( lo < hi )
+        {
+            int mid = (lo + hi) / 2;
+            if( getTime(mid) < seconds ) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    };
+};
+
+//sends raw OSC packets as they are, w/o making ci::osc::Messages of them. The socket is opened on the first send, so
+//a player that never sends (eg. playAsFastAsPossible()) doesn't need the network
+class RawUDPSender
+{
+protected:
+    int socketID;
+    struct sockaddr_in destination;
+public:
+    RawUDPSender(std::string desthost, int destport)
+    {
+        socketID = -1;
+        memset(&destination, 0, sizeof(destination));
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(destport);
+        inet_pton(AF_INET, desthost.c_str(), &destination.sin_addr);
+    };
+
+    ~RawUDPSender()
+    {
+        if( socketID >= 0 ) ::close(socketID);
+    };
+
+    bool send(const char *data, int size)
+    {
+        if( socketID < 0 ) socketID = socket(AF_INET, SOCK_DGRAM, 0);
+        return socketID >= 0 && sendto(socketID, data, size, 0, (struct sockaddr *) &destination, sizeof(destination)) == size;
+    };
+};
+
+class SessionPlayer
+{
+protected:
+    MappedSessionFile session;
+    RawUDPSender sender;
+
+    int cursor; //the next packet to send
+    double playhead; //where we are in the session, in the session's seconds
+    double lastSeconds; //the app's time at the last update()
+    bool started;
+    double rate;
+
+    bool looping;
+    double loopStart, loopEnd;
+
+public:
+    SessionPlayer(std::string filename, std::string desthost, int destport) : session(filename), sender(desthost, destport)
+    {
+        cursor = 0;
+        playhead = session.getStartTime();
+        lastSeconds = 0;
+        started = false;
+        rate = 1.0;
+        looping = false;
+        loopStart = loopEnd = 0;
+
+        if( !session.isValid() )
+            std::cout << "SessionPlayer: could not read " << filename << "\n";
+        else std::cout << "SessionPlayer: " << session.getPacketCount() << " packets, " << session.getEndTime() - session.getStartTime() << " seconds\n";
+    };
+
+    bool isValid()
+    {
+        return session.isValid();
+    };
+
+    //sends everything up to where we are now -- seconds is the app's time, as in PlayOSC::update()
+    void update(float seconds)
+    {
+        if( !session.isValid() ) return;
+        if( !started )
+        {
+            started = true;
+            lastSeconds = seconds;
+        }
+        playhead += (seconds - lastSeconds) * rate;
+        lastSeconds = seconds;
+
+        if( looping && playhead >= loopEnd )
+        {
+            sendUntil(loopEnd); //finish the loop, then go round
+            seek( loopStart + fmod(playhead - loopStart, loopEnd - loopStart) );
+        }
+        sendUntil(playhead);
+    };
+
+    //sends the packets up to & incl. the time, in session seconds
+    void sendUntil(double sessionSeconds)
+    {
+        int size;
+        while( cursor < session.getPacketCount() && session.getTime(cursor) <= sessionSeconds )
+        {
+            const char *packet = session.getPacket(cursor, size);
+            sender.send(packet, size);
+            cursor++;
+        }
+    };
+
+    //in the session's seconds, see getStartTime()
+    void seek(double sessionSeconds)
+    {
+        playhead = sessionSeconds;
+        cursor = session.findPacket(sessionSeconds);
+    };
+
+    void setRate(double r)
+    {
+        rate = std::max( SESSIONPLAYER_MIN_RATE, std::min(SESSIONPLAYER_MAX_RATE, r) );
+    };
+
+    double getRate() { return rate; };
+    double getPlayhead() { return playhead; };
+    double getStartTime() { return session.getStartTime(); };
+    double getEndTime() { return session.getEndTime(); };
+    bool isFinished() { return cursor >= session.getPacketCount() && !looping; };
+
+    //loops between the two times (session seconds) until clearLoop()
+    void setLoop(double start, double end)
+    {
+        if( end <= start ) return;
+        looping = true;
+        loopStart = start;
+        loopEnd = end;
+        if( playhead < loopStart || playhead >= loopEnd ) seek(loopStart);
+    };
+
+    void clearLoop()
+    {
+        looping = false;
+    };
+
+    bool isLooping() { return looping; };
+
+    //feeds the whole session (from the playhead on) to handler w/o waiting & w/o the network:
+    //handler.packet(const char *data, int size, double sessionSeconds) for each packet, then handler.frame(double sessionSeconds)
+    //each time frameSeconds of the session has gone by, which is when the analysis should update. Ignores the loop.
+    //Stops after untilSeconds (session seconds) if given
+    template<typename Handler>
+    void playAsFastAsPossible(Handler &handler, double frameSeconds, double untilSeconds = -1)
+    {
+        if( !session.isValid() ) return;
+        double frameTime = playhead + frameSeconds;
+        double endTime = untilSeconds < 0 ? session.getEndTime() : std::min(untilSeconds, session.getEndTime());
+        int size;
+        for( ; cursor < session.getPacketCount(); cursor++ )
+        {
+            double t = session.getTime(cursor);
+            if( t > endTime ) break;
+            while( t > frameTime )
+            {
+                handler.frame(frameTime);
+                frameTime += frameSeconds;
+            }
+            const char *packet = session.getPacket(cursor, size);
+            handler.packet(packet, size, t);
+        }
+        handler.frame(frameTime);
+        playhead = endTime;
+    };
+};
+
+};
+
+#endif /* SessionPlayer_h */
@@ -0,0 +1,367 @@
+//
+//  SessionRecorder.h
+//  VideoAndOSCLab
+//
+//  Records the incoming OSC to a binary session log, to replace writing a CSV line per message (see SaveOSC). The OSC
+//  receiving thread only copies each packet into a queue; a background thread writes them out through a big file buffer.
+//  convertToCSV() turns a session log into the CSV that SaveOSC wrote, so PlayOSC & any scripts still work. W/o the
+//  background thread, record() writes straight to the file & never drops anything -- for the offline analysis.
+//
+//  File layout -- all numbers are little-endian:
+//      header: "LMNTOSC1", uint32 version, uint32 unused, double timeOffset (add to a receive time to get app seconds)
+//      then entries, each: uint32 kind, uint32 payload size, payload
+//          'P' packet: double receive time, the raw OSC packet (a message or a bundle)
+//          'I' index:  uint32 count, uint64 file offset of the previous index (0 if none), then count x (double time,
+//                      uint64 file offset) for each packet since the previous index
+//          'E' end:    uint64 file offset of the last index, uint64 packet count
+//  Index blocks are written every SESSION_INDEX_INTERVAL seconds (or SESSION_INDEX_MAX_PACKETS), so a reader can seek by
+//  jumping back from the end through the indices instead of reading every packet.
+//
+
+#ifndef SessionRecorder_h
+#define SessionRecorder_h
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <iomanip>
+
+namespace CRCPMotionAnalysis {
+
+#define SESSION_MAGIC "LMNTOSC1"
+#define SESSION_VERSION 1
+#define SESSION_HEADER_SIZE 24
+#define SESSION_ENTRY_HEADER_SIZE 8
+#define SESSION_PACKET 'P'
+#define SESSION_INDEX 'I'
+#define SESSION_END 'E'
+#define SESSION_INDEX_INTERVAL 1.0 //seconds
+#define SESSION_INDEX_MAX_PACKETS 1024
+#define SESSION_QUEUE_SIZE 1024 //packets waiting to be written -- 8MB
+#define SESSION_FILE_BUFFER_SIZE (1 << 20)
+
+//one packet & where it is in the file -- an index entry
+class SessionIndexEntry
+{
+public:
+    double time;
+    uint64_t offset;
+};
+
+class SessionRecorder
+{
+protected:
+    FILE *file;
+    std::vector<char> fileBuffer;
+    uint64_t bytesWritten;
+
+    SPSCQueue<OSCRawPacket> queue; //from the receiving thread
+    std::thread writeThread;
+    std::atomic<bool> running;
+    bool background; //false: record() writes, no thread or queue
+
+    //writing thread only
+    std::vector<SessionIndexEntry> pendingIndex;
+    double indexStartTime;
+    uint64_t lastIndexOffset;
+    long packetsWritten;
+
+    std::atomic<long> oversizedPackets; //bigger than OSC_RAW_PACKET_MAX, not recorded
+
+    void write(const void *data, size_t size)
+    {
+        fwrite(data, 1, size, file);
+        bytesWritten += size;
+    };
+
+    void writeUInt32(uint32_t n) { write(&n, 4); };
+    void writeUInt64(uint64_t n) { write(&n, 8); };
+    void writeDouble(double d) { write(&d, 8); };
+
+    void writePacket(const char *data, int size, double receiveTime)
+    {
+        if( pendingIndex.empty() ) indexStartTime = receiveTime;
+
+        SessionIndexEntry entry;
+        entry.time = receiveTime;
+        entry.offset = bytesWritten;
+        pendingIndex.push_back(entry);
+
+        writeUInt32(SESSION_PACKET);
+        writeUInt32(8 + size);
+        writeDouble(receiveTime);
+        write(data, size);
+        packetsWritten++;
+
+        if( pendingIndex.size() >= SESSION_INDEX_MAX_PACKETS || receiveTime - indexStartTime >= SESSION_INDEX_INTERVAL )
+            writeIndex();
+    };
+
+    void writeIndex()
+    {
+        if( pendingIndex.empty() ) return;
+
+        uint64_t offset = bytesWritten;
+        writeUInt32(SESSION_INDEX);
+        writeUInt32(4 + 8 + pendingIndex.size()*16);
+        writeUInt32(pendingIndex.size());
+        writeUInt64(lastIndexOffset);
+        for(int i=0; i<pendingIndex.size(); i++)
+        {
+            writeDouble(pendingIndex[i].time);
+            writeUInt64(pendingIndex[i].offset);
+        }
+        lastIndexOffset = offset;
+        pendingIndex.clear();
+    };
+
+    void writeLoop()
+    {
+        while( true )
+        {
+            bool wrote = false;
+            const OSCRawPacket *packet;
+            while( (packet = queue.front()) != NULL )
+            {
+                writePacket(packet->data, packet->size, packet->receiveTime);
+                queue.popFront();
+                wrote = true;
+            }
+            if( !wrote )
+            {
+                if( !running.load() ) break; //stopped & everything is written
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        writeEnd();
+    };
+
+    void writeEnd()
+    {
+        writeIndex();
+        writeUInt32(SESSION_END);
+        writeUInt32(16);
+        writeUInt64(lastIndexOffset);
+        writeUInt64(packetsWritten);
+    };
+
+public:
+    //timeOffset is added to the receive times to get the app's seconds, eg. getElapsedSeconds() - MocapReceiver::now()
+    SessionRecorder(std::string filename, double timeOffset, bool background_=true) : queue(background_ ? SESSION_QUEUE_SIZE : 1), running(false), oversizedPackets(0)
+    {
+        background = background_;
+        bytesWritten = 0;
+        lastIndexOffset = 0;
+        packetsWritten = 0;
+        indexStartTime = 0;
+        pendingIndex.reserve(SESSION_INDEX_MAX_PACKETS);
+
+        file = fopen(filename.c_str(), "wb");
+        if( file == NULL )
+        {
+            std::cout << "SessionRecorder: could not open " << filename << " for writing. Not recording.\n";
+            return;
+        }
+        fileBuffer.resize(SESSION_FILE_BUFFER_SIZE);
+        setvbuf(file, &fileBuffer[0], _IOFBF, fileBuffer.size());
+
+        write(SESSION_MAGIC, 8);
+        writeUInt32(SESSION_VERSION);
+        writeUInt32(0);
+        writeDouble(timeOffset);
+
+        if( !background ) return;
+        running.store(true);
+        writeThread = std::thread(&SessionRecorder::writeLoop, this);
+    };
+
+    ~SessionRecorder()
+    {
+        close();
+    };
+
+    bool isOpen()
+    {
+        return file != NULL;
+    };
+
+    //writes out whatever is still waiting, then closes the file
+    void close()
+    {
+        if( file == NULL ) return;
+        running.store(false);
+        if( writeThread.joinable() ) writeThread.join();
+        else writeEnd();
+        fclose(file);
+        file = NULL;
+    };
+
+    //receiving thread -- just a copy into the queue (or straight to the file w/o the background thread). false if dropped
+    bool record(const char *data, int size, double receiveTime)
+    {
+        if( !background )
+        {
+            if( file == NULL ) return false;
+            writePacket(data, size, receiveTime);
+            return true;
+        }
+        if( size > OSC_RAW_PACKET_MAX )
+        {
+            oversizedPackets.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        OSCRawPacket *packet = queue.beginPush();
+        if( packet == NULL ) return false; //full -- counted by the queue
+        memcpy(packet->data, data, size);
+        packet->size = size;
+        packet->receiveTime = receiveTime;
+        queue.commitPush();
+        return true;
+    };
+
+    void printStats()
+    {
+        if( !background )
+        {
+            std::cout << " session recorder: " << packetsWritten << " packets written\n";
+            return;
+        }
+        std::cout << " session recorder: " << queue.getPushedCount() << " packets recorded, queue max " << queue.getHighWater() << "/" << queue.getCapacity()
+                  << ", dropped " << queue.getOverflowCount() << " (queue full) & " << oversizedPackets.load() << " (too big)\n";
+    };
+
+    //writes each message in the session log as a line of SaveOSC's CSV. false if the log couldn't be read
+    static bool convertToCSV(std::string sessionFilename, std::string csvFilename);
+};
+
+//reads a session log from start to end, one packet at a time
+class SessionFileReader
+{
+protected:
+    FILE *file;
+    double timeOffset;
+    bool valid;
+
+    template<typename T>
+    bool read(T &value)
+    {
+        return fread(&value, sizeof(T), 1, file) == 1;
+    };
+
+public:
+    SessionFileReader(std::string filename)
+    {
+        timeOffset = 0;
+        valid = false;
+        file = fopen(filename.c_str(), "rb");
+        if( file == NULL ) return;
+
+        char magic[8];
+        uint32_t version, unused;
+        valid = fread(magic, 1, 8, file) == 8 && memcmp(magic, SESSION_MAGIC, 8) == 0
+            && read(version) && version == SESSION_VERSION && read(unused) && read(timeOffset);
+    };
+
+    ~SessionFileReader()
+    {
+        if( file != NULL ) fclose(file);
+    };
+
+    bool isValid()
+    {
+        return valid;
+    };
+
+    double getTimeOffset()
+    {
+        return timeOffset;
+    };
+
+    //the next packet & its time in app seconds -- false at the end of the log. Skips over the index blocks
+    bool nextPacket(double &seconds, std::vector<char> &packet)
+    {
+        uint32_t kind, size;
+        while( valid && read(kind) && read(size) )
+        {
+            if( kind == SESSION_END ) return false;
+            if( kind != SESSION_PACKET )
+            {
+                fseek(file, size, SEEK_CUR);
+                continue;
+            }
+
+            double receiveTime;
+            if( size < 8 || !read(receiveTime) ) break;
+            packet.resize(size - 8);
+            if( !packet.empty() && fread(&packet[0], 1, packet.size(), file) != packet.size() ) break;
+            seconds = receiveTime + timeOffset;
+            return true;
+        }
+        return false; //the end, or the recording was cut short
+    };
+};
+
+//writes messages as SaveOSC::add() did -- time, address, type tags, then the args (PlayOSC reads the tags w/o the comma)
+class SessionCSVWriter
+{
+public:
+    std::ostream *out;
+    double seconds;
+    long messages;
+
+    void operator()(const OSCMessageReader &msg)
+    {
+        std::ostream &o = *out;
+        o << std::setprecision(9) << seconds << "," << msg.getAddress() << "," << msg.getTypeTags();
+
+        OSCArgReader arg = msg.getArgs();
+        int len;
+        while( !arg.atEnd() )
+        {
+            o << ",";
+            switch( arg.getType() )
+            {
+                case 'i': o << arg.readInt32(); break;
+                case 'f': o << std::setprecision(9) << arg.readFloat(); break; //enough digits to get the same float back
+                case 'd': o << std::setprecision(17) << arg.readDouble(); break;
+                case 's': o << arg.readString(len); break;
+                default: arg.skip(); break; //SaveOSC left these empty too
+            }
+        }
+        o << "\n";
+        messages++;
+    };
+};
+
+inline bool SessionRecorder::convertToCSV(std::string sessionFilename, std::string csvFilename)
+{
+    SessionFileReader reader(sessionFilename);
+    if( !reader.isValid() )
+    {
+        std::cout << "SessionRecorder: " << sessionFilename << " is not a session log.\n";
+        return false;
+    }
+    std::ofstream csv(csvFilename.c_str(), std::ios::out | std::ios::trunc);
+    if( !csv.is_open() )
+    {
+        std::cout << "SessionRecorder: could not open " << csvFilename << " for writing.\n";
+        return false;
+    }
+
+    SessionCSVWriter writer;
+    writer.out = &csv;
+    writer.messages = 0;
+    std::vector<char> packet;
+    long packets = 0;
+    while( reader.nextPacket(writer.seconds, packet) )
+    {
+        oscForEachMessage(packet.data(), packet.size(), writer);
+        packets++;
+    }
+    std::cout << "SessionRecorder: wrote " << writer.messages << " messages from " << packets << " packets to " << csvFilename << "\n";
+    return true;
+}
+
+};
+
+#endif /* SessionRecorder_h */
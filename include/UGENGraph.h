@@ -0,0 +1,424 @@
+//
+//  UGENGraph.h
+//  VideoAndOSCLab
+//
+//  Updates a set of ugens in an order that respects what reads what, running the ones that don't depend on each other
+//  at the same time. Each ugen waits for its inputs (UGEN::getInputs() -- for the signal analyses, their ugen & ugen2) &
+//  anything added w/addDependency(). The order is worked out once in prepare(), then run() goes through the graph every
+//  frame: eg. each bone's input -> averaging -> derivative/peaks chain runs on its own, & only the nodes that read many
+//  bones, like the figure & its measures, wait for all of them. Ugens only read their inputs' samples, never change
+//  them, so the ones reading the same input run at the same time.
+//
+//  run() is work-stealing: each thread keeps the nodes it made ready on its own list & takes from the back of it, & when
+//  it runs out it takes from the front of another thread's list. Inputs that aren't in the graph (eg. the sensors) are
+//  taken to be updated already.
+//
+//  Each node is timed w/its own probe (see Profiler.h), named after the label it was added w/& the ugen's class.
+//
+//  prepare() also looks for ugens doing the same work twice -- the same signature (UGEN::getSignature(), the class &
+//  parameters) reading the same inputs.
+//  Ugens that a node keeps & updates itself, like FindPeaks' derivative, are replaced by an identical node if there is
+//  one (UGEN::shareOwned()), & the node then waits for it. dump() lists the nodes & what was shared.
+//
+
+#ifndef UGENGraph_h
+#define UGENGraph_h
+
+#include <deque>
+#include <typeinfo>
+#include <cxxabi.h>
+
+namespace CRCPMotionAnalysis {
+
+class UGENGraph
+{
+protected:
+    class Node
+    {
+    public:
+        UGEN *ugen; //NULL for a task
+        int probe; //for timing it
+        std::string name; //the probe's
+        std::function<void(float)> task; //runs instead of ugen->update() if set
+        std::vector<UGEN *> inputs; //turned into edges by prepare()
+        std::vector<int> waitFor; //other nodes this one waits for
+        std::vector<int> dependents; //the nodes waiting for this one -- from prepare()
+        int inputCount; //how many nodes this one waits for
+        int depth; //longest chain of nodes up to & incl. this one
+    };
+
+    //one thread's ready nodes
+    class ReadyList
+    {
+    public:
+        std::mutex lock;
+        std::deque<int> nodes;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> order; //topological -- parents first
+    std::vector<int> roots; //nodes w/nothing to wait for
+    std::atomic<int> *waiting; //per node, how many of its inputs are still to be updated this frame
+    std::atomic<int> finished;
+    std::vector<ReadyList *> readyLists;
+    int depth;
+    bool prepared;
+
+    //from shareDuplicates()
+    class Shared
+    {
+    public:
+        int node; //whose ugen
+        std::string type; //the owned ugen's
+        int with; //the node it reads instead
+    };
+    std::vector<Shared> shared;
+    int ownedCount; //ugens the nodes keep themselves, shared or not
+
+    void push(int list, int node)
+    {
+        std::lock_guard<std::mutex> l(readyLists[list]->lock);
+        readyLists[list]->nodes.push_back(node);
+    };
+
+    //the newest from our own list, else the oldest from someone else's
+    bool take(int list, int &node)
+    {
+        for(int i=0; i<readyLists.size(); i++)
+        {
+            ReadyList *ready = readyLists[ (list + i) % readyLists.size() ];
+            std::lock_guard<std::mutex> l(ready->lock);
+            if( ready->nodes.empty() ) continue;
+            if( i == 0 )
+            {
+                node = ready->nodes.back();
+                ready->nodes.pop_back();
+            }
+            else
+            {
+                node = ready->nodes.front();
+                ready->nodes.pop_front();
+            }
+            return true;
+        }
+        return false;
+    };
+
+    void updateNode(int n, float seconds)
+    {
+        ScopedProfile timer(nodes[n].probe);
+        if( nodes[n].task ) nodes[n].task(seconds);
+        else
+        {
+            nodes[n].ugen->update(seconds);
+            timer.setSamples(nodes[n].ugen->getNewSampleCount());
+        }
+    };
+
+    //one thread's share of run() -- until every node is done
+    void work(int list, float seconds)
+    {
+        while( finished.load(std::memory_order_acquire) < nodes.size() )
+        {
+            int n;
+            if( !take(list, n) )
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            updateNode(n, seconds);
+
+            const std::vector<int> &dependents = nodes[n].dependents;
+            for(int i=0; i<dependents.size(); i++)
+            {
+                if( waiting[dependents[i]].fetch_sub(1, std::memory_order_acq_rel) == 1 )
+                    push(list, dependents[i]);
+            }
+            finished.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    //what a ugen works out from what: its signature & its inputs. "" if it can't be shared
+    std::string workKey(UGEN *ugen)
+    {
+        std::string signature = ugen->getSignature();
+        if( signature.empty() ) return "";
+        std::vector<UGEN *> inputs;
+        ugen->getInputs(inputs);
+        std::stringstream key;
+        key << signature;
+        for(int i=0; i<inputs.size(); i++)
+            key << " " << (void *) inputs[i];
+        return key.str();
+    };
+
+    //gives the nodes' own ugens that an earlier node already works out that node instead
+    void shareDuplicates()
+    {
+        shared.clear();
+        ownedCount = 0;
+        std::unordered_map<std::string, int> byKey; //the first node w/each
+        for(int i=0; i<nodes.size(); i++)
+        {
+            UGEN *ugen = nodes[i].ugen;
+            if( ugen == NULL ) continue;
+
+            std::string key = workKey(ugen);
+            if( !key.empty() && byKey.find(key) == byKey.end() ) byKey[key] = i;
+
+            std::vector<UGEN *> owned;
+            ugen->getOwnedUGENs(owned);
+            ownedCount += owned.size();
+            for(int j=0; j<owned.size(); j++)
+            {
+                std::unordered_map<std::string, int>::iterator iter = byKey.find( workKey(owned[j]) );
+                if( iter == byKey.end() || !ugen->shareOwned(owned[j], nodes[iter->second].ugen) ) continue;
+                nodes[i].inputs.push_back( nodes[iter->second].ugen );
+
+                Shared s;
+                s.node = i;
+                s.type = typeName(owned[j]);
+                s.with = iter->second;
+                shared.push_back(s);
+            }
+        }
+    };
+
+    void clearReadyLists()
+    {
+        for(int i=0; i<readyLists.size(); i++)
+            delete readyLists[i];
+        readyLists.clear();
+    };
+
+public:
+    UGENGraph() : finished(0)
+    {
+        waiting = NULL;
+        depth = 0;
+        prepared = false;
+        ownedCount = 0;
+    };
+
+    ~UGENGraph()
+    {
+        clear();
+    };
+
+    void clear()
+    {
+        nodes.clear();
+        order.clear();
+        roots.clear();
+        if( waiting != NULL ) delete [] waiting;
+        waiting = NULL;
+        clearReadyLists();
+        shared.clear();
+        ownedCount = 0;
+        depth = 0;
+        prepared = false;
+    };
+
+    //the ugen's class w/o the namespace, eg. "AveragingFilter"
+    static std::string typeName(UGEN *ugen)
+    {
+        int status;
+        char *demangled = abi::__cxa_demangle(typeid(*ugen).name(), NULL, NULL, &status);
+        std::string name = status == 0 ? demangled : typeid(*ugen).name();
+        if( demangled != NULL ) free(demangled);
+
+        size_t colons = name.rfind("::");
+        return colons == std::string::npos ? name : name.substr(colons + 2);
+    };
+
+    //returns the node's index -- the ugen is updated once its inputs have been. label: for the profiler, eg. the body part
+    int add(UGEN *ugen, const std::string &label = "")
+    {
+        Node node;
+        node.ugen = ugen;
+        node.name = label + typeName(ugen);
+        node.probe = Profiler::get().probe(node.name);
+        ugen->getInputs(node.inputs);
+        nodes.push_back(node);
+        prepared = false;
+        return nodes.size()-1;
+    };
+
+    //something that isn't a ugen, eg. taking the notes after a body part's ugens are updated
+    int addTask(std::function<void(float)> task, const std::string &label = "task")
+    {
+        Node node;
+        node.ugen = NULL;
+        node.name = label;
+        node.probe = Profiler::get().probe(label);
+        node.task = task;
+        nodes.push_back(node);
+        prepared = false;
+        return nodes.size()-1;
+    };
+
+    //node also waits for before -- eg. when before reads something node writes
+    void addDependency(int node, int before)
+    {
+        nodes[node].waitFor.push_back(before);
+        prepared = false;
+    };
+
+    void addDependency(int node, UGEN *before)
+    {
+        nodes[node].inputs.push_back(before);
+        prepared = false;
+    };
+
+    //works out the order -- call after adding everything. false if there's a loop, in which case run() goes through the
+    //nodes in the order they were added
+    bool prepare()
+    {
+        shareDuplicates();
+
+        std::unordered_map<UGEN *, int> index;
+        for(int i=0; i<nodes.size(); i++)
+        {
+            if( nodes[i].ugen != NULL ) index[nodes[i].ugen] = i;
+        }
+
+        for(int i=0; i<nodes.size(); i++)
+        {
+            Node &node = nodes[i];
+            node.dependents.clear();
+            node.inputCount = 0;
+            node.depth = 1;
+        }
+        for(int i=0; i<nodes.size(); i++)
+        {
+            std::vector<int> before = nodes[i].waitFor;
+            for(int j=0; j<nodes[i].inputs.size(); j++)
+            {
+                std::unordered_map<UGEN *, int>::iterator iter = index.find(nodes[i].inputs[j]);
+                if( iter == index.end() ) continue;
+                before.push_back(iter->second);
+            }
+            std::sort(before.begin(), before.end());
+            before.erase( std::unique(before.begin(), before.end()), before.end() );
+
+            for(int j=0; j<before.size(); j++)
+                nodes[ before[j] ].dependents.push_back(i);
+            nodes[i].inputCount = before.size();
+        }
+
+        //Kahn's -- a node goes in once all it waits for have
+        order.clear();
+        roots.clear();
+        std::vector<int> left(nodes.size());
+        for(int i=0; i<nodes.size(); i++)
+        {
+            left[i] = nodes[i].inputCount;
+            if( left[i] == 0 )
+            {
+                order.push_back(i);
+                roots.push_back(i);
+            }
+        }
+        depth = 0;
+        for(int k=0; k<order.size(); k++)
+        {
+            Node &node = nodes[ order[k] ];
+            depth = std::max(depth, node.depth);
+            for(int j=0; j<node.dependents.size(); j++)
+            {
+                Node &dependent = nodes[ node.dependents[j] ];
+                dependent.depth = std::max(dependent.depth, node.depth + 1);
+                if( --left[ node.dependents[j] ] == 0 ) order.push_back( node.dependents[j] );
+            }
+        }
+
+        if( waiting != NULL ) delete [] waiting;
+        waiting = new std::atomic<int>[nodes.size()];
+
+        prepared = order.size() == nodes.size();
+        if( !prepared )
+        {
+            std::cout << "UGENGraph: the ugens' inputs make a loop, updating them one at a time in the order they were added\n";
+            order.clear();
+            for(int i=0; i<nodes.size(); i++)
+                order.push_back(i);
+        }
+        return prepared;
+    };
+
+    //updates every node, on the pool's threads & this one
+    void run(float seconds, WorkerPool &workers)
+    {
+        if( !prepared || workers.getThreadCount() == 0 || nodes.size() <= 1 )
+        {
+            for(int i=0; i<order.size(); i++)
+                updateNode(order[i], seconds);
+            return;
+        }
+
+        int threads = workers.getThreadCount() + 1;
+        if( readyLists.size() != threads )
+        {
+            clearReadyLists();
+            for(int i=0; i<threads; i++)
+                readyLists.push_back(new ReadyList());
+        }
+
+        for(int i=0; i<nodes.size(); i++)
+            waiting[i].store(nodes[i].inputCount, std::memory_order_relaxed);
+        finished.store(0, std::memory_order_relaxed);
+        for(int i=0; i<roots.size(); i++)
+            readyLists[i % threads]->nodes.push_back(roots[i]);
+
+        workers.run(threads, [&](int list){ work(list, seconds); });
+    };
+
+    int getNodeCount() { return nodes.size(); };
+
+    //the longest chain of nodes -- w/enough threads, a frame takes about this many nodes' time
+    int getDepth() { return depth; };
+
+    //ugens updated each frame, counting the ones the nodes keep themselves -- before & after sharing the duplicates
+    int getUGENCount() { return nodes.size() + ownedCount; };
+    int getSharedCount() { return shared.size(); };
+
+    //every node in the order they're run, w/the nodes each one waits for & what it shares -- after prepare()
+    void dump(std::ostream &out)
+    {
+        std::unordered_map<UGEN *, int> index;
+        for(int i=0; i<nodes.size(); i++)
+        {
+            if( nodes[i].ugen != NULL ) index[nodes[i].ugen] = i;
+        }
+
+        out << "UGENGraph: " << nodes.size() << " nodes & " << ownedCount << " ugens kept inside them, " << shared.size() << " of those shared w/identical nodes -- "
+            << getUGENCount() << " ugens before sharing, " << getUGENCount() - shared.size() << " after. " << depth << " deep\n";
+        for(int k=0; k<order.size(); k++)
+        {
+            int n = order[k];
+            out << "  #" << n << " " << nodes[n].name << " (" << nodes[n].depth << ")";
+            int outside = 0;
+            std::stringstream after;
+            for(int j=0; j<nodes[n].inputs.size(); j++)
+            {
+                std::unordered_map<UGEN *, int>::iterator iter = index.find(nodes[n].inputs[j]);
+                if( iter == index.end() ) outside++;
+                else after << " #" << iter->second;
+            }
+            for(int j=0; j<nodes[n].waitFor.size(); j++)
+                after << " #" << nodes[n].waitFor[j];
+            if( !after.str().empty() ) out << " <-" << after.str();
+            if( outside > 0 ) out << " <- " << outside << " outside";
+            for(int i=0; i<shared.size(); i++)
+            {
+                if( shared[i].node == n ) out << " [its " << shared[i].type << " is #" << shared[i].with << "]";
+            }
+            out << "\n";
+        }
+    };
+};
+
+};
+
+#endif /* UGENGraph_h */
@@ -14,21 +14,75 @@ namespace CRCPMotionAnalysis {
     
     static const double SR = 40; // Sample rate -- this may vary for sensors...
     
+    //what ugens hand each other -- a view of another ugen's (or sensor's) samples, oldest first, + how many of them are new this frame
+    //no copying -- it points into the buffer of whoever made it so it is only valid until that ugen updates again
+    class MocapBufferView
+    {
+    protected:
+        MocapDeviceData * const *samples;
+        int count;
+        int newSamples;
+    public:
+        MocapBufferView(MocapDeviceData * const *s = NULL, int c = 0, int newCount = 0)
+        {
+            samples = s;
+            count = c;
+            newSamples = newCount;
+        };
+        
+        MocapBufferView(const std::vector<MocapDeviceData *> &v, int newCount = 0)
+        {
+            samples = v.empty() ? NULL : v.data();
+            count = v.size();
+            newSamples = newCount;
+        };
+        
+        inline int size() const { return count; };
+        inline bool empty() const { return count <= 0; };
+        inline int getNewSampleCount() const { return newSamples; };
+        
+        inline MocapDeviceData *operator[](int i) const { return samples[i]; };
+        inline MocapDeviceData * const *begin() const { return samples; };
+        inline MocapDeviceData * const *end() const { return samples + count; };
+        
+        //for the odd function that still wants its own copy
+        std::vector<MocapDeviceData *> toVector() const
+        {
+            return std::vector<MocapDeviceData *>( begin(), end() );
+        };
+    };
+    
     
     //abstract class of all ugens
     class UGEN
     {
     public:
         UGEN(){};
+        virtual ~UGEN(){}; //they're deleted through UGEN * -- eg. by whoever made the chain
         virtual std::vector<ci::osc::Message> getOSC()=0;//<-- create/collect OSC messages that you may want to send to another program or computer
         virtual void update(float seconds=0)= 0; //<-- do the meat of the signal processing / feature extraction here
+        
+        //the ugens whose outputs update() reads -- they have to be updated first. See UGENGraph
+        virtual void getInputs(std::vector<UGEN *> &inputs){};
+        
+        //how many new samples the last update() had to do -- for the profiler
+        virtual int getNewSampleCount(){ return 0; };
+        
+        //what it works out, so UGENGraph can find ugens doing the same work -- the class & whatever changes the output,
+        //but not the inputs or where the OSC goes. "" if it shouldn't be shared
+        virtual std::string getSignature(){ return ""; };
+        
+        //ugens it keeps & updates itself, eg. FindPeaks' derivative. shareOwned(): use an identical one from the graph
+        //instead -- false if it can't
+        virtual void getOwnedUGENs(std::vector<UGEN *> &owned){};
+        virtual bool shareOwned(UGEN *owned, UGEN *shared){ return false; };
     };
     
     class SignalAnalysis : public UGEN
     {
     protected:
-        std::vector<MocapDeviceData *> data1;
-        std::vector<MocapDeviceData *> data2;
+        MocapBufferView data1; //views of the input ugens' buffers, see update()
+        MocapBufferView data2;
         
         SignalAnalysis *ugen, *ugen2  ;
         int buffersize;
@@ -95,16 +149,22 @@ namespace CRCPMotionAnalysis {
             buffersize = sz;
         };
         
-        virtual inline std::vector<MocapDeviceData *> getBuffer(){
+        virtual inline MocapBufferView getBuffer(){
             return data1;
         };
         
-        virtual inline std::vector<MocapDeviceData *> getBuffer2(){
+        virtual inline MocapBufferView getBuffer2(){
             return data2;
         };
         
         int getBufferSize(){return buffersize;};
         
+        virtual void getInputs(std::vector<UGEN *> &inputs)
+        {
+            if( ugen != NULL ) inputs.push_back(ugen);
+            if( ugen2 != NULL ) inputs.push_back(ugen2);
+        };
+        
         virtual void update(float seconds=0)
         { 
             if( ugen != NULL ) data1 = ugen->getBuffer();
@@ -138,7 +198,7 @@ namespace CRCPMotionAnalysis {
 #endif
 
         //finds average in buffer using the MotionCaptureData instead of float vector as before
-        virtual double findAvg(std::vector<MocapDeviceData *> input, int start, int end, int index)
+        virtual double findAvg(const MocapBufferView &input, int start, int end, int index)
         {
             double N = end - start;
             double sum = 0;
@@ -160,6 +220,7 @@ protected:
     bool isPhone;
     bool isWiiMote;
     SensorData *sensor  ;
+    std::vector<MocapDeviceData *> validSamples; //only used if the sensor buffer has dummy data in it
 
 public:
     InputSignal(int idz, bool phone=false, SignalAnalysis *s1 = NULL, int bufsize=48, SignalAnalysis *s2 = NULL) : SignalAnalysis(s1, bufsize, s2)
@@ -189,21 +250,39 @@ public:
     //puts valid mocap data in buffers for other ugens.
     virtual void update(float seconds=0)
     {
-        data1.clear();
+        data1 = MocapBufferView();
         if( sensor != NULL )
         {
-            std::vector<MocapDeviceData *> data = sensor->getBuffer(buffersize);
+            MocapSampleWindow data = sensor->getWindow(buffersize);
+            
+            //usually it is all valid data, so just pass on the sensor's buffer
+            const float *accelX = data.column(MocapDeviceData::DataIndices::ACCELX);
+            bool hasDummyData = false;
+            for(int i =0; i<data.size() && !hasDummyData; i++)
+                hasDummyData = ( accelX[i] == (float) NO_DATA );
+            
+            if( !hasDummyData )
+            {
+                data1 = MocapBufferView(data.samples(), data.size(), sensor->getNewSampleCount());
+                return;
+            }
+            
+            validSamples.clear();
+            int newValid = 0;
+            int firstNew = data.size() - sensor->getNewSampleCount();
             for(int i =0; i<data.size(); i++) //filters out dummy data
             {
                 if( data[i]->getData(MocapDeviceData::DataIndices::ACCELX) != NO_DATA )
                 {
-                    data1.push_back(data[i]);
+                    validSamples.push_back(data[i]);
+                    if( i >= firstNew ) newValid++;
                  }
             }
+            data1 = MocapBufferView(validSamples, newValid);
         }
     };
     
-    virtual std::vector<MocapDeviceData *> getBuffer(){
+    virtual MocapBufferView getBuffer(){
         return data1;
     };
     
@@ -249,8 +328,12 @@ public:
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
 
+#define OUTPUTSIGNAL_STREAMING_HISTORY 48 //how many outputs a streaming ugen keeps -- same as the InputSignal buffer so downstream ugens see as much as before
+
     //has output signals that it modifies  & forwards on to others
     //only handles one stream of data...
+    //streaming ugens only process the new input samples each frame & add the results to a ring of outputs that persists between frames.
+    //otherwise, the outputs are all recomputed from the whole input buffer every frame
     class OutputSignalAnalysis : public SignalAnalysis
     {
     protected:
@@ -258,32 +341,82 @@ public:
         bool _sendOSC;
         int _id;
         std::string whichBodyPart;
+        MocapDeviceDataPool pool; //output samples come from here and go back here in eraseData()
+        
+        bool streaming;
+        MocapRingBuffer outRing; //the outputs when streaming
+        int newOutputCount; //outputs added to outRing this frame
 
         
         void eraseData()
         {
             for( int i=0; i<outdata1.size(); i++ )
-                delete outdata1[i];
+                pool.release(outdata1[i]);
             
             outdata1.clear();
         };
+        
+        //a fresh output sample
+        MocapDeviceData *createSample()
+        {
+            return pool.acquire();
+        };
+        
+        //adds a finished output sample to the output buffer
+        void addOutput(MocapDeviceData *sample)
+        {
+            if( !streaming )
+            {
+                outdata1.push_back(sample);
+                return;
+            }
+            pool.release( outRing.push(sample) ); //the oldest output, once the ring is full
+            newOutputCount++;
+        };
+        
+        //when streaming, how many of the input samples are new and need to be processed
+        int getNewInputCount()
+        {
+            return std::min( data1.getNewSampleCount(), data1.size() );
+        };
     public:
         
-        OutputSignalAnalysis(SignalAnalysis *s1, int bufsize, int sensorID=0, std::string whichPart="", bool sendOSC=false, SignalAnalysis *s2 = NULL) : SignalAnalysis(s1, bufsize, s2)
+        OutputSignalAnalysis(SignalAnalysis *s1, int bufsize, int sensorID=0, std::string whichPart="", bool sendOSC=false, SignalAnalysis *s2 = NULL) : SignalAnalysis(s1, bufsize, s2), pool(64), outRing(OUTPUTSIGNAL_STREAMING_HISTORY, false)
         {
             whichBodyPart = whichPart;
             _id=sensorID;
             _sendOSC = sendOSC;
+            streaming = false;
+            newOutputCount = 0;
         }
         
+        //only subclasses that implement streaming should turn it on -- & only before the first update()
+        void setStreaming(bool s)
+        {
+            streaming = s;
+        };
+        
+        bool isStreaming()
+        {
+            return streaming;
+        };
+        
+        //when streaming, the outputs added this frame -- otherwise, the new samples coming in, as with other ugens
+        inline virtual int getNewSampleCount()
+        {
+            if( streaming ) return newOutputCount;
+            return SignalAnalysis::getNewSampleCount();
+        };
+        
         //puts in accel data slots -- all other data left alone -- ALSO only
-        void toOutputVector( std::vector<float> inputX, std::vector<float> inputY, std::vector<float> inputZ )
+        void toOutputVector( const std::vector<float> &inputX, const std::vector<float> &inputY, const std::vector<float> &inputZ )
         {
             for(int i=0; i<inputX.size(); i++)
             {
-                MocapDeviceData *data = new MocapDeviceData();
+                MocapDeviceData *data = createSample();
                 data->setData(MocapDeviceData::DataIndices::INDEX, data1[i]->getData(MocapDeviceData::DataIndices::INDEX));
                 data->setData(MocapDeviceData::DataIndices::TIME_STAMP, data1[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP));
+                data->setReceiveTime(data1[i]->getReceiveTime());
                 data->setData(MocapDeviceData::DataIndices::ACCELX, inputX[i]);
                 data->setData(MocapDeviceData::DataIndices::ACCELY, inputY[i]);
                 data->setData(MocapDeviceData::DataIndices::ACCELZ, inputZ[i]);
@@ -293,12 +426,29 @@ public:
         
         virtual void update(float seconds = 0){
             eraseData();
+            newOutputCount = 0;
             SignalAnalysis::update(seconds);
         };
         
         //just give it your data
-        virtual std::vector<MocapDeviceData *> getBuffer(){
-            return outdata1;
+        virtual MocapBufferView getBuffer(){
+            if( streaming )
+            {
+                MocapSampleWindow window = outRing.window(OUTPUTSIGNAL_STREAMING_HISTORY);
+                return MocapBufferView(window.samples(), window.size(), newOutputCount);
+            }
+            return MocapBufferView(outdata1, getNewSampleCount());
+        };
+        
+        //the outputs that go out as OSC -- when streaming, only the ones added this frame, otherwise the whole buffer, as always
+        MocapBufferView getOutputsToSend()
+        {
+            if( streaming )
+            {
+                MocapSampleWindow window = outRing.window(newOutputCount);
+                return MocapBufferView(window.samples(), window.size(), newOutputCount);
+            }
+            return MocapBufferView(outdata1, getNewSampleCount());
         };
     
     };
@@ -309,23 +459,124 @@ public:
     {
     protected:
         int windowSize;
+        
+        //streaming mode state -- the last windowSize+1 inputs of each channel & their running sums
+        //(same window as the whole-buffer version: the current sample + the windowSize before it)
+        std::vector<int> channels; //which data indices are averaged
+        std::vector<double> history; //historyLength rows of channels.size() values, circular
+        int historyLength;
+        int historyHead; //the row the next input goes in
+        int historyCount;
+        std::vector<double> runningSums;
+        std::vector<int> validCounts; //NO_DATA values are not in the sums or the counts
+        
+        void initStreaming()
+        {
+            channels.clear();
+            for(int j=MocapDeviceData::DataIndices::ACCELX; j<=MocapDeviceData::DataIndices::ACCELZ; j++)
+                channels.push_back(j);
+            for(int j=MocapDeviceData::DataIndices::BONEANGLE_TILT; j<=MocapDeviceData::DataIndices::BONEANGLE_LATERAL; j++)
+                channels.push_back(j);
+            for(int j=MocapDeviceData::DataIndices::RELATIVE_TILT; j<=MocapDeviceData::DataIndices::RELATIVE_LATERAL; j++)
+                channels.push_back(j);
+            
+            historyLength = windowSize + 1;
+            history.assign(historyLength * channels.size(), NO_DATA);
+            historyHead = 0;
+            historyCount = 0;
+            runningSums.assign(channels.size(), 0);
+            validCounts.assign(channels.size(), 0);
+        };
+        
+        //recomputes the sums from the history so that floating point error from adding & subtracting doesn't build up
+        void resumHistory()
+        {
+            for(int c=0; c<channels.size(); c++)
+            {
+                runningSums[c] = 0;
+                validCounts[c] = 0;
+                for(int row=0; row<historyCount; row++)
+                {
+                    double v = history[row*channels.size() + c];
+                    if( v != NO_DATA )
+                    {
+                        runningSums[c] += v;
+                        validCounts[c]++;
+                    }
+                }
+            }
+        };
+        
+        //adds one input sample to the running sums & outputs its average -- O(1) in the window size
+        void streamSample(MocapDeviceData *input)
+        {
+            MocapDeviceData *mdd= createSample();
+            mdd->setData(MocapDeviceData::DataIndices::INDEX, input->getData(MocapDeviceData::DataIndices::INDEX));
+            mdd->setData(MocapDeviceData::DataIndices::TIME_STAMP, input->getData(MocapDeviceData::DataIndices::TIME_STAMP));
+            mdd->setReceiveTime(input->getReceiveTime());
+            
+            double *row = &history[historyHead*channels.size()];
+            for(int c=0; c<channels.size(); c++)
+            {
+                if( historyCount == historyLength && row[c] != NO_DATA ) //drop the oldest value from the window
+                {
+                    runningSums[c] -= row[c];
+                    validCounts[c]--;
+                }
+                
+                row[c] = input->getData(channels[c]);
+                if( row[c] != NO_DATA )
+                {
+                    runningSums[c] += row[c];
+                    validCounts[c]++;
+                }
+            }
+            
+            if( historyCount < historyLength ) historyCount++;
+            historyHead = (historyHead + 1) % historyLength;
+            if( historyHead == 0 ) resumHistory();
+            
+            for(int c=0; c<channels.size(); c++)
+            {
+                bool isAccel = channels[c] >= MocapDeviceData::DataIndices::ACCELX && channels[c] <= MocapDeviceData::DataIndices::ACCELZ;
+                if( isAccel && !useAccel ) continue;
+                
+                if( validCounts[c] == 0 ) mdd->setData(channels[c], NO_DATA);
+                else mdd->setData(channels[c], runningSums[c] / double( validCounts[c] ));
+            }
+            
+            addOutput(mdd);
+        };
+        
     public:
         
+        //streams by default -- setStreaming(false) to recompute the averages of the whole buffer every frame, as before
         AveragingFilter(SignalAnalysis *s1, int w=10, int bufsize=16, int sensorID=0, std::string whichPart="", bool sendOSC=false ) : OutputSignalAnalysis(s1, bufsize, sensorID, whichPart, sendOSC)
         {
             windowSize = w;
+            initStreaming();
+            setStreaming(true);
+        };
+        
+        //streaming, the outputs don't depend on the buffer size -- they're kept in the ring
+        virtual std::string getSignature()
+        {
+            std::stringstream sig;
+            sig << "AveragingFilter " << windowSize << " " << useAccel;
+            if( !streaming ) sig << " buffer " << buffersize;
+            return sig.str();
         };
         
         //I'm gonna be shot for yet another avg function
-        float mocapDeviceAvg(std::vector<MocapDeviceData *> data, int start, int end, int index )
+        float mocapDeviceAvg(const MocapBufferView &data, int start, int end, int index )
         {
             double sum = 0;
             int valCount = 0;
             for( int j=start; j<=end; j++ )
             {
-                if(data1[j]->getData(index) != NO_DATA)
+                if(data[j]->getData(index) != NO_DATA)
                 {
-                    sum += data1[j]->getData(index);
+                    sum += data[j]->getData(index);
                     valCount++;
                 }
             }
@@ -337,15 +588,24 @@ public:
         virtual void update(float seconds=0)
         {
             OutputSignalAnalysis::update(seconds);
+            
+            if( streaming )
+            {
+                for( int i=data1.size()-getNewInputCount(); i<data1.size(); i++ )
+                    streamSample(data1[i]);
+                return;
+            }
+            
             if( data1.size() < buffersize) return ;
             
             for( int i=0; i<data1.size(); i++ )
             {
                 int start = std::max(0, i-windowSize);
                 int end = i;
-                MocapDeviceData *mdd= new MocapDeviceData();
+                MocapDeviceData *mdd= createSample();
                 mdd->setData(MocapDeviceData::DataIndices::INDEX, data1[i]->getData(MocapDeviceData::DataIndices::INDEX));
                 mdd->setData(MocapDeviceData::DataIndices::TIME_STAMP, data1[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP));
+                mdd->setReceiveTime(data1[i]->getReceiveTime());
                 
                 if( useAccel )
                 {
@@ -394,7 +654,8 @@ public:
             
             if(_sendOSC)
             {
-                for( int i=0; i<outdata1.size(); i++ )
+                MocapBufferView outputs = getOutputsToSend();
+                for( int i=0; i<outputs.size(); i++ )
                 {
                     
                     ci::osc::Message msg;
@@ -406,10 +667,10 @@ public:
                     
 //                    std::cout << whichBodyPart << ",";
                     
-                    msg.append(double(outdata1[i]->getData(MocapDeviceData::DataIndices::INDEX)));
+                    msg.append(double(outputs[i]->getData(MocapDeviceData::DataIndices::INDEX)));
 //                    std::cout << msg.getArgDouble(1) << ",";
                     
-                    msg.append(float(outdata1[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP)));
+                    msg.append(float(outputs[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP)));
 //                    std::cout << msg.getArgFloat(2) << ",";
                     
                     
@@ -418,7 +679,7 @@ public:
                         int h = 3;
                         for(int j= MocapDeviceData::DataIndices::ACCELX; j<=MocapDeviceData::DataIndices::ACCELZ; j++)
                         {
-                            msg.append(float(outdata1[i]->getData(j)));
+                            msg.append(float(outputs[i]->getData(j)));
 //                            std::cout << msg.getArgFloat(h) << ",";
                             h++;
                             
@@ -428,7 +689,7 @@ public:
                     //derivative of bone angles
                     for(int j= MocapDeviceData::DataIndices::BONEANGLE_TILT; j<=MocapDeviceData::DataIndices::BONEANGLE_LATERAL; j++)
                     {
-                        msg.append(float(outdata1[i]->getData(j)));
+                        msg.append(float(outputs[i]->getData(j)));
 //                        std::cout << outdata1[i]->getData(j) << ",";
                         
                     }
@@ -436,7 +697,7 @@ public:
                     //derivative of bone angles
                     for(int j= MocapDeviceData::DataIndices::RELATIVE_TILT; j<=MocapDeviceData::DataIndices::RELATIVE_LATERAL; j++)
                     {
-                        msg.append(float(outdata1[i]->getData(j)));
+                        msg.append(float(outputs[i]->getData(j)));
 //                        std::cout << outdata1[i]->getData(j) << ",";
                         
                     }
@@ -455,27 +716,100 @@ public:
     //finds the derivative of the data
     class Derivative : public OutputSignalAnalysis
     {
+    protected:
+        //streaming mode state -- the values of the last input sample, kept from frame to frame
+        //these are copied, not pointed to, since the input sample may be changed or recycled by the time the next one comes in
+        double previous[DEVICE_ARG_COUNT_MAX+1];
+        bool hasPrevious;
+        
+        void keepAsPrevious(MocapDeviceData *input)
+        {
+            for(int j= MocapDeviceData::DataIndices::ACCELX; j<=MocapDeviceData::DataIndices::ACCELZ; j++)
+                previous[j] = input->getData(j);
+            for(int j= MocapDeviceData::DataIndices::BONEANGLE_TILT; j<=MocapDeviceData::DataIndices::BONEANGLE_LATERAL; j++)
+                previous[j] = input->getData(j);
+            for(int j= MocapDeviceData::DataIndices::RELATIVE_TILT; j<=MocapDeviceData::DataIndices::RELATIVE_LATERAL; j++)
+                previous[j] = input->getData(j);
+            hasPrevious = true;
+        };
+        
+        //one output for one new input -- same differences as the whole-buffer version below
+        void streamSample(MocapDeviceData *input)
+        {
+            if( !hasPrevious )
+            {
+                keepAsPrevious(input);
+                return;
+            }
+            
+            MocapDeviceData *mdd= createSample();
+            mdd->setData(MocapDeviceData::DataIndices::INDEX, input->getData(MocapDeviceData::DataIndices::INDEX));
+            mdd->setData(MocapDeviceData::DataIndices::TIME_STAMP, input->getData(MocapDeviceData::DataIndices::TIME_STAMP));
+            mdd->setReceiveTime(input->getReceiveTime());
+            
+            if( useAccel )
+            {
+                for(int j= MocapDeviceData::DataIndices::ACCELX; j<=MocapDeviceData::DataIndices::ACCELZ; j++)
+                    mdd->setData(j, input->getData(j)-previous[j]);
+            }
+            
+            for(int j= MocapDeviceData::DataIndices::BONEANGLE_TILT; j<=MocapDeviceData::DataIndices::BONEANGLE_LATERAL; j++)
+            {
+                if(input->getData(j)!=NO_DATA)
+                    mdd->setData(j, input->getData(j)-previous[j]);
+            }
+            
+            for(int j= MocapDeviceData::DataIndices::RELATIVE_TILT; j<=MocapDeviceData::DataIndices::RELATIVE_LATERAL; j++)
+            {
+                if(input->getData(j)!=NO_DATA)
+                    mdd->setData(j, input->getData(j)-previous[j]);
+            }
+            
+            keepAsPrevious(input);
+            addOutput(mdd);
+        };
+        
     public:
 
+        //streams by default -- setStreaming(false) to re-differentiate the whole buffer every frame, as before
         Derivative(SignalAnalysis *s1, int bufsize, int sensorID=0, std::string whichPart="", bool sendOSC=false) : OutputSignalAnalysis(s1, bufsize, sensorID, whichPart, sendOSC)
         {
 //            _sendOSC = sendOSC;
             useAccel = true;
 //            _id = sensorID;
 //            whichBodyPart = whichPart;
+            hasPrevious = false;
+            setStreaming(true);
+        };
+        
+        virtual std::string getSignature()
+        {
+            std::stringstream sig;
+            sig << "Derivative " << useAccel;
+            if( !streaming ) sig << " buffer " << buffersize;
+            return sig.str();
         };
         
         //perform the derivative here...
         virtual void update(float seconds=0)
         {
             OutputSignalAnalysis::update(seconds);
+            
+            if( streaming )
+            {
+                for( int i=data1.size()-getNewInputCount(); i<data1.size(); i++ )
+                    streamSample(data1[i]);
+                return;
+            }
+            
             if( data1.size() < buffersize) return ;
             
             for( int i=1; i<data1.size(); i++ )
             {
-                MocapDeviceData *mdd= new MocapDeviceData();
+                MocapDeviceData *mdd= createSample();
                 mdd->setData(MocapDeviceData::DataIndices::INDEX, data1[i]->getData(MocapDeviceData::DataIndices::INDEX));
                 mdd->setData(MocapDeviceData::DataIndices::TIME_STAMP, data1[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP));
+                mdd->setReceiveTime(data1[i]->getReceiveTime());
                 
                 if( useAccel )
                 {
@@ -522,7 +856,8 @@ public:
             
             if(_sendOSC)
             {
-                for( int i=0; i<outdata1.size(); i++ )
+                MocapBufferView outputs = getOutputsToSend();
+                for( int i=0; i<outputs.size(); i++ )
                 {
                     
                     ci::osc::Message msg;
@@ -534,10 +869,10 @@ public:
                     
 //                    std::cout << whichBodyPart << ",";
                 
-                    msg.append(double(outdata1[i]->getData(MocapDeviceData::DataIndices::INDEX)));
+                    msg.append(double(outputs[i]->getData(MocapDeviceData::DataIndices::INDEX)));
 //                    std::cout << msg.getArgDouble(1) << ",";
                     
-                    msg.append(float(outdata1[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP)));
+                    msg.append(float(outputs[i]->getData(MocapDeviceData::DataIndices::TIME_STAMP)));
 //                    std::cout << msg.getArgFloat(2) << ",";
 
                 
@@ -546,7 +881,7 @@ public:
                         int h = 3;
                         for(int j= MocapDeviceData::DataIndices::ACCELX; j<=MocapDeviceData::DataIndices::ACCELZ; j++)
                         {
-                            msg.append(float(outdata1[i]->getData(j)));
+                            msg.append(float(outputs[i]->getData(j)));
 //                            std::cout << msg.getArgFloat(h) << ",";
                             h++;
 
@@ -556,7 +891,7 @@ public:
                     //derivative of bone positions
                     for(int j= MocapDeviceData::DataIndices::BONEANGLE_TILT; j<=MocapDeviceData::DataIndices::BONEANGLE_LATERAL; j++)
                     {
-                        msg.append(float(outdata1[i]->getData(j)));
+                        msg.append(float(outputs[i]->getData(j)));
 //                        std::cout << outdata1[i]->getData(j) << ",";
 
                     }
@@ -564,7 +899,7 @@ public:
                     //relative angle to parent bone
                     for(int j= MocapDeviceData::DataIndices::RELATIVE_TILT; j<=MocapDeviceData::DataIndices::RELATIVE_LATERAL; j++)
                     {
-                        msg.append(float(outdata1[i]->getData(j)));
+                        msg.append(float(outputs[i]->getData(j)));
                         //                        std::cout << outdata1[i]->getData(j) << ",";
                         
                     }
@@ -586,7 +921,7 @@ public:
     protected :
        int  maxDraw; //how far back in history to draw
         
-        std::vector<ci::vec2> points;
+        std::vector<ci::vec2> points; //accel x & y, 0..1 -- made into screen positions in draw(), so update() works w/o a window
         std::vector<float>  alpha;
     public:
         MocapDataVisualizer(OutputSignalAnalysis *s1 = NULL, int _maxDraw=25,int bufsize=48, SignalAnalysis *s2 = NULL) : SignalAnalysis(s1, bufsize, s2)
@@ -594,40 +929,47 @@ public:
             maxDraw = _maxDraw;
         };
         
-        //add data as screen positions and color alphas.
+        //add data as points to draw and color alphas.
         virtual void update(float seconds = 0)
         {
-            std::vector<MocapDeviceData *> buffer = ugen->getBuffer();
+            MocapBufferView buffer = ugen->getBuffer();
             if(buffer.size()<maxDraw) return; //ah well I don't want to handle smaller buffer sizes for this function. feel free to implement that.
             
             points.clear();
             alpha.clear();
             for(int i=buffer.size()-maxDraw; i<buffer.size(); i++)
             {
-                MocapDeviceData *sample = buffer[i];
-                sample->scaleAccel(); //0..1
+                MocapDeviceData *sample = buffer[i]; //the other ugens read these too, so scale the copies, not the samples
                 
 //                std::cout << sample->toString() << std::endl;
                 
-                //ok now to screens
-                points.push_back(ci::vec2((sample->getData(MocapDeviceData::DataIndices::ACCELX)*ci::app::getWindowWidth()/2.0) + ci::app::getWindowWidth()/4.0, sample->getData(MocapDeviceData::DataIndices::ACCELY)*ci::app::getWindowHeight()));
-                alpha.push_back(sample->getData(MocapDeviceData::DataIndices::ACCELZ));
+                points.push_back(ci::vec2(sample->getScaledData(MocapDeviceData::DataIndices::ACCELX), sample->getScaledData(MocapDeviceData::DataIndices::ACCELY))); //0..1
+                alpha.push_back(sample->getScaledData(MocapDeviceData::DataIndices::ACCELZ));
             }
         };
         
+#ifndef MOTIONANALYSIS_HEADLESS
+        //ok now to screens
+        virtual ci::vec2 toScreen(ci::vec2 pt)
+        {
+            return ci::vec2((pt.x*ci::app::getWindowWidth()/2.0) + ci::app::getWindowWidth()/4.0, pt.y*ci::app::getWindowHeight());
+        };
+#endif
+        
         //visualize the data
         virtual void draw()
         {
+#ifndef MOTIONANALYSIS_HEADLESS
             float circleSize = 2;
             for(int i=1; i<points.size(); i++)
             {
                 ci::gl::color(1.0f, 1.0f/alpha[i], alpha[i], 1.0f); //alpha is no longer alpha hmm
 
-                ci::gl::drawLine(points[i-1], points[i]);
-                ci::gl::drawSolidCircle(points[i], circleSize);
+                ci::gl::drawLine(toScreen(points[i-1]), toScreen(points[i]));
+                ci::gl::drawSolidCircle(toScreen(points[i]), circleSize);
                 
             }
-            
+#endif
 
         };
         
@@ -650,30 +992,37 @@ public:
         
     }
     
-    //add data as screen positions and color alphas instead of drawing accel, will draw BONEANGLE_TILT=14, BONEANGLE_ROTATE=15, BONEANGLE_LATERAL=16
+    //add data as points to draw and color alphas instead of drawing accel, will draw BONEANGLE_TILT=14, BONEANGLE_ROTATE=15, BONEANGLE_LATERAL=16
     //not the best visualization -- you are welcome to change  & make 3d -- but I think  the visualizer on the phone should generally give you an idea
     //of what is happening.
     virtual void update(float seconds = 0)
     {
-        std::vector<MocapDeviceData *> buffer = ugen->getBuffer();
+        MocapBufferView buffer = ugen->getBuffer();
         if(buffer.size()<maxDraw) return; //ah well I don't want to handle smaller buffer sizes for this function. feel free to implement that.
         
         points.clear();
         alpha.clear();
         for(int i=buffer.size()-maxDraw; i<buffer.size(); i++)
         {
-            MocapDeviceData *sample = buffer[i];
-            sample->scaleAccel(); //0..1  to 0 to
+            MocapDeviceData *sample = buffer[i]; //scaled copies, as above
             
 //           std::cout << sample->toString() << std::endl;
             
             //ok now to screens
 //            points.push_back(ci::vec2((sample->getData(MocapDeviceData::DataIndices::BONEANGLE_TILT)*ci::app::getWindowWidth()/2)+ci::app::getWindowWidth()/2, (sample->getData(MocapDeviceData::DataIndices::BONEANGLE_ROTATE)*ci::app::getWindowHeight())+ci::app::getWindowHeight()/2));
-            points.push_back(ci::vec2((sample->getData(MocapDeviceData::DataIndices::BONEANGLE_TILT)*ci::app::getWindowWidth()/2)+ci::app::getWindowWidth()/4, (sample->getData(MocapDeviceData::DataIndices::BONEANGLE_ROTATE)*ci::app::getWindowHeight())+ci::app::getWindowHeight()/2));
+            points.push_back(ci::vec2(sample->getScaledData(MocapDeviceData::DataIndices::BONEANGLE_TILT), sample->getScaledData(MocapDeviceData::DataIndices::BONEANGLE_ROTATE))); //0..1  to 0 to
             alpha.push_back(1.0f - sample->getData(MocapDeviceData::DataIndices::BONEANGLE_LATERAL));  //color it differently than the accel values
         }
     };
     
+#ifndef MOTIONANALYSIS_HEADLESS
+    //ok now to screens
+    virtual ci::vec2 toScreen(ci::vec2 pt)
+    {
+        return ci::vec2((pt.x*ci::app::getWindowWidth()/2)+ci::app::getWindowWidth()/4, (pt.y*ci::app::getWindowHeight())+ci::app::getWindowHeight()/2);
+    };
+#endif
+    
     //IDEA -- ratio between limbs? try wekinator, gtk -- closed/open, up/down -- can implement all these measures -- also in ITM -- verticality
     
 };
@@ -745,7 +1094,7 @@ public:
             if(ugen==NULL) return;
 //            std::cout << "Bone " << _name << " is updating." << "Parent is: "<< getParentName() <<" and parent name: " << _parent->getName() << "and anchor pos: " << getAnchorPos() << "\n ";
 
-            std::vector<MocapDeviceData *> buffer = ugen->getBuffer();
+            MocapBufferView buffer = ugen->getBuffer();
             if(buffer.size()<=0) return;
             
             points.clear();
@@ -824,6 +1173,7 @@ public:
             return _origAnchorPos;
         }
         
+#ifndef MOTIONANALYSIS_HEADLESS //the window & the modelview -- only for drawing
         ci::vec3 xform2DPointUsingCurModelView(ci::vec3 pt)
         {
             ci::mat4 modelView = ci::gl::getModelView();
@@ -960,9 +1310,11 @@ public:
             }
             return whereAmI;
         }
+#endif
         
         virtual void drawAnchorPoints()
         {
+#ifndef MOTIONANALYSIS_HEADLESS
 //            if(_name.compare("LeftForeArm") && _name.compare("RightForeArm"))
 //                return;
             //draw the anchor point tho.
@@ -986,10 +1338,12 @@ public:
             ci::gl::drawSphere(endpt2, 0.1f);
             
             ci::gl::color(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
         }
         
         virtual void draw(float seconds = 0)
         {
+#ifndef MOTIONANALYSIS_HEADLESS
             if(!_parent) return;
             
             ci::gl::pushModelMatrix();
@@ -1009,7 +1363,7 @@ public:
             endpt2 = ci::vec3(0, scaleOneVal(-_boneLength.y, Axis::Y), 0);
             ci::gl::drawLine(endpt1, endpt2);
             ci::gl::popModelMatrix();
-        
+#endif
         }
 
     };
@@ -1065,103 +1419,35 @@ public:
             return a;
         }
         
-        virtual ci::vec3 translationsAndRotations3d()
-        {
-            ci::vec3 parentAnchor, curAnchor, whereAmI(0,0,0);
-            if(_parent != NULL){
-                whereAmI = _parent->translationsAndRotations3d();
-                curAnchor.x = _parent->getStartAnchorPos().x - whereAmI.x;
-//                curAnchor.y = _parent->getStartAnchorPos().y - whereAmI.y;
-
-                
-                if(((MocapDataVisualizerNotchFigure3DBone *)_parent)->isDrawnDown())
-                {
-                    curAnchor.y = whereAmI.y-_parent->getStartAnchorPos().y ;
-                }
-                else
-                {
-                    curAnchor.y = _parent->getStartAnchorPos().y - whereAmI.y;
-                }
-
-                whereAmI.x+=curAnchor.x;
-                if(((MocapDataVisualizerNotchFigure3DBone *)_parent)->isDrawnDown())
-                {
-                    whereAmI.y-=curAnchor.y;
-                }
-                else
-                {
-                    whereAmI.y+=curAnchor.y;
-                }
-                
-
-                ci::vec3 translateVector = ci::vec3(curAnchor.x, curAnchor.y, 0);
-                ci::gl::translate(translateVector);
-//                std::cout << getName() << "-- translate: " << translateVector << "   curAnchor: " << curAnchor << std::endl;
-                
-                //this new rotate
-                ci::gl::rotate (radians(lastAngle, Axis::X), ci::vec3(1.0f, 0.0f, 0.0f));
-                ci::gl::rotate (radians(lastAngle, Axis::Y), ci::vec3(0.0f, 1.0f, 0.0f));
-                ci::gl::rotate (radians(lastAngle, Axis::Z) , ci::vec3(0.0f, 0.0f, 1.0f));
-            }
-            return whereAmI;
-        }
-        
-        ci::vec3 xform3DPtUsingCurTransformationMatrix(ci::vec3 pt)
+        //where the bone is now, from the figure's joint table -- see NotchBoneFigure::update()
+        void setJointPositions(const ci::vec3 &anchorPos, const ci::vec3 &endPoint)
         {
-            ci::mat4 model = ci::gl::getModelMatrix();
-            ci::vec4 input(pt.x, pt.y, pt.z, 1.0f);
-            ci::vec4 output = model * input;
-            return ci::vec3(output[0], output[1], output[2]);
+            _curAnchorPos = anchorPos;
+            _curEndPoint = endPoint;
         }
         
         virtual void drawAnchorPoints()
         {
-            
+#ifndef MOTIONANALYSIS_HEADLESS
             ci::gl::color(0.0f, 1.0f, 1.0f, 1.0f);
             ci::gl::drawSphere(_curAnchorPos, 0.1f);
             if(!_parent) return;
             
             ci::gl::color(1.0f, 0.0f, 1.0f, 1.0f);
             ci::gl::drawSphere(_curEndPoint, 0.1f);
-        }
-        
-        virtual void doAnchorPosCalcs()
-        {
-            _curAnchorPos = xform3DPtUsingCurTransformationMatrix(ci::vec3(0, 0, 0));
-            
-            ci::gl::pushModelMatrix();
-            
-            if(mDrawBoneDown)
-                ci::gl::translate(ci::vec3(0, _boneLength.y, 0));
-            else
-                ci::gl::translate(ci::vec3(0, -_boneLength.y, 0));
-            
-            _curEndPoint = xform3DPtUsingCurTransformationMatrix(ci::vec3(0, 0, 0));
-            
-            ci::gl::popModelMatrix();
+#endif
         }
         
         virtual void draw(float seconds = 0)
         {
+#ifndef MOTIONANALYSIS_HEADLESS
             if(!_parent) return;
             
-            ci::vec3 endpt1, endpt2;
-            endpt1 = ci::vec3(0, 0, 0);
-            
-            if(mDrawBoneDown)
-                endpt2 = ci::vec3(0, _boneLength.y, 0);
-            else endpt2 = ci::vec3(0, -_boneLength.y, 0);
-
             ci::gl::color(myColor);
-            
-            ci::gl::pushModelMatrix();
-            ci::gl::rotate(M_PI, ci::vec3(1.0, 0.0, 0.0));
-            translationsAndRotations3d();
-            doAnchorPosCalcs();
-            ci::gl::drawLine(endpt1, endpt2);
-            ci::gl::popModelMatrix();
+            ci::gl::drawLine(_curAnchorPos, _curEndPoint);
             
             drawAnchorPoints();
+#endif
         }
     };
     
@@ -1258,6 +1544,35 @@ public:
     protected:
         BoneFactory factory;
         std::vector<MocapDataVisualizerNotchFigure3DBone *> bones;
+        ForwardKinematicsSolver skeleton; //same indices as bones -- where the joints are, for drawing & the figure measures
+        
+        //the bones as a skeleton. Each bone hangs off where its parent starts, as it did when this was done on the GL matrix
+        //stack -- the root only places the figure & the figure is upside down (flipped around x)
+        void buildSkeleton()
+        {
+            for(int i=0; i<bones.size(); i++)
+            {
+                int parent = factory.getBoneIndex(bones[i]->getParentName());
+                ci::vec3 boneEnd(0, bones[i]->isDrawnDown() ? bones[i]->getBoneLength().y : -bones[i]->getBoneLength().y, 0);
+                
+                if(parent < 0)
+                {
+                    skeleton.addJoint(bones[i]->getName(), -1, bones[i]->getStartAnchorPos(), ci::vec3(0, 0, 0), false);
+                    continue;
+                }
+                
+                //from the grandparent's start to the parent's -- up or down depending on which way the parent is drawn
+                MocapDataVisualizerNotchFigure3DBone *p = bones[parent];
+                int grandparent = factory.getBoneIndex(p->getParentName());
+                ci::vec3 from = grandparent < 0 ? ci::vec3(0, 0, 0) : bones[grandparent]->getStartAnchorPos();
+                ci::vec3 offset(p->getStartAnchorPos().x - from.x, p->getStartAnchorPos().y - from.y, 0);
+                if(p->isDrawnDown()) offset.y = -offset.y;
+                if(grandparent < 0) offset = offset - p->getStartAnchorPos(); //the root joint is already there
+                
+                skeleton.addJoint(bones[i]->getName(), parent, offset, boneEnd);
+            }
+            skeleton.setBase(RigidTransform::rotation(M_PI, Axis::X));
+        };
         
         void setParents()
         {
@@ -1279,6 +1594,13 @@ public:
                 bones.push_back(factory.createBone(factory.getName(i)));
             }
             setParents();
+            buildSkeleton();
+        };
+        
+        virtual ~NotchBoneFigure()
+        {
+            for(int i=0; i<bones.size(); i++)
+                delete bones[i];
         };
         
         MocapDataVisualizerNotchFigure3DBone *getBone(std::string name_)
@@ -1320,11 +1642,54 @@ public:
 
         }
         
+        ForwardKinematicsSolver &getSkeleton()
+        {
+            return skeleton;
+        }
+        
+        //the joint table, as of the last update()
+        ci::vec3 getAnchorPos(int index)
+        {
+            return skeleton.getAnchorPos(index);
+        }
+        
+        ci::vec3 getAnchorPos(std::string name_)
+        {
+            return skeleton.getAnchorPos(getBoneID(name_));
+        }
+        
+        ci::vec3 getEndPoint(int index)
+        {
+            return skeleton.getEndPoint(index);
+        }
+        
+        ci::vec3 getEndPoint(std::string name_)
+        {
+            return skeleton.getEndPoint(getBoneID(name_));
+        }
+        
+        //every bone's signal -- the figure needs all of them
+        virtual void getInputs(std::vector<UGEN *> &inputs)
+        {
+            for(int i=0; i<bones.size(); i++)
+            {
+                bones[i]->getInputs(inputs);
+            }
+        }
+        
+        //gets the latest angles, then where all the joints are now
         virtual void update(float seconds = 0)
         {
             for(int i=0; i<bones.size(); i++)
             {
                 bones[i]->update();
+                skeleton.setAngles(i, bones[i]->getRelativeAngle());
+            }
+            
+            skeleton.solve();
+            for(int i=0; i<bones.size(); i++)
+            {
+                bones[i]->setJointPositions(skeleton.getAnchorPos(i), skeleton.getEndPoint(i));
             }
         };
         
@@ -1362,6 +1727,11 @@ public:
             figure = figure_;
         }
         
+        virtual void getInputs(std::vector<UGEN *> &inputs)
+        {
+            inputs.push_back(figure);
+        }
+        
         virtual void draw()
         {
             
@@ -1401,7 +1771,7 @@ public:
             //create a cylinder using furthest points up/down & left/right
         
             //lowest point is the root, so hip anchor pos
-            ci::vec3 p1 = figure->getBone("Root")->getAnchorPos();
+            ci::vec3 p1 = figure->getAnchorPos("Root");
             
             //find highest point (Y value)
             ci::vec3 p2 = findHighestPoint();
@@ -1465,24 +1835,26 @@ public:
         
 //        float getSummedDistanceFromRoot()
 //        {
-//            ci::vec3 root = figure->getBone(0)->getCurEndPoint(); //root bone
+//            ci::vec3 root = figure->getEndPoint(0); //root bone
 //            float sum = 0;
 //
 //            for(int i=1; i<figure->getBoneCount(); i++)
 //            {
-//                sum += ci::distance(root, figure->getBone(i)->getCurEndPoint());
+//                sum += ci::distance(root, figure->getEndPoint(i));
 //            }
 //            return sum;
 //        }
         
         virtual void draw()
         {
+#ifndef MOTIONANALYSIS_HEADLESS
             ci::gl::color(1.0f, 1.0f, 1.0f, 1.0f );
 
             drawCylinder(mRadius, mHeight);
+#endif
         }
         
-        
+#ifndef MOTIONANALYSIS_HEADLESS
         virtual void drawCylinder(float radius, float height)
         {
             auto lambert = ci::gl::ShaderDef().lambert().color();
@@ -1495,16 +1867,17 @@ public:
             cylinder->draw();
             ci::gl::popModelMatrix();
         }
+#endif
         
         ci::vec3 findHighestPoint()
         {
             
-            ci::vec3 pt = figure->getBone(0)->getCurEndPoint();
+            ci::vec3 pt = figure->getEndPoint(0);
 
             for(int i=1; i<figure->getBoneCount(); i++)
             {
-                if(pt.y < figure->getBone(i)->getCurEndPoint().y)
-                    pt = figure->getBone(i)->getCurEndPoint();
+                if(pt.y < figure->getEndPoint(i).y)
+                    pt = figure->getEndPoint(i);
             }
             
             return pt;
@@ -1515,14 +1888,14 @@ public:
             //NOTE: I know that Root is the 1st bone, so I'm skipping
             //Also, this will be the point that is furthest away in the x-axis -- may add z later?
             
-            ci::vec3 startingPoint3d = figure->getBone("Hip")->getAnchorPos();
+            ci::vec3 startingPoint3d = figure->getAnchorPos("Hip");
             ci::vec2 startingPt(startingPoint3d.x, startingPoint3d.z);
             
-            ci::vec3 pt = figure->getBone(1)->getCurEndPoint();
+            ci::vec3 pt = figure->getEndPoint(1);
             
             for(int i=2; i<figure->getBoneCount(); i++)
             {
-                ci::vec3 endingPoint3 = figure->getBone(i)->getCurEndPoint();
+                ci::vec3 endingPoint3 = figure->getEndPoint(i);
                 ci::vec2 endingPt(endingPoint3.x, endingPoint3.z);
                 ci::vec2 pt2(pt.x, pt.z);
                 
@@ -1542,11 +1915,11 @@ public:
             //Also, this will be the point that is furthest away in the x-axis -- may add z later?
             
             
-            ci::vec3 pt = figure->getBone(1)->getCurEndPoint();
+            ci::vec3 pt = figure->getEndPoint(1);
             
             for(int i=2; i<figure->getBoneCount(); i++)
             {
-                ci::vec3 endingPoint = figure->getBone(i)->getCurEndPoint();
+                ci::vec3 endingPoint = figure->getEndPoint(i);
                 
                 if(std::abs(endingPoint.x-farestPt.x) >  std::abs(pt.x-farestPt.x))
                     pt = endingPoint;
@@ -1561,11 +1934,11 @@ public:
             //Also, this will be the point that is furthest away in the x-axis -- may add z later?
             
             
-            ci::vec3 pt = figure->getBone(1)->getCurEndPoint();
+            ci::vec3 pt = figure->getEndPoint(1);
             
             for(int i=2; i<figure->getBoneCount(); i++)
             {
-                ci::vec3 endingPoint = figure->getBone(i)->getCurEndPoint();
+                ci::vec3 endingPoint = figure->getEndPoint(i);
                 
                 if(std::abs(endingPoint.z-farestPt.z) >  std::abs(pt.z-farestPt.z))
                     pt = endingPoint;
@@ -1576,18 +1949,15 @@ public:
         
         float getDistance(std::string boneName1, std::string boneName2, bool useEnd=true, bool useEnd2=true)
         {
-            MocapDataVisualizerNotchFigure3DBone *bone1 = figure->getBone(boneName1);
-            MocapDataVisualizerNotchFigure3DBone *bone2 = figure->getBone(boneName2);
-            
             ci::vec3 pt1, pt2;
             
             if(useEnd)
-                pt1 =  bone1->getCurEndPoint();
-            else pt1 = bone1->getAnchorPos();
+                pt1 =  figure->getEndPoint(boneName1);
+            else pt1 = figure->getAnchorPos(boneName1);
             
             if(useEnd2)
-                pt2 =  bone2->getCurEndPoint();
-            else pt2 = bone2->getAnchorPos();
+                pt2 =  figure->getEndPoint(boneName2);
+            else pt2 = figure->getAnchorPos(boneName2);
             
             return ci::distance(pt1, pt2);
         }
@@ -1644,9 +2014,9 @@ public:
         
         float armDistanceFromHipinY(std::string whichArm)
         {
-            ci::vec3 pt = figure->getBone("Hip")->getAnchorPos();
-            ci::vec3 pt2 =  figure->getBone(whichArm+"UpperArm")->getAnchorPos();
-            ci::vec3 pt3 =  figure->getBone(whichArm+"ForeArm")->getAnchorPos();
+            ci::vec3 pt = figure->getAnchorPos("Hip");
+            ci::vec3 pt2 =  figure->getAnchorPos(whichArm+"UpperArm");
+            ci::vec3 pt3 =  figure->getAnchorPos(whichArm+"ForeArm");
             
             return (pt2.y-pt.y)*(pt2.y-pt.y) + (pt3.y-pt.y)*(pt3.y-pt.y);
             return (pt3.y-pt.y)*(pt3.y-pt.y); //we only care about this point.
@@ -1700,9 +2070,9 @@ public:
         
         float armDistanceFromHipinY(std::string whichArm)
         {
-            ci::vec3 pt = figure->getBone("Hip")->getAnchorPos();
-            ci::vec3 pt2 =  figure->getBone(whichArm+"UpperArm")->getAnchorPos();
-            ci::vec3 pt3 =  figure->getBone(whichArm+"ForeArm")->getAnchorPos();
+            ci::vec3 pt = figure->getAnchorPos("Hip");
+            ci::vec3 pt2 =  figure->getAnchorPos(whichArm+"UpperArm");
+            ci::vec3 pt3 =  figure->getAnchorPos(whichArm+"ForeArm");
             
             return (pt2.y-pt.y) + (pt3.y-pt.y);
             
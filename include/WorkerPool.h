@@ -0,0 +1,126 @@
+//
+//  WorkerPool.h
+//  VideoAndOSCLab
+//
+//  A fixed set of threads for running the same job over many things at once, eg. updating every dancer (Entity) each
+//  frame. run(count, job) calls job(0) .. job(count-1), spread over the workers & the calling thread, & returns once they
+//  have all finished -- so whatever the jobs wrote is there for the caller afterwards. The threads are started in the
+//  constructor & wait between runs, so nothing is created per frame. Jobs must not touch each other's things.
+//
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace CRCPMotionAnalysis {
+
+class WorkerPool
+{
+protected:
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable wake; //a new run or quitting
+    std::condition_variable done; //the last worker finished the run
+
+    //the current run -- only changed while no worker is in it
+    const std::function<void(int)> *job;
+    int jobCount;
+    std::atomic<int> nextJob;
+    int working; //workers not finished w/the current run
+    long runs; //so the workers can tell a new run from the last one
+    bool quitting;
+
+    //takes jobs until there are none left
+    void doJobs()
+    {
+        int i;
+        while( (i = nextJob.fetch_add(1, std::memory_order_relaxed)) < jobCount )
+            (*job)(i);
+    };
+
+    void workLoop()
+    {
+        long seen = 0;
+        while( true )
+        {
+            {
+                std::unique_lock<std::mutex> l(lock);
+                wake.wait(l, [&]{ return quitting || runs != seen; });
+                if( quitting ) return;
+                seen = runs;
+            }
+
+            doJobs();
+
+            std::lock_guard<std::mutex> l(lock);
+            if( --working == 0 ) done.notify_one();
+        }
+    };
+
+public:
+    //threadCount < 0: one less than the cores, as the calling thread works too. 0: run() does everything itself
+    WorkerPool(int threadCount = -1) : nextJob(0)
+    {
+        job = NULL;
+        jobCount = 0;
+        working = 0;
+        runs = 0;
+        quitting = false;
+
+        if( threadCount < 0 ) threadCount = std::max(0, int(std::thread::hardware_concurrency()) - 1);
+        for(int i=0; i<threadCount; i++)
+            threads.push_back( std::thread(&WorkerPool::workLoop, this) );
+    };
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            quitting = true;
+        }
+        wake.notify_all();
+        for(int i=0; i<threads.size(); i++)
+            threads[i].join();
+    };
+
+    //not counting the calling thread
+    int getThreadCount()
+    {
+        return threads.size();
+    };
+
+    //job(0) .. job(count-1), in no particular order or thread -- returns when all are done
+    void run(int count, const std::function<void(int)> &job_)
+    {
+        if( threads.empty() || count <= 1 )
+        {
+            for(int i=0; i<count; i++) job_(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> l(lock);
+            job = &job_;
+            jobCount = count;
+            nextJob.store(0, std::memory_order_relaxed);
+            working = threads.size();
+            runs++;
+        }
+        wake.notify_all();
+
+        doJobs();
+
+        std::unique_lock<std::mutex> l(lock);
+        done.wait(l, [&]{ return working == 0; });
+        job = NULL;
+    };
+};
+
+};
+
+#endif /* WorkerPool_h */
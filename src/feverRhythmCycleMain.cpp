@@ -7,75 +7,15 @@
  
  ***/
 
-//osc messages
-#define ELAPSED_FRAMES_ADDR "/VideoAndOSCLab/elapsedFrames"
-#define ELAPSED_SECS_ADDR "/VideoAndOSCLab/elapsedSeconds"
-#define SYNTIEN_MESSAGE "/syntien/motion/1/scope1"
-#define WIIMOTE_ACCEL_MESSAGE_PART1 "/wii/"
-#define WIIMOTE_ACCEL_MESSAGE_PART2 "/accel/pry"
-#define WIIMOTE_BUTTON_1 "/wii/1/button/1"
-#define NOTCH_MESSAGE "/Notch/BonePosAndAccel"
-#define NOTCH_PEAK "/Notch/Peak"
-#define DERIVATIVE_OSCMESSAGE "/CBIS/Derivative"
-#define SIGAVG_OSCMESSAGE "/CBIS/Average"
-#define CI_OSCMESSAGE "/CBIS/CI" //send contraction index
-#define ARMHEIGHT_OSCMESSAGE "/CBIS/ArmHeight" //send relative arm height index
-#define VERTICALITY_OSCMESSAGE "/CBIS/Verticality" //send verticality
-#define MIDINOTE_OSCMESSAGE "/CBIS/MidiNote"
-
-
-#define SEND_TO_WEKINATOR 1
-#define WEK_MESSAGE "/wek/inputs"
-
-//for sending busy spase to max 7
-#define BUSY_SPARSE_PERCUSSION "/InteractiveTango/BusySparse/Beats"
-#define BUSY_SPARSE_DANCERS "/InteractiveTango/BusySparse/Dancers"
-#define EXPMUSIC_HARMONY "/InteractiveTango/Experimental/Harmony"
-#define EXPMUSIC_INTROFILL "/InteractiveTango/Experimental/HarmonyIntroFill"
-#define EXPMUSIC_CLOSEFILL "/InteractiveTango/Experimental/HarmonyCloseFill"
-#define EXPMUSIC_MELODY_INSTRUMENT "/InteractiveTango/Experimental/Melody/Instrument"
-#define EXPMUSIC_ACCOMP_INSTRUMENT "/InteractiveTango/Experimental/Accompaniment/Instrument"
-#define EXPMUSIC_SECTION "/InteractiveTango/Experimental/Section"
-
-
 #include "cinder/app/App.h"
 #include "cinder/app/RendererGl.h"
 #include "cinder/gl/gl.h"
 #include "cinder/Capture.h" //needed for capture
 #include "cinder/Log.h" //needed to log errors
+#include "cinder/Utilities.h" //getDocumentsDirectory()
 
-#include <sstream>
-#include <math.h>
-#include <algorithm>
-
-#include "Osc.h"
-
-#include "Containers.h"
-#include "BeatTiming.h"
-#include "MotionCaptureData.h"
-#include "Sensor.h"
-#include "MotionAnalysisOuput.h"
-#include "UGENs.h"
-
-
-#include "PerceptualMappingScheme.h"
-#include "PerceptualSchemas.h"
-
-#include "Instruments.h"
-#include "MidiUtility.h"
-//#include "MusicPlayer.h"
-//#include "ChordGeneration.h"
-#include "MelodyGeneratorAlgorithm.h"
-#include "MelodyGenerator.h"
-#include "PeakDetection.h"
-
-//#include "ExperimentalMusicPlayer.h"
-
-#include "FactorOracle.h"
-
-
-#include "MeasuredEntities.h"
-#include "SaveOSC.h"
+#include "MotionAnalysis.h" //the analysis & the osc addresses
+#include "Benchmarks.h"
 
 #define LOCALPORT 8886
 #define LOCALPORT2 8887
@@ -88,16 +28,12 @@
 
 #define REMOTELAPTOP_PORT 3333
 #define REMOTELAPTOP_ADDRESS "192.168.1.88"
-
-#define MAX_NUM_OF_WIIMOTES 6 //limitation of bluetooth class 2
-#define PHONE_ID "7" //this assumes only one phone using Syntien or some such -- can modify if you have more...
+#define REMOTELAPTOP_MAX_RATE 3000 //messages per second over the wifi -- the rest wait & the latest values win
 
 using namespace ci;
 using namespace ci::app;
 using namespace std;
 
-using Receiver = osc::ReceiverUdp;
-using protocol = asio::ip::udp;
 
 //This class demonstrates a 'hello, world' for the signal processing tree paradigm for motion capture
 //Receives wiimote data, puts an averaging filter on it, then draws the data
@@ -105,6 +41,7 @@ using protocol = asio::ip::udp;
 class FeverRhythmCycleMain : public App {
 public:
     FeverRhythmCycleMain();
+    ~FeverRhythmCycleMain();
     
     void setup() override;
     //    void mouseDown( MouseEvent event ) override;
@@ -123,9 +60,9 @@ protected:
     gl::TextureRef             mTexture;
     SurfaceRef                 mSurface;
     
-    osc::SenderUdp             mSender;
-    osc::SenderUdp             mWekSender;
-    osc::SenderUdp             mRemoteLaptopSender;
+    //each frame's OSC goes out in bundles, from a thread of its own -- see OSCFanOut.h. The destinations are set up in setup()
+    CRCPMotionAnalysis::OSCFanOut mOSCOut;
+    int mLocalPatch, mWekinator, mRemoteLaptop;
     
     //moving to 3d drawing
     void drawGrid(float size, float step);
@@ -143,176 +80,73 @@ protected:
 
     void sendOSC(std::string addr, float value);
     
-    Receiver mReceiver; //new
-    std::map<uint64_t, protocol::endpoint> mConnections; //new
+    CRCPMotionAnalysis::MotionAnalysisPipeline mPipeline; //the sensors & people, & the receiver for their OSC -- see MotionAnalysisPipeline.h
+    double mReceiveClockOffset; //getElapsedSeconds() - MocapReceiver::now()
+    void receiveMocapData();
+    
+    //messages the receiving thread passes on -- see receiveMocapData()
+    class ReceivedMessageHandler
+    {
+    public:
+        void operator()(const CRCPMotionAnalysis::OSCMessageReader &msg);
+    };
     
     //below for printing out iphone info
     std::vector<ci::vec2> points;
     std::vector<float>  alpha;
     
-    void updatePhoneValues(const osc::Message &message);
-    void updateWiiValues(const osc::Message &message);
-    void updateNotchValues(const osc::Message &message);
-    void createNotchMotionData(std::string _id, std::string who, std::string sendingDevice, std::vector<float> vals);
-    void printSensors();
-
     void printNotchValues(const osc::Message &message);
-    void addPhoneAndWiiData(const osc::Message &message, std::string _id);
-    
-    CRCPMotionAnalysis::SensorData *getSensor( std::string _id, int which, CRCPMotionAnalysis::MocapDeviceData::MocapDevice device, CRCPMotionAnalysis::MocapDeviceData::SendingDevice sdevice); // find sensor or wiimote in list via id
-    std::vector<CRCPMotionAnalysis::SensorData *> mSensors; //all the sensors which have sent us OSC -- well only wiimotes so far
-    std::vector<CRCPMotionAnalysis::BodyPartSensor *> mBodyParts;  //who are we measuring? change name when specifics are known.
-    std::vector<CRCPMotionAnalysis::Entity *> mPeople;
     
     float seconds; //where we are
     
     //file
-    CRCPMotionAnalysis::SaveOSC *saveOSC;
+    CRCPMotionAnalysis::SessionRecorder *mRecorder; //records the incoming OSC, NULL if not saving
+    void convertSessionToCSV();
     CRCPMotionAnalysis::PlayOSC *playOSC;
+    CRCPMotionAnalysis::SessionPlayer *mSessionPlayer; //plays session logs, see SessionPlayer.h
+    void openPlayback();
+    void reanalyseSession();
+    void sessionPlayerKeys(KeyEvent event);
+    
+    //feeds a session straight into the analysis -- see SessionPlayer::playAsFastAsPossible()
+    class OfflineFeed
+    {
+    public:
+        FeverRhythmCycleMain *app;
+        long frames;
+        void packet(const char *data, int size, double sessionSeconds);
+        void frame(double sessionSeconds);
+    };
+    
+    void updateMotionAnalysis(bool sendToRemote=true);
+    
+    CRCPMotionAnalysis::ProfileReporter *mProfileReporter; //sends the timing stats to the local patch & LamentStats.csv -- see Profiler.h
+    int mDrawProbe;
     
     int testOSCNumber;
 };
 
-FeverRhythmCycleMain::FeverRhythmCycleMain() : mSender(LOCALPORT, DESTHOST, DESTPORT), mReceiver( LOCALPORT2 ), mWekSender(LOCALPORT3, DESTHOST, WEKPORT), mRemoteLaptopSender(LOCALPORT4, REMOTELAPTOP_ADDRESS, REMOTELAPTOP_PORT)
+FeverRhythmCycleMain::FeverRhythmCycleMain() : mPipeline( LOCALPORT2 )
 {
     
 }
 
+FeverRhythmCycleMain::~FeverRhythmCycleMain()
+{
+    mPipeline.getReceiver().stop();
+    mOSCOut.stop();
+    if(mRecorder != NULL) delete mRecorder; //writes out the rest & closes the file
+    if(mSessionPlayer != NULL) delete mSessionPlayer;
+    if(mProfileReporter != NULL) delete mProfileReporter;
+}
+
 //outdated vestige
 void FeverRhythmCycleMain::sendOSC(std::string addr, float value)
 {
     osc::Message msg;
     msg.setAddress(addr);
     msg.append(value); //adds a parameter
-    mSender.send(msg);
-}
-
-//this has not been implemented into signal tree paradigm yet. ah well. TODO: implement as such
-void FeverRhythmCycleMain::updatePhoneValues(const osc::Message &message)
-{
-//    std::cout << "received\n";
-    addPhoneAndWiiData(message, PHONE_ID);
-}
-
-//gets data from osc message then adds wiimote data to sensors
-void FeverRhythmCycleMain::addPhoneAndWiiData(const osc::Message &message, std::string _id)
-{
-    CRCPMotionAnalysis::MocapDeviceData *sensorData;
-    std::string dID = _id ;
-    int which = std::atoi(_id.c_str()); //convert to int
-    
-    
-    if(!dID.compare(PHONE_ID)){
-        sensorData = new CRCPMotionAnalysis::IPhoneDeviceData();
-    }
-    else{
-        sensorData = new CRCPMotionAnalysis::MocapDeviceData();
-    }
-
-    
-    CRCPMotionAnalysis::SensorData *sensor = getSensor( _id, which, sensorData->getDeviceType(), CRCPMotionAnalysis::MocapDeviceData::SendingDevice::UNSPECIFIED );
-    
-    //set time stamp
-    sensorData->setData( CRCPMotionAnalysis::MocapDeviceData::DataIndices::TIME_STAMP, seconds ); //set timestamp from program -- synch with call to update()
-    
-    //add accel data
-    for(int i= 0; i<3; i++)
-        sensorData->setData(CRCPMotionAnalysis::MocapDeviceData::DataIndices::ACCELX+i, message.getArgFloat(i));
-    
-    sensor->addSensorData(sensorData);
-}
-
-//return sensor with id & or create one w/detected id then return that one
-CRCPMotionAnalysis::SensorData *FeverRhythmCycleMain::getSensor( std::string _id, int which, CRCPMotionAnalysis::MocapDeviceData::MocapDevice device, CRCPMotionAnalysis::MocapDeviceData::SendingDevice sDevice )
-{
-    
-    bool found = false;
-    int index = 0;
-    
-//    printSensors();
-    
-    while( !found && index < mSensors.size() )
-    {
-        found = mSensors[index]->same( _id, which, sDevice );
-        index++;
-    }
-    
-    if(found)
-    {
-//        if(!_id.compare("ChestBottom")){
-//            std::cout << mSensors[index-1]->getDeviceID() << "==" << _id << "    " ;
-//            std::cout << mSensors[index-1]->getSendingDeviceString() << "==" ;
-//            if (sDevice == CRCPMotionAnalysis::MocapDeviceData::SendingDevice::ANDROID)
-//                std::cout << "Android\n";
-//            else std::cout << "iOS\n";
-//        }
-        return mSensors[index-1];
-    }
-    else
-    {
-        CRCPMotionAnalysis::SensorData *sensor = new CRCPMotionAnalysis::SensorData( _id, which, device, sDevice );
-        
-        mSensors.push_back(sensor);
-        
-        //TODO: ok, handle multiple entities later -- (use the "who" id in the OSC message)
-        if(mPeople.size() <= 0)
-        {
-            mPeople.push_back(new CRCPMotionAnalysis::Entity());
-        }
-        
-        //okay now test if this body part already exists in the person
-        //this is bc do not want to use different sensors from the same bodypart (eg. chest) which
-        // bc it is a root bone will need to be duplicated across phones
-        //ergo this info will be discarded...
-        if(mPeople[0]->bodyPartExists(sensor->getDeviceID()))  //yip for now.
-        {
-            std::cout << "Note that " << sensor->getDeviceID() << " exists already. Not using data from device ";
-            if (sDevice == CRCPMotionAnalysis::MocapDeviceData::SendingDevice::ANDROID)
-                std::cout << "Android\n";
-            else std::cout << "iOS\n";
-            
-            return sensor;
-        }
-        
-            
-        //add to 'body part' the data structure which can combine sensors. It currently only has one body part so it is simple.
-        
-        //TODO: check the UGEN / averaging sensor ID
-        int bodyPartID  = mSensors.size()-1;
-        CRCPMotionAnalysis::BodyPartSensor *bodyPart = new CRCPMotionAnalysis::BodyPartSensor();
-        bodyPart->addSensor(bodyPartID, sensor, sDevice);  //note that this should change if using bones, etc.
-        mBodyParts.push_back(bodyPart);
-        
-        mPeople[0]->addBodyPart(bodyPart);
-        
-        return sensor;
-    }
-}
-
-void FeverRhythmCycleMain::printSensors()
-{
-    std::cout << "-------- SensorList: \n";
-
-    for (CRCPMotionAnalysis::SensorData *sensor : mSensors)
-    {
-        if(sensor != NULL)
-        {
-            std::cout << "Bone: " << sensor->getDeviceID() ;
-            std::cout << " Sending Device: " << sensor->getSendingDeviceString() << std::endl ;
-        }
-    }
-    
-}
-
-//finds the id of the wiimote then adds the wiidata to ugens
-void FeverRhythmCycleMain::updateWiiValues(const osc::Message &message)
-{
-    //get which wii
-    std::string addr = message.getAddress();
-    std::string pt1 = WIIMOTE_ACCEL_MESSAGE_PART1;
-    int index = addr.find_first_of(pt1);
-    std::string whichWii = addr.substr(index+pt1.length(), 1);
-    addPhoneAndWiiData(message, whichWii);
+    mOSCOut.add(msg); //goes w/the next frame
 }
 
 void FeverRhythmCycleMain::printNotchValues(const osc::Message &message)
@@ -346,256 +180,39 @@ void FeverRhythmCycleMain::printNotchValues(const osc::Message &message)
 
 }
 
-//handles notch data
-void FeverRhythmCycleMain::updateNotchValues(const osc::Message &message)
+//takes everything the receiving thread has queued since the last frame -- the samples go to the sensors, see
+//MotionAnalysisPipeline::receive()
+void FeverRhythmCycleMain::receiveMocapData()
 {
-    //print it out. Note that for each bone, you will want to create a new sensor
-//    printNotchValues(message);
-    
-    /*** format of the notch OSC message
-     1. Sample Rate (currently it is 20Hz - can be  changed as this is low)
-     2. frame - which frame it is in cur. data grab
-     
-     Then for each bone:
-        Bone name (eg, Root)
-        acceleration - x, y, z
-        then the different angles for each bone, for example the chest: 1. anterior/posterior tilt,  2. rotation left or right, and 3. lateral tilt -  left & right
-
-     Only measured bones have all 6 values. Static bones w.o notches attached are reported but only have position info
-     
-     THis function also forwards data to wekinator - TODO: perhaps refactor out
-     
-     ***/
-    
-    std::string bone = "";
-    std::string sendingDevice = "";
-    std::string sender="";
-    osc::Message wekMsg;
-    
-//    std::cout << message << std::endl;
-
-/*
-address: /Notch/BonePosAndAccel
-    Sender Ip Address: 192.168.1.3
-    <FLOAT>: 20
-    <INTEGER_32>: 0
-    <STRING>: Root
-    <FLOAT>: 0
-    <FLOAT>: 0
-    <FLOAT>: 0
-    <STRING>: Hip
-    <FLOAT>: 0.00390107
-    <FLOAT>: -0.0765789
-    <FLOAT>: -0.00750544
-    <FLOAT>: -0.00207619
-    <FLOAT>: 0.0386578
-    <FLOAT>: 0.0100631
-    <STRING>: Tummy
-    <FLOAT>: -0.0111514
-    <FLOAT>: 0.230822
-    <FLOAT>: 0.0350948
-    <STRING>: ChestBottom
-    <FLOAT>: -0.0280236
-    <FLOAT>: -0.0667842
-    <FLOAT>: 0.0630484
-    <FLOAT>: -0.0170402
-    <FLOAT>: 0.396716
-    <FLOAT>: 0.0359006
-    <STRING>: ChestTop
-    <FLOAT>: -0.0191746
-    <FLOAT>: 0.4962
-    <FLOAT>: 0.025989
-    <STRING>: LeftCollar
-    <FLOAT>: 0.136829
-    <FLOAT>: 0.480698
-    <FLOAT>: 0.0385829
-    <STRING>: LeftUpperArm
-    <FLOAT>: -0.283832
-    <FLOAT>: -0.0355547
-    <FLOAT>: -0.135343
-    <FLOAT>: 0.165057
-    <FLOAT>: 0.226576
-    <FLOAT>: 0.0566382
-    <STRING>: LeftForeArm
-    <FLOAT>: 0.278568
-    <FLOAT>: 0.1125
-    <FLOAT>: 0.0132517
-    <FLOAT>: 0.164294
-    <FLOAT>: -0.0829402
-    <FLOAT>: 0.0876608
-    <STRING>: LeftHand
-    <FLOAT>: 0.160795
-    <FLOAT>: -0.232138
-    <FLOAT>: 0.102758
-    <STRING>: RightCollar
-    <FLOAT>: -0.174324
-    <FLOAT>: 0.471908
-    <FLOAT>: 0.0173598
-    <STRING>: RightUpperArm
-    <FLOAT>: 0.214931
-    <FLOAT>: -0.00784064
-    <FLOAT>: -0.329319
-    <FLOAT>: -0.225098
-    <FLOAT>: 0.220704
-    <FLOAT>: 0.0217642
-    <STRING>: RightForeArm
-    <FLOAT>: -0.901787
-    <FLOAT>: -0.342038
-    <FLOAT>: 0.0815372
-    <FLOAT>: -0.300555
-    <FLOAT>: -0.0756913
-    <FLOAT>: 0.0785047
-    <STRING>: RightHand
-    <FLOAT>: -0.333907
-    <FLOAT>: -0.219269
-    <FLOAT>: 0.106307
-    <STRING>: Neck
-    <FLOAT>: -0.0218852
-    <FLOAT>: 0.622546
-    <FLOAT>: 0.0134013
-    <STRING>: Head
-    <FLOAT>: -0.0256952
-    <FLOAT>: 0.750411
-    <FLOAT>: 0.0163005
-    <STRING>: LeftHip
-    <FLOAT>: 0
-    <FLOAT>: 0
-    <FLOAT>: 0
-    <STRING>: LeftThigh
-    <FLOAT>: 0
-    <FLOAT>: -0.422
-    <FLOAT>: 0
-    <STRING>: LeftLowerLeg
-    <FLOAT>: 0
-    <FLOAT>: -0.865
-    <FLOAT>: 0
-    <STRING>: LeftFootTop
-    <FLOAT>: 0
-    <FLOAT>: -0.905
-    <FLOAT>: 0.1047
-    <STRING>: LeftFootFront
-    <FLOAT>: 0
-    <FLOAT>: -0.9395
-    <FLOAT>: 0.1978
-    <STRING>: LeftHeel
-    <FLOAT>: 0
-    <FLOAT>: -0.9285
-    <FLOAT>: -0.0592
-    <STRING>: RightHip
-    <FLOAT>: 0
-    <FLOAT>: 0
-    <FLOAT>: 0
-    <STRING>: RightThigh
-    <FLOAT>: 0
-    <FLOAT>: -0.422
-    <FLOAT>: 0
-    <STRING>: RightLowerLeg
-    <FLOAT>: 0
-    <FLOAT>: -0.865
-    <FLOAT>: 0
-    <STRING>: RightFootTop
-    <FLOAT>: 0
-    <FLOAT>: -0.905
-    <FLOAT>: 0.1047
-    <STRING>: RightFootFront
-    <FLOAT>: 0
-    <FLOAT>: -0.9395
-    <FLOAT>: 0.1978
-    <STRING>: RightHeel
-    <FLOAT>: 0
-    <FLOAT>: -0.9285
-    <FLOAT>: -0.0592
-*/
-    
-    if(SEND_TO_WEKINATOR)
+    CRCPMotionAnalysis::MocapReceiver &receiver = mPipeline.getReceiver();
+    mPipeline.receive(seconds);
+    
+    //forward to wekinator
+    const CRCPMotionAnalysis::WekinatorFrame *frame;
+    while( (frame = receiver.getWekinatorFrames().front()) != NULL )
     {
+        osc::Message wekMsg;
         wekMsg.setAddress(WEK_MESSAGE);
+        for(int i=0; i<frame->count; i++)
+            wekMsg.append(frame->values[i]);
+        mOSCOut.add(wekMsg); //sent w/the rest of the frame, only to wekinator -- see updateMotionAnalysis()
+        receiver.getWekinatorFrames().popFront();
     }
     
-//    std::cout << message << std::endl;
-    
-    sendingDevice = message.getArgString(1);
-    sender = message.getArgString(0);
-
-    for ( int i=3; i<message.getNumArgs(); i++)
+    //handle anything the receiving thread doesn't decode
+    const CRCPMotionAnalysis::OSCRawPacket *packet;
+    while( (packet = receiver.getRawPackets().front()) != NULL )
     {
-        ci::osc::ArgType type_ = message.getArgType(i);
-        
-        if(type_ == ci::osc::ArgType::STRING)
-        {
-            
-            bone = message.getArgString(i);
-            
-            
-            i++;
-            bool end_val = false;
-            std::vector<float> values;
-            while (i<message.getNumArgs() && !end_val)
-            {
-                end_val = message.getArgType(i) != ci::osc::ArgType::FLOAT;
-                if(!end_val)
-                {
-                    values.push_back(message.getArgFloat(i));
-                }
-                i++;
-            }
-            i-=2; //will always return 2 more than needed
-            
-
-            const int NUMBER_OFVALUES_NEEDED_TOBE_LIVE = 6; //just sayin'
-            if(values.size() >= NUMBER_OFVALUES_NEEDED_TOBE_LIVE) //this is then, a measured value
-            {
-                createNotchMotionData(bone, sender, sendingDevice, values);
-            }
-            
-            //if sending to wekinator
-            //append to message and send to wek, if relevant
-            if(SEND_TO_WEKINATOR && values.size() >= 6)
-            {
-                for(int i=0; i<values.size(); i++)
-                    wekMsg.append(values[i]);
-            }
-        }
-
-
+        ReceivedMessageHandler handler;
+        CRCPMotionAnalysis::oscForEachMessage(packet->data, packet->size, handler);
+        receiver.getRawPackets().popFront();
     }
-    if(SEND_TO_WEKINATOR)
-        mWekSender.send(wekMsg);
 }
 
-void FeverRhythmCycleMain::createNotchMotionData(std::string _id, std::string who, std::string sendingDevice, std::vector<float> vals)
+void FeverRhythmCycleMain::ReceivedMessageHandler::operator()(const CRCPMotionAnalysis::OSCMessageReader &msg)
 {
-    CRCPMotionAnalysis::MocapDeviceData *sensorData;
-    
-    sensorData = new CRCPMotionAnalysis::NotchDeviceData();
-    sensorData->setSendingDevice(sendingDevice);
-    
-    //TODO: deal with the "who" value
-    
-    //hack hack -- change this value to indicate different people -- note: will need to add to OSC coming from phone - so let me know if anyone needs this
-    const int notchDataID = 9;
-
-    CRCPMotionAnalysis::SensorData *sensor = getSensor( _id, notchDataID, sensorData->getDeviceType(), sensorData->getSendingDevice() );
-    
-    //set time stamp
-    sensorData->setData( CRCPMotionAnalysis::MocapDeviceData::DataIndices::TIME_STAMP, seconds ); //set timestamp from program -- synch with call to update()
-    
-    //add accel + bone position data
-    for(int i= 0; i<3; i++){
-        sensorData->setData(CRCPMotionAnalysis::MocapDeviceData::DataIndices::ACCELX+i, vals[i]);
-        sensorData->setData(CRCPMotionAnalysis::MocapDeviceData::DataIndices::BONEANGLE_TILT+i, vals[i+3]);
-        if(vals.size() > 6) //make compatible with previous recordings... I guess
-        {
-            sensorData->setData(CRCPMotionAnalysis::MocapDeviceData::DataIndices::RELATIVE_TILT+i, vals[i+6]);
-            sensorData->setData(CRCPMotionAnalysis::MocapDeviceData::DataIndices::ANGVEL_TILT+i, vals[i+9]);
-        }
-        else
-        {
-//            std::cout << "Using depreciated apps & sensor recordings....\n";
-        }
-    }
-    
-    sensor->addSensorData(sensorData);
+    if( msg.addressIs("/testThisShit") )
+        std::cout << "This shit works!!\n";
 }
 
 //set up osc
@@ -610,85 +227,154 @@ void FeverRhythmCycleMain::setup()
     
     initCamera();
     
-    try{
-        mSender.bind();
-    }
-    catch( osc::Exception &e)
+    //the events, which are never coalesced -- /Notch/Peak is every bone's state every frame, so the latest will do
+    mOSCOut.addEventAddress(NOTCH_ONSET); //& /Notch/Onset/Retract
+    mOSCOut.addEventAddress(MIDINOTE_OSCMESSAGE);
+    
+    //where the OSC goes -- the analysis & the stats to the patch, the analysis to the remote laptop, the mocap to wekinator
+    mLocalPatch = mOSCOut.addDestination("Local patch", LOCALPORT, DESTHOST, DESTPORT);
+    mOSCOut.getDestination(mLocalPatch).addExcept(WEK_MESSAGE);
+    
+    mWekinator = mOSCOut.addDestination("Wekinator", LOCALPORT3, DESTHOST, WEKPORT);
+    mOSCOut.getDestination(mWekinator).addOnly(WEK_MESSAGE);
+    mOSCOut.getDestination(mWekinator).setOverflow(CRCPMotionAnalysis::OSC_COALESCE_LATEST);
+    
+    mRemoteLaptop = mOSCOut.addDestination("Remote laptop", LOCALPORT4, REMOTELAPTOP_ADDRESS, REMOTELAPTOP_PORT);
+    mOSCOut.getDestination(mRemoteLaptop).addExcept(WEK_MESSAGE);
+    mOSCOut.getDestination(mRemoteLaptop).addExcept(STATS_OSCMESSAGE);
+    mOSCOut.getDestination(mRemoteLaptop).setRateLimit(REMOTELAPTOP_MAX_RATE);
+    mOSCOut.getDestination(mRemoteLaptop).setOverflow(CRCPMotionAnalysis::OSC_COALESCE_LATEST);
+    
+    if( !mOSCOut.start() )
     {
-        CI_LOG_E( "Error binding" << e.what() << " val: " << e.value() );
+        CI_LOG_E( "Error binding the OSC senders to ports " << LOCALPORT << ", " << LOCALPORT3 << " & " << LOCALPORT4 );
         quit();
     }
     
-    try{
-        mWekSender.bind();
-    }
-    catch( osc::Exception &e)
+    //the receiving thread decodes the mocap OSC & queues the samples for update() -- see receiveMocapData()
+    mReceiveClockOffset = getElapsedSeconds() - CRCPMotionAnalysis::MocapReceiver::now();
+    mPipeline.setOnsetTimeOffset(mReceiveClockOffset); //the onsets' times in the OSC, on our clock
+
+    //opens a file to save incoming OSC -- a binary session log, see SessionRecorder.h & 'c' to convert to CSV
+    fs::path fpath = getSaveFilePath();
+    mRecorder = NULL;
+    if(!fpath.empty())
     {
-        CI_LOG_E( "Error binding" << e.what() << " val: " << e.value() );
-        quit();
+        mRecorder = new CRCPMotionAnalysis::SessionRecorder(fpath.string(), mReceiveClockOffset);
+        if(mRecorder->isOpen()) mPipeline.getReceiver().setRecorder(mRecorder);
     }
+    playOSC = NULL; //init the play to null
+    mSessionPlayer = NULL;
     
-    try{
-        mRemoteLaptopSender.bind();
-    }
-    catch( osc::Exception &e)
+    //the timing of every ugen, listener & the drawing, every 2 seconds -- 's' prints it
+    mProfileReporter = new CRCPMotionAnalysis::ProfileReporter( (getDocumentsDirectory() / "LamentStats.csv").string() );
+    mDrawProbe = CRCPMotionAnalysis::Profiler::get().probe("frame/draw");
+    CRCPMotionAnalysis::LatencyTracer::get().setEnabled(true); //packet -> peak -> send, w/the stats -- see LatencyTrace.h
+    
+    if( !mPipeline.getReceiver().start() )
     {
-        CI_LOG_E( "Error binding" << e.what() << " val: " << e.value() );
+        CI_LOG_E( "Error binding the mocap receiver to port " << LOCALPORT2 );
         quit();
     }
+}
+
+//writes a saved session log out as CSV in the format SaveOSC used, eg. for PlayOSC
+void FeverRhythmCycleMain::convertSessionToCSV()
+{
+    fs::path filename = getOpenFilePath();
+    if(filename.empty()) return;
+    CRCPMotionAnalysis::SessionRecorder::convertToCSV(filename.string(), filename.string() + ".csv");
+}
+
+//plays a session log (SessionPlayer) or an old CSV file (PlayOSC)
+void FeverRhythmCycleMain::openPlayback()
+{
+    fs::path filename = getOpenFilePath();
+    if(filename.empty()) return;
     
-    //opens a file to save incoming OSC
-    fs::path fpath = getSaveFilePath();
-    saveOSC = new CRCPMotionAnalysis::SaveOSC(fpath.c_str());
-    playOSC = NULL; //init the play to null
-    
-    //ListenerFn = std::function<void( const Message &message )>
-    mReceiver.setListener( SYNTIEN_MESSAGE, [&]( const osc::Message &msg ){
-        saveOSC->add(msg, getElapsedSeconds()); //add this line to save the OSC
-        updatePhoneValues(msg);
-    });
-    
-    for (int i=0; i<MAX_NUM_OF_WIIMOTES; i++)
+    if(CRCPMotionAnalysis::MappedSessionFile::isSessionLog(filename.string()))
     {
-        std::stringstream addr;
-        addr << WIIMOTE_ACCEL_MESSAGE_PART1 << i << WIIMOTE_ACCEL_MESSAGE_PART2;
-        mReceiver.setListener( addr.str(), [&]( const osc::Message &msg ){
-            saveOSC->add(msg, getElapsedSeconds()); //add this line to save the OSC
-            updateWiiValues(msg);
-        });
+        if(mSessionPlayer != NULL) delete mSessionPlayer;
+        mSessionPlayer = new CRCPMotionAnalysis::SessionPlayer(filename.string(), DESTHOST, LOCALPORT2);
     }
-    testOSCNumber = 0;
-    mReceiver.setListener( NOTCH_MESSAGE, [&]( const osc::Message &msg ){
-        saveOSC->add(msg, getElapsedSeconds()); //add this line to save the OSC
-        updateNotchValues(msg);
-    });
+    else playOSC = new CRCPMotionAnalysis::PlayOSC(filename.c_str(), DESTHOST, LOCALPORT2, LOCALPORT + 10);
+}
+
+void FeverRhythmCycleMain::sessionPlayerKeys(KeyEvent event)
+{
+    static double loopStart = -1; //waiting for the loop end, if >= 0
     
-    mReceiver.setListener( "/testThisShit", [&]( const osc::Message &msg ){
-        std::cout << "This shit works!!\n";
-    });
-    try {
-        // Bind the receiver to the endpoint. This function may throw.
-        mReceiver.bind();
+    if(event.getChar() == '[' || event.getChar() == ']')
+    {
+        mSessionPlayer->setRate( event.getChar() == '[' ? mSessionPlayer->getRate() * 0.5 : mSessionPlayer->getRate() * 2.0 );
+        std::cout << "Playback rate: " << mSessionPlayer->getRate() << "x\n";
     }
-    catch( const osc::Exception &ex ) {
-        CI_LOG_E( "Error binding: " << ex.what() << " val: " << ex.value() );
-        quit();
+    else if(event.getChar() == ',' || event.getChar() == '.')
+    {
+        double to = mSessionPlayer->getPlayhead() + ( event.getChar() == ',' ? -10 : 10 );
+        to = std::max(mSessionPlayer->getStartTime(), std::min(mSessionPlayer->getEndTime(), to));
+        mSessionPlayer->seek(to);
+        std::cout << "Playback at " << to - mSessionPlayer->getStartTime() << " seconds\n";
+    }
+    else if(event.getChar() == 'l')
+    {
+        if(mSessionPlayer->isLooping())
+        {
+            mSessionPlayer->clearLoop();
+            std::cout << "Stopped looping\n";
+        }
+        else if(loopStart < 0)
+        {
+            loopStart = mSessionPlayer->getPlayhead();
+            std::cout << "Loop start set, press 'l' again at the loop end\n";
+        }
+        else
+        {
+            mSessionPlayer->setLoop(loopStart, mSessionPlayer->getPlayhead());
+            std::cout << "Looping " << mSessionPlayer->getPlayhead() - loopStart << " seconds\n";
+            loopStart = -1;
+        }
     }
-    
-    // UDP opens the socket and "listens" accepting any message from any endpoint. The listen
-    // function takes an error handler for the underlying socket. Any errors that would
-    // call this function are because of problems with the socket or with the remote message.
-    mReceiver.listen(
-                     []( asio::error_code error, protocol::endpoint endpoint ) -> bool {
-                         if( error ) {
-                             CI_LOG_E( "Error Listening: " << error.message() << " val: " << error.value() << " endpoint: " << endpoint );
-                             return false;
-                         }
-                         else
-                             return true;
-                     });
-    
-    
+}
+
+//runs a whole session log through the analysis w/o the network or waiting for its clock. The live receiver is paused
+//meanwhile & the session isn't recorded again
+void FeverRhythmCycleMain::reanalyseSession()
+{
+    fs::path filename = getOpenFilePath();
+    if(filename.empty()) return;
+    CRCPMotionAnalysis::SessionPlayer player(filename.string(), DESTHOST, LOCALPORT2);
+    if(!player.isValid()) return;
+    
+    mPipeline.getReceiver().stop();
+    mPipeline.getReceiver().setRecorder(NULL);
+    CRCPMotionAnalysis::LatencyTracer::get().setEnabled(false); //the session's receive times aren't on our clock
+    
+    OfflineFeed feed;
+    feed.app = this;
+    feed.frames = 0;
+    CRCPMotionAnalysis::BenchmarkTimer timer;
+    player.playAsFastAsPossible(feed, 1.0/60.0);
+    double ms = timer.elapsedMS();
+    std::cout << "Re-analysed " << player.getEndTime() - player.getStartTime() << " seconds (" << feed.frames << " frames) in " << ms / 1000.0 << " seconds\n";
+    
+    if(mRecorder != NULL && mRecorder->isOpen()) mPipeline.getReceiver().setRecorder(mRecorder);
+    CRCPMotionAnalysis::LatencyTracer::get().setEnabled(true);
+    if(!mPipeline.getReceiver().start())
+        CI_LOG_E( "Error binding the mocap receiver to port " << LOCALPORT2 );
+}
+
+void FeverRhythmCycleMain::OfflineFeed::packet(const char *data, int size, double sessionSeconds)
+{
+    app->mPipeline.getReceiver().injectPacket(data, size, sessionSeconds);
+}
+
+void FeverRhythmCycleMain::OfflineFeed::frame(double sessionSeconds)
+{
+    app->seconds = sessionSeconds;
+    app->receiveMocapData();
+    app->updateMotionAnalysis(false); //just the local patch, would flood the remote laptop
+    frames++;
 }
 
 void FeverRhythmCycleMain::printKeyboardMenu()
@@ -706,6 +392,20 @@ void FeverRhythmCycleMain::printKeyboardMenu()
     std::cout << " 't' - Change to peak thresh mode\n";
     std::cout << " Peak thresh mode - '0'-'7' - Change bone\n";
     std::cout << " Peak thresh mode - Arrow up & down - adjust thresh\n";
+    std::cout << " 'a' - Print sample pool allocation stats\n";
+    std::cout << " 'b' - Run the buffer view benchmark (20 synthetic bones)\n";
+    std::cout << " 'k' - Run the forward kinematics benchmark (1, 8 & 32 skeletons)\n";
+    std::cout << " 'd' - Run the peak detection benchmark (1, 8 & 32 dancers, each bone alone vs. batched)\n";
+    std::cout << " 'q' - Print OSC receiver, queue & output stats\n";
+    std::cout << " 's' - Print the time each ugen, listener & the drawing take (also sent to the patch every 2 seconds)\n";
+    std::cout << " 'g' - Print the ugen graph -- the update order & the ugens shared\n";
+    std::cout << " 'e' - Predict the peak onsets a sample ahead/find them after the peak (default)\n";
+    std::cout << " 'o' - Add/stop adding the receive time of the packet to the end of the peak & note messages\n";
+    std::cout << " 'c' - Convert a saved OSC session to CSV (same name + .csv)\n";
+    std::cout << " 'f' - Re-analyse a saved OSC session as fast as possible (no network)\n";
+    std::cout << " Playing a session - '[' & ']' - half/double the rate (0.25x-20x)\n";
+    std::cout << " Playing a session - ',' & '.' - seek back/forward 10 seconds\n";
+    std::cout << " Playing a session - 'l' - set loop start, then loop end, then stop looping\n";
 
 
 
@@ -720,14 +420,14 @@ void FeverRhythmCycleMain::keyDown( KeyEvent event )
     //change peak thresh mode
     if( mChangePeakThresholdMode)
     {
-        std::string boneName = mPeople[0]->getBoneName((int) mWhichThresh);
+        std::string boneName = mPipeline.getPeople()[0]->getBoneName((int) mWhichThresh);
         if(event.getCode() == KeyEvent::KEY_DOWN)
         {
-            mPeople[0]->decreasePeakThresh(boneName);
+            mPipeline.getPeople()[0]->decreasePeakThresh(boneName);
         }
         else if (event.getCode() == KeyEvent::KEY_UP)
         {
-            mPeople[0]->increasePeakThresh(boneName);
+            mPipeline.getPeople()[0]->increasePeakThresh(boneName);
         }
         else
         {
@@ -735,7 +435,7 @@ void FeverRhythmCycleMain::keyDown( KeyEvent event )
             if(num > 0 && num <= 7)
             {
                 mWhichThresh = (CRCPMotionAnalysis::BodyPartSensor::BodyPart) num;
-                boneName = mPeople[0]->getBoneName((int) mWhichThresh);
+                boneName = mPipeline.getPeople()[0]->getBoneName((int) mWhichThresh);
                 std::cout << "Current Body Part to adjust peak thresh: " << boneName << std::endl;
                 
             }
@@ -748,17 +448,73 @@ void FeverRhythmCycleMain::keyDown( KeyEvent event )
     //choose a file to play OSC, if wanted.
     if(event.getChar() == 'p')
     {
-        fs::path filename = getOpenFilePath();
-        playOSC = new CRCPMotionAnalysis::PlayOSC(filename.c_str(), DESTHOST, LOCALPORT2, LOCALPORT + 10);
+        openPlayback();
+    }
+    if(mSessionPlayer != NULL)
+    {
+        sessionPlayerKeys(event);
     }
     if(event.getChar() == 'r')
     {
         std::cout << "Reset to default camera eyepoint coordinates\n";
         mEyePoint = mDefaultEyePoint;
     }
+    else if(event.getChar() == 'a')
+    {
+        CRCPMotionAnalysis::MocapDataPoolStats::print();
+    }
+    else if(event.getChar() == 'b')
+    {
+        CRCPMotionAnalysis::BufferViewBenchmark benchmark;
+        benchmark.run();
+    }
+    else if(event.getChar() == 'k')
+    {
+        CRCPMotionAnalysis::ForwardKinematicsBenchmark benchmark;
+        benchmark.run();
+    }
+    else if(event.getChar() == 'd')
+    {
+        CRCPMotionAnalysis::PeakDetectionBenchmark benchmark;
+        benchmark.run();
+    }
+    else if(event.getChar() == 'q')
+    {
+        mPipeline.getReceiver().printStats();
+        mOSCOut.printStats(); //from the sending thread
+    }
+    else if(event.getChar() == 's')
+    {
+        CRCPMotionAnalysis::ProfileReporter::print();
+    }
+    else if(event.getChar() == 'g')
+    {
+        mPipeline.getGraph().dump(std::cout);
+    }
+    else if(event.getChar() == 'e')
+    {
+        //a sample ahead, taking back the ones that don't come -- see lament-onsets for how the horizons compare
+        bool on = mPipeline.getPeakPrediction().horizon == 0;
+        mPipeline.setPeakPrediction( CRCPMotionAnalysis::PeakPrediction(on ? 1 : 0) );
+        std::cout << (on ? "Predicting the onsets a sample ahead\n" : "Finding the onsets after their peaks\n");
+    }
+    else if(event.getChar() == 'o')
+    {
+        CRCPMotionAnalysis::LatencyTracer &tracer = CRCPMotionAnalysis::LatencyTracer::get();
+        tracer.setAppendingOrigin( !tracer.isAppendingOrigin() );
+        std::cout << (tracer.isAppendingOrigin() ? "Adding" : "Not adding") << " the receive time to the peak & note messages\n";
+    }
+    else if(event.getChar() == 'c')
+    {
+        convertSessionToCSV();
+    }
+    else if(event.getChar() == 'f')
+    {
+        reanalyseSession();
+    }
     else if(event.getChar() == 't')
     {
-        if(mPeople.empty())
+        if(mPipeline.getPeople().empty())
         {
             std::cout << "No skeletons sending data. Cannot enter changing thresh mode./n";
             return;
@@ -769,7 +525,7 @@ void FeverRhythmCycleMain::keyDown( KeyEvent event )
         if(mChangePeakThresholdMode)
         {
             std::cout << "Changing to peak threshold mode...\n";
-            std::cout << "Currently changing thresh for " << mPeople[0]->getBoneName( (int) mWhichThresh );
+            std::cout << "Currently changing thresh for " << mPipeline.getPeople()[0]->getBoneName( (int) mWhichThresh );
         }
         else
         {
@@ -798,38 +554,47 @@ void FeverRhythmCycleMain::update()
     
     updateCamera();
     mShiftKeyDown = false;
+    CRCPMotionAnalysis::MocapDataPoolStats::endFrame();
     seconds = getElapsedSeconds(); //clock the time update is called to sync incoming messages
-    
-    //update sensors
-    for(int i=0; i<mSensors.size(); i++)
-    {
-        mSensors[i]->update(seconds);
-    }
-    //update all entities
-    for(int i=0; i<mPeople.size(); i++)
-    {
-        mPeople[i]->update(seconds);
-    }
-    
-    //send OSC from the entities -- after all are updated..
-    for(int i=0; i<mPeople.size(); i++)
-    {
-        std::vector<osc::Message> msgs = mPeople[i]->getOSC();
-        for(int i=0; i<msgs.size(); i++)
-        {
-            mSender.send(msgs[i]);
-            mRemoteLaptopSender.send(msgs[i]); //also send to the remote laptop
-        }
-    }
+    receiveMocapData();
+    updateMotionAnalysis();
     
     //update if playing from OSC saved to file
     if(playOSC != NULL)
     {
         playOSC->update(seconds);
     }
+    if(mSessionPlayer != NULL)
+    {
+        mSessionPlayer->update(seconds);
+    }
     
 }
 
+//updates the sensors & entities for the current time (seconds) & sends out their OSC
+void FeverRhythmCycleMain::updateMotionAnalysis(bool sendToRemote)
+{
+    std::vector<osc::Message> msgs;
+    mPipeline.update(seconds, msgs);
+    for(int i=0; i<msgs.size(); i++)
+        mOSCOut.add(msgs[i]);
+    
+    //the stats only go to the local patch -- the destinations' filters sort it out
+    std::vector<osc::Message> stats;
+    mProfileReporter->update(seconds, stats);
+    for(int i=0; i<stats.size(); i++)
+        mOSCOut.add(stats[i]);
+    
+    //the peaks are timed when they're actually sent, see LatencyTrace.h
+    const std::vector<CRCPMotionAnalysis::LatencyTrace> &traces = mPipeline.getPeakTraces();
+    for(int i=0; i<traces.size(); i++)
+        mOSCOut.addTrace(traces[i]);
+    
+    //the whole frame, bundled, w/one time tag -- queued for the sending thread, this never waits
+    mOSCOut.setEnabled(mRemoteLaptop, sendToRemote);
+    mOSCOut.sendFrame( CRCPMotionAnalysis::OSCBundleWriter::timeTagNow() );
+}
+
 void FeverRhythmCycleMain::drawGrid(float size=100.0f, float step=2.0f)
 {
     //draw 3d grid on the screen
@@ -891,6 +656,7 @@ void FeverRhythmCycleMain::updateCamera()
 //draw the entities
 void FeverRhythmCycleMain::draw()
 {
+    CRCPMotionAnalysis::ScopedProfile timer(mDrawProbe);
     
     gl::clear( Color( 0, 0, 0 ) );
     
@@ -920,9 +686,9 @@ void FeverRhythmCycleMain::draw()
 //    auto shader = gl::getStockShader( lambert );
 //    shader->bind();
     
-    for(int i=0; i<mPeople.size(); i++)
+    for(int i=0; i<mPipeline.getPeople().size(); i++)
     {
-        mPeople[i]->draw();
+        mPipeline.getPeople()[i]->draw();
     }
     
 }
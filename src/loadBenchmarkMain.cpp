@@ -0,0 +1,67 @@
+/***
+ Load benchmark
+
+ Stresses the analysis w/o a room full of dancers in suits: makes the OSC that N dancers' notch suits, some wiimotes &
+ a phone would send & runs it through the same decode -> sensors -> entities -> getOSC path as the app, in this process.
+ Reports the packets/s it keeps up with, the frame times & how many dancers it takes to miss the frame budget -- see
+ SyntheticMocapLoad & PipelineThroughputBenchmark in Benchmarks.h.
+
+ lament-loadbench [options]
+   -n, --max-dancers n   the most dancers to try -- 1, 2, 4 ... up to this (default: 64)
+   --notch-rate n        notch packets per second per dancer (default: 40)
+   --wiimotes n          how many wiimotes, up to 6 (default: 2)
+   --wii-rate n          wiimote packets per second (default: 100)
+   --no-phone            no phone sending syntien
+   --phone-rate n        syntien packets per second (default: 50)
+   --jitter ms           packets arrive up to this late (default: 5)
+   -r, --frame-rate n    analysis updates per second (default: 60, as the app)
+   -s, --seconds n       how long each dancer count is timed for (default: 10)
+   -b, --budget ms       a frame taking longer than this (p99) misses (default: 25)
+   -j, --threads n       worker threads for updating the dancers (default: one less than the cores, 0: none)
+
+ Built by the lament-loadbench target in the Xcode project, against the LamentAnalysis library w/MOTIONANALYSIS_HEADLESS
+ defined, like lament-offline.
+
+ ***/
+
+#include "MotionAnalysis.h" //the analysis & the osc addresses
+#include "Benchmarks.h"
+#include "Options.h"
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.define("n|max-dancers=i:64");
+    options.define("notch-rate=d:40");
+    options.define("wiimotes=i:2");
+    options.define("wii-rate=d:100");
+    options.define("no-phone=b");
+    options.define("phone-rate=d:50");
+    options.define("jitter=d:5");
+    options.define("r|frame-rate=d:60");
+    options.define("s|seconds=d:10");
+    options.define("b|budget=d:25");
+    options.define("j|threads=i:-1");
+    options.process(argc, argv);
+
+    if(options.getArgCount() != 0)
+    {
+        std::cout << "Usage: " << options.getCommand() << " [-n max-dancers] [--notch-rate n] [--wiimotes n] [--wii-rate n] [--no-phone] [--phone-rate n]"
+                  << " [--jitter ms] [-r frame-rate] [-s seconds] [-b budget-ms] [-j threads]\n";
+        return 1;
+    }
+
+    CRCPMotionAnalysis::PipelineThroughputBenchmark benchmark;
+    benchmark.notchRate = options.getDouble("notch-rate");
+    benchmark.wiimotes = options.getInteger("wiimotes");
+    benchmark.wiiRate = options.getDouble("wii-rate");
+    benchmark.phone = !options.getBoolean("no-phone");
+    benchmark.phoneRate = options.getDouble("phone-rate");
+    benchmark.jitter = options.getDouble("jitter") / 1000.0;
+    benchmark.frameRate = std::max(1.0, options.getDouble("frame-rate"));
+    benchmark.seconds = std::max(0.1, options.getDouble("seconds"));
+    benchmark.threads = options.getInteger("threads");
+
+    benchmark.sweep(std::max(1, options.getInteger("max-dancers")), options.getDouble("budget"));
+    return 0;
+}
@@ -0,0 +1,71 @@
+/***
+ Offline analysis
+
+ Runs the motion analysis on a recorded session log w/o the app's window -- see OfflineAnalysis.h.
+
+ lament-offline [options] session.lmnt
+   -o, --output file     the session log to write the analysis' OSC to (default: session.lmnt.out)
+   --csv                 also convert the output to CSV (output + .csv), like SaveOSC wrote
+   -r, --frame-rate n    analysis updates per second of the session (default: 60, as the app)
+   --start s, --end s    only analyse from/to these seconds into the session
+   --stats               print the receiver's & the analysis' stats when done
+   --graph               print the ugen graph when done -- the order, what waits for what & the ugens shared
+   --predict n           fire the onsets before their peaks, predicting n samples ahead (default: 0, off) -- see FindPeaks
+   --no-retract          w/--predict, keep the onsets whose peaks don't come
+   -j, --threads n       worker threads for updating the dancers (default: one less than the cores, 0: none)
+
+ Built by the lament-offline target in the Xcode project, against the LamentAnalysis library (the OSC block & the
+ other sources in xcode/) w/MOTIONANALYSIS_HEADLESS defined -- it doesn't use cinder::app or GL, so it runs w/o a
+ display.
+
+ ***/
+
+#include "MotionAnalysis.h" //the analysis & the osc addresses
+#include "Options.h"
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.define("o|output=s:");
+    options.define("csv=b");
+    options.define("r|frame-rate=d:60");
+    options.define("start=d:-1");
+    options.define("end=d:-1");
+    options.define("stats=b");
+    options.define("graph=b");
+    options.define("predict=i:0");
+    options.define("no-retract=b");
+    options.define("j|threads=i:-1");
+    options.process(argc, argv);
+
+    if(options.getArgCount() != 1)
+    {
+        std::cout << "Usage: " << options.getCommand() << " [-o output] [--csv] [-r frame-rate] [--start seconds] [--end seconds] [--stats] [--graph] [--predict n] [--no-retract] [-j threads] session.lmnt\n";
+        return 1;
+    }
+
+    std::string sessionFilename = options.getArg(1);
+    std::string outputFilename = options.getString("output");
+    if(outputFilename.empty()) outputFilename = sessionFilename + ".out";
+
+    if(!CRCPMotionAnalysis::MappedSessionFile::isSessionLog(sessionFilename))
+    {
+        std::cout << sessionFilename << " is not a session log. Old CSV recordings can be played to the app w/'p'.\n";
+        return 1;
+    }
+
+    CRCPMotionAnalysis::OfflineAnalysisEngine engine(sessionFilename, outputFilename, options.getDouble("frame-rate"), options.getInteger("threads"));
+    if(!engine.isValid()) return 1;
+    engine.getPipeline().setPeakPrediction( CRCPMotionAnalysis::PeakPrediction(options.getInteger("predict"), !options.getBoolean("no-retract")) );
+
+    engine.run(options.getDouble("start"), options.getDouble("end"));
+    std::cout << "Wrote the analysis of " << sessionFilename << " to " << outputFilename << "\n";
+
+    if(options.getBoolean("stats")) engine.printStats();
+    if(options.getBoolean("graph")) engine.getPipeline().getGraph().dump(std::cout);
+
+    if(options.getBoolean("csv") && !CRCPMotionAnalysis::SessionRecorder::convertToCSV(outputFilename, outputFilename + ".csv"))
+        return 1;
+
+    return 0;
+}
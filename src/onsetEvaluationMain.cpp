@@ -0,0 +1,70 @@
+/***
+ Onset evaluation
+
+ Replays a recorded session through the analysis w/FindPeaks finding each peak once it's happened (as the app does),
+ then again predicting the peaks a few samples ahead, & reports how much sooner the onsets go out against the
+ precision & recall -- see OnsetEvaluation.h.
+
+ lament-onsets [options] session.lmnt
+   --horizons list       the prediction horizons to try, in samples (default: 1,2,3)
+   --no-retract          keep the predicted onsets whose peaks don't come
+   --tolerance ms        how far a predicted onset can be from its peak & still match (default: 100)
+   --thresh n            the peak threshold for every body part (default: their own)
+   -r, --frame-rate n    analysis updates per second of the session (default: 60, as the app)
+   --start s, --end s    only from/to these seconds into the session
+   -j, --threads n       worker threads for updating the dancers (default: one less than the cores, 0: none)
+
+ Built by the lament-onsets target in the Xcode project, against the LamentAnalysis library w/MOTIONANALYSIS_HEADLESS
+ defined, like lament-offline.
+
+ ***/
+
+#include "MotionAnalysis.h" //the analysis & the osc addresses
+#include "OnsetEvaluation.h"
+#include "Options.h"
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.define("horizons=s:1,2,3");
+    options.define("no-retract=b");
+    options.define("tolerance=d:100");
+    options.define("thresh=d:-1");
+    options.define("r|frame-rate=d:60");
+    options.define("start=d:-1");
+    options.define("end=d:-1");
+    options.define("j|threads=i:-1");
+    options.process(argc, argv);
+
+    if(options.getArgCount() != 1)
+    {
+        std::cout << "Usage: " << options.getCommand() << " [--horizons 1,2,3] [--no-retract] [--tolerance ms] [--thresh n] [-r frame-rate]"
+                  << " [--start seconds] [--end seconds] [-j threads] session.lmnt\n";
+        return 1;
+    }
+
+    std::string sessionFilename = options.getArg(1);
+    if(!CRCPMotionAnalysis::MappedSessionFile::isSessionLog(sessionFilename))
+    {
+        std::cout << sessionFilename << " is not a session log.\n";
+        return 1;
+    }
+
+    std::vector<int> horizons;
+    std::stringstream list(options.getString("horizons"));
+    std::string h;
+    while(std::getline(list, h, ','))
+    {
+        if(atoi(h.c_str()) > 0) horizons.push_back(atoi(h.c_str()));
+    }
+
+    CRCPMotionAnalysis::OnsetEvaluation evaluation(sessionFilename);
+    evaluation.frameRate = options.getDouble("frame-rate");
+    evaluation.thresh = options.getDouble("thresh");
+    evaluation.tolerance = options.getDouble("tolerance") / 1000.0;
+    evaluation.start = options.getDouble("start");
+    evaluation.end = options.getDouble("end");
+    evaluation.threads = options.getInteger("threads");
+
+    return evaluation.run(horizons, !options.getBoolean("no-retract")) ? 0 : 1;
+}
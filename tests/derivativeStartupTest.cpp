@@ -0,0 +1,137 @@
+/***
+ Derivative startup test
+
+ The visualizers used to scale the averaging filter's samples in place once it had 25 of them (scaleAccel()), so the
+ derivative reading the same samples jumped from then on. Runs the same synthetic bone through two chains from
+ BodyPartSensor::addSensor() -- InputSignal -> AveragingFilter -> Derivative, & the same w/the visualizers reading the
+ averaging filter, updated before the derivative -- & checks that the derivatives agree sample for sample & that the
+ visualizers leave the filter's samples as they were. The filter's samples are on the 0..1 scale already, so scaling
+ them in place wouldn't change their values, only mark them scaled -- that's checked too.
+
+ lament-derivative-test   (returns 0 if it passes)
+
+ Built by the lament-derivative-test target in the Xcode project, against the LamentAnalysis library
+ w/MOTIONANALYSIS_HEADLESS defined.
+
+ ***/
+
+#include "MotionAnalysis.h"
+#include "Benchmarks.h" //SyntheticBoneSource
+
+using namespace CRCPMotionAnalysis;
+
+//how much it has to draw -- 0 until it's had enough samples to look at them
+class VisualizerPoints : public MocapDataVisualizer
+{
+public:
+    VisualizerPoints(OutputSignalAnalysis *s1) : MocapDataVisualizer(s1) {};
+    int getPointCount() { return points.size(); };
+};
+
+//a chain & the sensor it reads
+class DerivativeChain
+{
+public:
+    SensorData sensor;
+    SyntheticBoneSource source;
+    InputSignal input;
+    AveragingFilter avg;
+    Derivative derivative;
+
+    DerivativeChain() : sensor("LeftHand", 1, MocapDeviceData::NOTCH, MocapDeviceData::UNSPECIFIED), source(&sensor, 3), input(1),
+        avg(&input, 3, 16, 1, "LeftHand"), derivative(&avg, 16, 1, "LeftHand")
+    {
+        input.setInput(&sensor);
+    };
+
+    void addSamples(int count, double seconds)
+    {
+        source.addSamples(count, seconds);
+        sensor.update(seconds);
+        input.update(seconds);
+        avg.update(seconds);
+    };
+};
+
+static const int CHECKED[] = { MocapDeviceData::DataIndices::ACCELX, MocapDeviceData::DataIndices::ACCELY, MocapDeviceData::DataIndices::ACCELZ,
+    MocapDeviceData::DataIndices::BONEANGLE_TILT, MocapDeviceData::DataIndices::BONEANGLE_ROTATE, MocapDeviceData::DataIndices::BONEANGLE_LATERAL };
+static const int CHECKED_COUNT = sizeof(CHECKED) / sizeof(CHECKED[0]);
+
+int main(int argc, char **argv)
+{
+    const int FRAMES = 120; //well past the 25 samples the visualizers wait for
+
+    DerivativeChain alone, visualized;
+    VisualizerPoints visualizer(&visualized.avg);
+    MocapDataVisualizerNotchBonePosition boneVisualizer(&visualized.avg);
+
+    int failures = 0, compared = 0, firstVisualized = -1;
+    std::vector<double> before;
+    for(int f=0; f<FRAMES && failures < 10; f++)
+    {
+        double seconds = f / 60.0;
+        int count = 1 + f % 3; //as the packets come in, a few samples a frame
+        alone.addSamples(count, seconds);
+        visualized.addSamples(count, seconds);
+
+        //what the visualizers will read
+        MocapBufferView avg = visualized.avg.getBuffer();
+        before.clear();
+        for(int i=0; i<avg.size(); i++)
+            for(int j=0; j<CHECKED_COUNT; j++)
+                before.push_back( avg[i]->getData(CHECKED[j]) );
+
+        visualizer.update(seconds);
+        boneVisualizer.update(seconds);
+        if( firstVisualized < 0 && visualizer.getPointCount() > 0 ) firstVisualized = f;
+
+        for(int i=0, k=0; i<avg.size(); i++)
+        {
+            if( avg[i]->isScaled() )
+            {
+                std::cout << "frame " << f << ": the visualizers scaled the averaging filter's sample " << i << " in place\n";
+                failures++;
+            }
+            for(int j=0; j<CHECKED_COUNT; j++, k++)
+            {
+                if( avg[i]->getData(CHECKED[j]) == before[k] ) continue;
+                std::cout << "frame " << f << ": the visualizers changed the averaging filter's sample " << i << ", index " << CHECKED[j]
+                          << " from " << before[k] << " to " << avg[i]->getData(CHECKED[j]) << "\n";
+                failures++;
+            }
+        }
+
+        alone.derivative.update(seconds);
+        visualized.derivative.update(seconds);
+
+        MocapBufferView a = alone.derivative.getBuffer(), v = visualized.derivative.getBuffer();
+        if( a.size() != v.size() || a.getNewSampleCount() != v.getNewSampleCount() )
+        {
+            std::cout << "frame " << f << ": the derivatives have " << a.size() << " & " << v.size() << " samples\n";
+            failures++;
+            continue;
+        }
+        for(int i=a.size()-a.getNewSampleCount(); i<a.size(); i++)
+        {
+            for(int j=0; j<CHECKED_COUNT; j++)
+            {
+                if( a[i]->getData(CHECKED[j]) != v[i]->getData(CHECKED[j]) )
+                {
+                    std::cout << "frame " << f << ": the derivative jumped to " << v[i]->getData(CHECKED[j]) << " instead of "
+                              << a[i]->getData(CHECKED[j]) << ", index " << CHECKED[j] << "\n";
+                    failures++;
+                }
+            }
+            compared++;
+        }
+    }
+
+    if( firstVisualized < 0 )
+    {
+        std::cout << "The visualizers never had enough samples to read -- nothing was tested\n";
+        return 1;
+    }
+    std::cout << compared << " derivative samples compared, the visualizers reading from frame " << firstVisualized << ": "
+              << (failures ? "FAILED" : "passed") << "\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/***
+ OSC packet test
+
+ Malformed packets, as anyone on the LAN could send -- the argument & bundle element sizes come from the packet, so
+ reading one must never go past its end. Each packet is read w/oscForEachMessage() & toCinderMessage(), as SaveOSC &
+ the session converter do, & given to a MocapReceiver (injectPacket()), as the receiving thread does. A well-formed one
+ w/a blob checks that the blob is still skipped over. Best run w/AddressSanitizer on, which catches the reads past the
+ end that don't crash.
+
+ lament-osc-test   (returns 0 if it passes)
+
+ Built by the lament-osc-test target in the Xcode project, against the LamentAnalysis library
+ w/MOTIONANALYSIS_HEADLESS defined.
+
+ ***/
+
+#include "MotionAnalysis.h"
+
+using namespace CRCPMotionAnalysis;
+
+//a packet, byte by byte
+class PacketBytes
+{
+public:
+    std::vector<char> bytes;
+
+    PacketBytes &string(const char *s)
+    {
+        bytes.insert(bytes.end(), s, s + strlen(s));
+        bytes.resize((bytes.size() + 4) & ~size_t(3), '\0');
+        return *this;
+    };
+
+    PacketBytes &uint32(uint32_t n)
+    {
+        bytes.push_back( char(n >> 24) );
+        bytes.push_back( char(n >> 16) );
+        bytes.push_back( char(n >> 8) );
+        bytes.push_back( char(n) );
+        return *this;
+    };
+
+    PacketBytes &floatArg(float f)
+    {
+        uint32_t bits;
+        memcpy(&bits, &f, 4);
+        return uint32(bits);
+    };
+};
+
+//reads every argument of every message, as toCinderMessage() does
+class ReadEverything
+{
+public:
+    int messages, args;
+    bool valid;
+
+    ReadEverything() : messages(0), args(0), valid(true) {};
+
+    void operator()(const OSCMessageReader &msg)
+    {
+        messages++;
+        ci::osc::Message m = msg.toCinderMessage();
+        OSCArgReader arg = msg.getArgs();
+        while( !arg.atEnd() )
+        {
+            arg.skip();
+            if( arg.isValid() ) args++;
+        }
+        valid = valid && arg.isValid();
+    };
+};
+
+static int failures = 0;
+
+//whether the packet reads as valid (parsed & every argument within it) -- & it mustn't crash the receiver either
+static void check(const char *what, const PacketBytes &packet, bool shouldBeValid, int shouldHaveArgs = -1)
+{
+    ReadEverything reader;
+    bool parsed = oscForEachMessage(packet.bytes.data(), int(packet.bytes.size()), reader);
+    bool valid = parsed && reader.valid;
+
+    MocapReceiver receiver(0); //never started -- injectPacket() decodes on this thread
+    receiver.injectPacket(packet.bytes.data(), int(packet.bytes.size()), 1.0);
+
+    bool ok = valid == shouldBeValid && ( shouldHaveArgs < 0 || reader.args == shouldHaveArgs );
+    std::cout << (ok ? "  ok      " : "  FAILED  ") << what << ": " << (valid ? "valid" : "malformed") << ", " << reader.args << " args, "
+              << receiver.getMalformedPacketCount() << " malformed by the receiver\n";
+    if( !ok ) failures++;
+}
+
+int main(int argc, char **argv)
+{
+    std::cout << "OSC packet test\n";
+
+    //a blob w/its length & padding, then a float
+    check("blob then float", PacketBytes().string("/x").string(",bf").uint32(5).string("abcde").floatArg(1), true, 2);
+
+    //the length would take it back before the packet
+    check("blob length 0x80000000", PacketBytes().string("/x").string(",bf").uint32(0x80000000), false);
+    check("blob length 0xFFFFFFFF", PacketBytes().string("/x").string(",bf").uint32(0xFFFFFFFF).floatArg(1), false);
+    check("blob longer than the packet", PacketBytes().string("/x").string(",b").uint32(64).floatArg(1), false);
+    check("blob w/o its length", PacketBytes().string("/x").string(",b"), false);
+
+    //fixed size arguments cut short
+    check("float w/o its bytes", PacketBytes().string("/x").string(",ff").floatArg(1), false);
+    check("double w/o its bytes", PacketBytes().string("/x").string(",d").uint32(0), false);
+    check("string w/o its null", PacketBytes().string("/x").string(",s").uint32(0x41414141), false);
+
+    //the notch message, w/a bad blob for the frame -- the receiving thread skips over it
+    check("notch frame blob length 0x80000000", PacketBytes().string(NOTCH_MESSAGE).string(",ssbsf").string("dancer").string("iOS")
+          .uint32(0x80000000).string("Root").floatArg(1), false);
+
+    //bundle elements that don't fit
+    check("bundle element size 0xFFFFFFFF", PacketBytes().string("#bundle").uint32(0).uint32(1).uint32(0xFFFFFFFF).string("/x").string(",f").floatArg(1), false);
+    check("bundle element size 0x7FFFFFFC", PacketBytes().string("#bundle").uint32(0).uint32(1).uint32(0x7FFFFFFC).string("/x").string(",f").floatArg(1), false);
+
+    std::cout << (failures ? "FAILED" : "passed") << "\n";
+    return failures ? 1 : 0;
+}
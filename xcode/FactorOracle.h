@@ -398,7 +398,7 @@ public:
         //if midi doesn't exist here choose at random.
         if(genIndex <= -1)
         {
-            genIndex = (int) std::round((((double) std::rand()) / ((double) RAND_MAX)) * oracle.transitionSize());
+            genIndex = (int) std::round(chance.next() * oracle.transitionSize());
         }
     }
     
@@ -423,7 +423,7 @@ public:
         std::vector<int> alphaIndex;
         
         //weight heavily towards the next choice -- could still end up on the next choice
-        double choose =((double) std::rand()) / ((double) RAND_MAX);
+        double choose =chance.next();
         if ( choose < choiceBetweenNearOrFar )
         {
             genIndex++;
@@ -440,7 +440,7 @@ public:
         }
         
         //for now give each possibility the same weight
-        double prob = ((double) std::rand()) / ((double) RAND_MAX);
+        double prob = chance.next();
         double i = 0;
         bool found = false;
         while( !found && i<possibilities.size())
@@ -474,7 +474,7 @@ public:
         if (oracle.getSuffixLink(genIndex) == 0 || genIndex == 0)
             probOfChoice   =  1;
         
-        double choose =((double) std::rand()) / ((double) RAND_MAX);
+        double choose =chance.next();
         if(choose > probOfChoice)
         {
             //choose a suffix backwards transition from oracle.sp[]
@@ -47,6 +47,7 @@ namespace CRCPMotionAnalysis {
         int maxNotesGenerated;
         
         float sparseShortNoteCutOff;
+        MelodyRandom chance;
 
         
     public:
@@ -98,6 +99,14 @@ namespace CRCPMotionAnalysis {
                 std::cerr << "MelodyGenerator: Cannot use algorithm! It has not been trained!";
         }
         
+        //seeds this & the algorithms added so far, each w/its own numbers
+        void seed(unsigned int s)
+        {
+            chance.seed(s);
+            for(int i=0; i<generators.size(); i++)
+                generators[i]->seed(s + i + 1);
+        }
+        
         virtual std::vector<ci::osc::Message> getOSC()
         {
             //probably do nothing here... we'll see
@@ -134,7 +143,7 @@ namespace CRCPMotionAnalysis {
             }
             else
             {
-                notesPerUpdate = (int) std::round((((double) std::rand()) / ((double) RAND_MAX) ) * (maxNotesGenerated * (double)bs/(double)bsMax * 0.5 )) +
+                notesPerUpdate = (int) std::round(chance.next() * (maxNotesGenerated * (double)bs/(double)bsMax * 0.5 )) +
                 std::round(maxNotesGenerated * (double)bs/(double)bsMax * 0.5);
                 if(notesPerUpdate == 0) notesPerUpdate = 1; //always output at least one note.
             }
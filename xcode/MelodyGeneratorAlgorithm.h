@@ -8,13 +8,36 @@
 
 #ifndef MelodyGeneratorAlgorithm_h
 #define MelodyGeneratorAlgorithm_h
+#include <random>
+
 namespace CRCPMotionAnalysis {
     
+    //random numbers for one generator -- instead of std::rand(), which all the dancers' generators would share while they
+    //are updated on different threads, making the notes depend on which thread got there first
+    class MelodyRandom
+    {
+    protected:
+        std::minstd_rand gen;
+    public:
+        //w/o this every generator starts from the same numbers -- & every dancer plays the same melody
+        void seed(unsigned int s)
+        {
+            gen.seed(s);
+        };
+        
+        //0 to 1, like std::rand()/RAND_MAX
+        double next()
+        {
+            return double(gen() - gen.min()) / double(gen.max() - gen.min());
+        };
+    };
+    
     class MelodyGeneratorAlgorithm
     {
     private:
         bool trained;
     protected:
+        MelodyRandom chance;
         float bpm;
         double tpb;
         std::string dbfile;
@@ -23,6 +46,7 @@ namespace CRCPMotionAnalysis {
         {
             trained = false;
         };
+        virtual ~MelodyGeneratorAlgorithm(){}; //BodyPartSensor deletes its oracles
     
         virtual void train(std::string _dbfileName, int track = 1)
         {
@@ -54,6 +78,11 @@ namespace CRCPMotionAnalysis {
         {
             return tpb;
         }
+        
+        void seed(unsigned int s)
+        {
+            chance.seed(s);
+        }
 
     };
     
@@ -33,6 +33,8 @@ public:
         minVal = 0;
     };
     
+    virtual ~MotionAnalysisData(){}; //MotionDataOutput deletes them through this
+    
     virtual MotionAnalysisDataType getType()
     {
         return Generic ;
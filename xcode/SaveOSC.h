@@ -83,23 +83,21 @@ namespace CRCPMotionAnalysis {
         ReadCSV csvFile;
         float lastTime;
         
-        ci::osc::SenderUdp  mSender;
+        OSCFanOut mSender; //sends on its own thread, so update() doesn't wait on the network -- see OSCFanOut.h
         std::vector<OSCMessageTimeStamp> msgs;
 
     public:
                                                                                                    // LOCALPORT, DESTHOST, DESTPORT
-        PlayOSC( std::string _fname, std::string desthost, int destport, int localport)  : csvFile(filename), mSender(localport, desthost, destport)
+        PlayOSC( std::string _fname, std::string desthost, int destport, int localport)  : csvFile(filename)
         {
             filename = _fname;
             lastTime = 0;
             csvFile.init(filename);
             
-            try{
-                mSender.bind();
-            }
-            catch( ci::osc::Exception &e)
+            mSender.addDestination("PlayOSC", localport, desthost, destport);
+            if( !mSender.start() )
             {
-                CI_LOG_E( "PlayOSC: Error binding" << e.what() << " val: " << e.value() );
+                CI_LOG_E( "PlayOSC: Error binding to port " << localport );
             }
         }
         
@@ -143,20 +141,25 @@ namespace CRCPMotionAnalysis {
         }
         
         //sends buffered OSC with a timestamp >= time in seconds
+        //one pass, keeping the rest in order -- erasing each sent message from the middle was quadratic w/a backlog
         void sendBufferedOSC(float seconds)
         {
-            for(int i=msgs.size()-1; i>=0; i--) //TODO: make more efficient by using while loop
+            int kept = 0;
+            for(int i=0; i<msgs.size(); i++)
             {
-//                std::cout << msgs[i].timeStamp ;
                 if(msgs[i].timeStamp >= seconds)
                 {
 //                    std::cout << "sending... " << msgs[i].msg.getAddress() << "\n";
-
-                    mSender.send(msgs[i].msg);
-                    msgs.erase(msgs.begin() + i);
+                    mSender.add(msgs[i].msg);
+                }
+                else
+                {
+                    if(kept != i) msgs[kept] = msgs[i];
+                    kept++;
                 }
-//                else std::cout << "not sending...\n";
             }
+            msgs.resize(kept, OSCMessageTimeStamp(0, ci::osc::Message()));
+            mSender.sendFrame( OSCBundleWriter::timeTagNow() );
         }
         
         //reads through file, loads OSC messages, and sends the OSC according to the input time in seconds.